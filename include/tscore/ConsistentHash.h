@@ -25,6 +25,7 @@
 #include <cstdint>
 #include <iostream>
 #include <map>
+#include <vector>
 
 /*
   Helper class to be extended to make ring nodes.
@@ -37,7 +38,23 @@ struct ATSConsistentHashNode {
 
 std::ostream &operator<<(std::ostream &os, ATSConsistentHashNode &thing);
 
-typedef std::map<uint64_t, ATSConsistentHashNode *>::iterator ATSConsistentHashIter;
+/*
+  How the ring is stored. Both map a key to the same node.
+
+  MAP keeps the ring in a std::map. SORTED_ARRAY keeps it in a vector sorted by hash, which is
+  searched with a binary search over contiguous memory rather than by chasing tree pointers.
+ */
+
+enum class ATSConsistentHashRing { MAP, SORTED_ARRAY };
+
+/*
+  A position on the ring, saved between lookups. Only the member for the ring's storage is used.
+ */
+
+struct ATSConsistentHashIter {
+  std::map<uint64_t, ATSConsistentHashNode *>::iterator node;
+  size_t idx = 0;
+};
 
 /*
   TSConsistentHash requires a TSHash64 object
@@ -46,7 +63,7 @@ typedef std::map<uint64_t, ATSConsistentHashNode *>::iterator ATSConsistentHashI
  */
 
 struct ATSConsistentHash {
-  ATSConsistentHash(int r = 1024, ATSHash64 *h = nullptr);
+  ATSConsistentHash(int r = 1024, ATSHash64 *h = nullptr, ATSConsistentHashRing ring = ATSConsistentHashRing::MAP);
   void insert(ATSConsistentHashNode *node, float weight = 1.0, ATSHash64 *h = nullptr);
   ATSConsistentHashNode *lookup(const char *url = nullptr, ATSConsistentHashIter *i = nullptr, bool *w = nullptr,
                                 ATSHash64 *h = nullptr);
@@ -56,7 +73,17 @@ struct ATSConsistentHash {
   ~ATSConsistentHash();
 
 private:
+  typedef std::pair<uint64_t, ATSConsistentHashNode *> Point;
+
+  bool at_end(const ATSConsistentHashIter &iter) const;
+  void seek(ATSConsistentHashIter &iter, uint64_t hashval);
+  void rewind(ATSConsistentHashIter &iter);
+  void next(ATSConsistentHashIter &iter);
+  ATSConsistentHashNode *node(const ATSConsistentHashIter &iter) const;
+
   int replicas;
   ATSHash64 *hash;
+  ATSConsistentHashRing ring;
   std::map<uint64_t, ATSConsistentHashNode *> NodeMap;
+  std::vector<Point> NodeArray; ///< Sorted by hash, with the first node inserted at a hash kept, as @c NodeMap does.
 };
@@ -145,22 +145,28 @@ CryptoContextBase::finalize(CryptoHash *hash)
 class CryptoContext : public CryptoContextBase
 {
 public:
+  /// What type of hash we really are.
+  /// @note These values are stored in the cache stripe header, do not renumber.
+  enum HashType {
+    UNSPECIFIED = 0,
+#if TS_ENABLE_FIPS == 0
+    MD5     = 1,
+    MMH     = 2,
+    SIPHASH = 4,
+#endif
+    SHA256 = 3,
+  };
+  static HashType Setting;
+
+  /// Construct a context of the global @c Setting type.
   CryptoContext();
+  /// Construct a context of a specific @a type.
+  explicit CryptoContext(HashType type);
   /// Update the hash with @a data of @a length bytes.
   bool update(void const *data, int length) override;
   /// Finalize and extract the @a hash.
   bool finalize(CryptoHash &hash) override;
 
-  enum HashType {
-    UNSPECIFIED,
-#if TS_ENABLE_FIPS == 0
-    MD5,
-    MMH,
-#endif
-    SHA256,
-  }; ///< What type of hash we really are.
-  static HashType Setting;
-
   /// Size of storage for placement @c new of hashing context.
   static size_t const OBJ_SIZE = 256;
 
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "tscore/Hash.h"
+#include "tscore/CryptoHash.h"
 #include <cstdint>
 
 /*
@@ -53,3 +54,29 @@ private:
   std::size_t total_len         = 0;
   bool finalized                = false;
 };
+
+/*
+  SipHash-2-4 with 128 bit output, as a cache key hash.
+
+  This is not a cryptographic digest but is much cheaper than MD5 and has a
+  full 128 bit output, which is what the cache needs for keys. It always uses
+  a zero key so that the hash of a URL is the same across restarts.
+ */
+class SipHashContext : public ats::CryptoContextBase
+{
+public:
+  SipHashContext();
+  /// Update the hash with @a data of @a length bytes.
+  bool update(void const *data, int length) override;
+  /// Finalize and extract the @a hash.
+  bool finalize(CryptoHash &hash) override;
+
+private:
+  unsigned char block_buffer[8] = {0};
+  std::uint8_t block_buffer_len = 0;
+  std::uint64_t v0              = 0;
+  std::uint64_t v1              = 0;
+  std::uint64_t v2              = 0;
+  std::uint64_t v3              = 0;
+  std::size_t total_len         = 0;
+};
@@ -80,6 +80,7 @@ int cache_config_enable_checksum               = 0;
 int cache_config_alt_rewrite_max_size          = 4096;
 int cache_config_read_while_writer             = 0;
 int cache_config_mutex_retry_delay             = 2;
+int cache_config_url_hash_algorithm            = 0;
 int cache_read_while_writer_retry_delay        = 50;
 int cache_config_read_while_writer_max_retries = 10;
 static int enable_cache_empty_http_doc         = 0;
@@ -285,6 +286,29 @@ update_cache_config(const char * /* name ATS_UNUSED */, RecDataT /* data_type AT
   return 0;
 }
 
+/// Normalize the URL hash recorded in a stripe header.
+static CryptoContext::HashType
+cache_url_hash_type(uint32_t url_hash)
+{
+#if TS_ENABLE_FIPS == 0
+  // Stripes from before the URL hash was recorded are always MD5.
+  return url_hash == CryptoContext::SIPHASH ? CryptoContext::SIPHASH : CryptoContext::MD5;
+#else
+  return CryptoContext::SHA256;
+#endif
+}
+
+/// The URL hash to stamp on newly cleared stripes.
+static CryptoContext::HashType
+cache_url_hash_type_config()
+{
+#if TS_ENABLE_FIPS == 0
+  return cache_config_url_hash_algorithm == 1 ? CryptoContext::SIPHASH : CryptoContext::MD5;
+#else
+  return CryptoContext::SHA256;
+#endif
+}
+
 CacheVC::CacheVC() : alternate_index(CACHE_ALT_INDEX_DEFAULT)
 {
   size_to_init = sizeof(CacheVC) - (size_t) & ((CacheVC *)nullptr)->vio;
@@ -892,6 +916,25 @@ CacheProcessor::cacheInitialized()
     }
   }
 
+  // Select the hash for cache keys. Stripes cleared in this start up were stamped with the configured
+  // hash. Any stripe with a different hash was read from disk and its objects are keyed with that hash,
+  // so it has to stay in use, and is stamped on every stripe, until the cache is cleared.
+  cacheProcessor.url_hash_type = cache_url_hash_type_config();
+  for (i = 0; i < gnvol; i++) {
+    CryptoContext::HashType stripe_hash = cache_url_hash_type(gvol[i]->header->url_hash);
+    if (stripe_hash != cacheProcessor.url_hash_type) {
+      Warning("cache stripe '%s' uses a different URL hash than proxy.config.cache.url_hash_algorithm, "
+              "continuing with the existing hash until the cache is cleared",
+              gvol[i]->hash_text.get());
+      cacheProcessor.url_hash_type = stripe_hash;
+      break;
+    }
+  }
+  for (i = 0; i < gnvol; i++) {
+    gvol[i]->header->url_hash = cacheProcessor.url_hash_type;
+  }
+  Debug("cache_init", "CacheProcessor::cacheInitialized - URL hash type %d", cacheProcessor.url_hash_type);
+
   // Update stripe version data.
   if (gnvol) { // start with whatever the first stripe is.
     cacheProcessor.min_stripe_version = cacheProcessor.max_stripe_version = gvol[0]->header->version;
@@ -1201,6 +1244,7 @@ vol_clear_init(Vol *d)
   d->header->cycle                                        = 0;
   d->header->create_time                                  = time(nullptr);
   d->header->dirty                                        = 0;
+  d->header->url_hash                                     = cache_url_hash_type_config();
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
   *d->footer                              = *d->header;
 }
@@ -3191,6 +3235,9 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_mutex_retry_delay, "proxy.config.cache.mutex_retry_delay");
   Debug("cache_init", "proxy.config.cache.mutex_retry_delay = %dms", cache_config_mutex_retry_delay);
 
+  REC_EstablishStaticConfigInt32(cache_config_url_hash_algorithm, "proxy.config.cache.url_hash_algorithm");
+  Debug("cache_init", "proxy.config.cache.url_hash_algorithm = %d", cache_config_url_hash_algorithm);
+
   REC_EstablishStaticConfigInt32(cache_config_read_while_writer_max_retries, "proxy.config.cache.read_while_writer.max_retries");
   Debug("cache_init", "proxy.config.cache.read_while_writer.max_retries = %d", cache_config_read_while_writer_max_retries);
 
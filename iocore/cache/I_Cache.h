@@ -158,6 +158,8 @@ struct CacheProcessor : public Processor {
 
   ts::VersionNumber min_stripe_version;
   ts::VersionNumber max_stripe_version;
+  /// Hash used for cache keys by the stripes.
+  CryptoContext::HashType url_hash_type = CryptoContext::UNSPECIFIED;
 
   CALLBACK_FUNC cb_after_init;
   int wait_for_cache;
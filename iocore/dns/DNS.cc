@@ -593,10 +593,11 @@ DNSHandler::startEvent_sdns(int /* event ATS_UNUSED */, Event *e)
 }
 
 static inline int
-_ink_res_mkquery(ink_res_state res, char *qname, int qtype, unsigned char *buffer, bool over_tcp = false)
+_ink_res_mkquery(ink_res_state res, char *qname, int qtype, unsigned char *buffer, bool over_tcp = false,
+                 int buflen = MAX_DNS_PACKET_LEN)
 {
   int offset = over_tcp ? tcp_data_length_offset : 0;
-  int r      = ink_res_mkquery(res, QUERY, qname, C_IN, qtype, nullptr, 0, nullptr, buffer + offset, MAX_DNS_PACKET_LEN);
+  int r      = ink_res_mkquery(res, QUERY, qname, C_IN, qtype, nullptr, 0, nullptr, buffer + offset, buflen - offset);
   if (over_tcp) {
     NS_PUT16(r, buffer);
   }
@@ -795,11 +796,16 @@ DNSHandler::recv_dns(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   DNSConnection *dnsc = nullptr;
   ip_text_buffer ipbuff1, ipbuff2;
   Ptr<HostEnt> buf;
+  // UDP responses are read in batches, then handled one at a time.
+  IpEndpoint from_ip[DNS_BATCH_SIZE];
+  struct iovec iov[DNS_BATCH_SIZE];
+  struct mmsghdr msgs[DNS_BATCH_SIZE];
   while ((dnsc = (DNSConnection *)triggered.dequeue())) {
+    int n_read = 0; // responses in the current batch
+    int next   = 0; // next response in the batch to handle
     while (true) {
       int res;
-      IpEndpoint from_ip;
-      socklen_t from_length = sizeof(from_ip);
+      int k;
       if (dnsc->opt._use_tcp) {
         if (dnsc->tcp_data.buf_ptr == nullptr) {
           dnsc->tcp_data.buf_ptr = make_ptr(dnsBufAllocator.alloc());
@@ -847,34 +853,48 @@ DNSHandler::recv_dns(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
         goto Lsuccess;
       }
 
-      if (!hostent_cache) {
-        hostent_cache = dnsBufAllocator.alloc();
+      if (next == n_read) {
+        for (int i = 0; i < DNS_BATCH_SIZE; ++i) {
+          if (!hostent_cache[i]) {
+            hostent_cache[i] = dnsBufAllocator.alloc();
+          }
+          iov[i].iov_base             = hostent_cache[i]->buf;
+          iov[i].iov_len              = MAX_DNS_PACKET_LEN;
+          msgs[i].msg_hdr             = {};
+          msgs[i].msg_hdr.msg_name    = &from_ip[i];
+          msgs[i].msg_hdr.msg_namelen = sizeof(from_ip[i]);
+          msgs[i].msg_hdr.msg_iov     = &iov[i];
+          msgs[i].msg_hdr.msg_iovlen  = 1;
+        }
+        n_read = socketManager.recvmmsg(dnsc->fd, msgs, DNS_BATCH_SIZE, 0);
+        next   = 0;
+        Debug("dns", "DNSHandler::recv_dns batch = [%d]", n_read);
+        if (n_read == -EAGAIN) {
+          n_read = 0;
+          break;
+        }
+        if (n_read <= 0) {
+          res    = n_read;
+          n_read = 0;
+          goto Lerror;
+        }
       }
-
-      res = socketManager.recvfrom(dnsc->fd, hostent_cache->buf, MAX_DNS_PACKET_LEN, 0, &from_ip.sa, &from_length);
+      k   = next++;
+      res = msgs[k].msg_len;
       Debug("dns", "DNSHandler::recv_dns res = [%d]", res);
-      if (res == -EAGAIN) {
-        break;
-      }
       if (res <= 0) {
-      Lerror:
-        Debug("dns", "named error: %d", res);
-        if (dns_ns_rr) {
-          rr_failure(dnsc->num);
-        } else if (dnsc->num == name_server) {
-          failover();
-        }
-        break;
+        // Only a failed read is a name server error, the rest of the batch has been read already.
+        continue;
       }
 
       // verify that this response came from the correct server
-      if (!ats_ip_addr_eq(&dnsc->ip.sa, &from_ip.sa)) {
-        Warning("unexpected DNS response from %s (expected %s)", ats_ip_ntop(&from_ip.sa, ipbuff1, sizeof ipbuff1),
+      if (!ats_ip_addr_eq(&dnsc->ip.sa, &from_ip[k].sa)) {
+        Warning("unexpected DNS response from %s (expected %s)", ats_ip_ntop(&from_ip[k].sa, ipbuff1, sizeof ipbuff1),
                 ats_ip_ntop(&dnsc->ip.sa, ipbuff2, sizeof ipbuff2));
         continue;
       }
-      buf              = hostent_cache;
-      hostent_cache    = nullptr;
+      buf              = hostent_cache[k];
+      hostent_cache[k] = nullptr;
       buf->packet_size = res;
       Debug("dns", "received packet size = %d", res);
     Lsuccess:
@@ -905,6 +925,17 @@ DNSHandler::recv_dns(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
           received_one(name_server);
         }
       }
+      continue;
+
+    Lerror:
+      // A failed read on either transport.
+      Debug("dns", "named error: %d", res);
+      if (dns_ns_rr) {
+        rr_failure(dnsc->num);
+      } else if (dnsc->num == name_server) {
+        failover();
+      }
+      break;
     }
   }
 }
@@ -1000,6 +1031,131 @@ get_entry(DNSHandler *h, char *qname, int qtype)
   return nullptr;
 }
 
+/** Give @a e a new query id and put it in the query @a header. */
+static void
+dns_set_query_id(DNSHandler *h, DNSEntry *e, HEADER *header)
+{
+  uint16_t i = h->get_query_id();
+  header->id = htons(i);
+  if (e->id[dns_retries - e->retries] >= 0) {
+    // clear previous id in case named was switched or domain was expanded
+    h->release_query_id(e->id[dns_retries - e->retries]);
+  }
+  e->id[dns_retries - e->retries] = i;
+}
+
+/** Note the query for @a e was sent to name server @a ns and start its timeout. */
+static void
+dns_sent(DNSHandler *h, DNSEntry *e, int ns)
+{
+  ProxyMutex *mutex = h->mutex.get();
+
+  e->written_flag      = true;
+  e->which_ns          = ns;
+  e->once_written_flag = true;
+  ++h->in_flight;
+  DNS_INCREMENT_DYN_STAT(dns_in_flight_stat);
+
+  e->send_time = Thread::get_hrtime();
+
+  if (e->timeout) {
+    e->timeout->cancel();
+  }
+
+  if (h->txn_lookup_timeout) {
+    e->timeout = h->mutex->thread_holding->schedule_in(e, HRTIME_MSECONDS(h->txn_lookup_timeout)); // this is in msec
+  } else {
+    e->timeout = h->mutex->thread_holding->schedule_in(e, HRTIME_SECONDS(dns_timeout));
+  }
+
+  Debug("dns", "sent qname = %s, id = %u, nameserver = %d", e->qname, e->id[dns_retries - e->retries], ns);
+  h->sent_one(ns);
+}
+
+/**
+  UDP queries built by write_dns and sent together to the current name server
+  with one system call.
+*/
+struct DNSWriteBatch {
+  DNSEntry *entry[DNS_BATCH_SIZE];
+  int length[DNS_BATCH_SIZE];
+  unsigned char buffer[DNS_BATCH_SIZE][PACKETSZ]; // queries carry no data, so always fit a UDP packet
+  int count = 0;
+
+  bool
+  full() const
+  {
+    return count == DNS_BATCH_SIZE;
+  }
+
+  void add(DNSHandler *h, DNSEntry *e);
+  bool flush(DNSHandler *h);
+};
+
+/** Build the query for @a e and add it to the batch. */
+void
+DNSWriteBatch::add(DNSHandler *h, DNSEntry *e)
+{
+  int r = _ink_res_mkquery(h->m_res, e->qname, e->qtype, buffer[count], false, sizeof(buffer[count]));
+  if (r <= 0) {
+    Debug("dns", "cannot build query: %s", e->qname);
+    dns_result(h, e, nullptr, false);
+    return;
+  }
+  dns_set_query_id(h, e, reinterpret_cast<HEADER *>(buffer[count]));
+  entry[count]  = e;
+  length[count] = r;
+  ++count;
+}
+
+/**
+  Send the batched queries.
+
+  @return true = keep going, false = give up for now.
+
+*/
+bool
+DNSWriteBatch::flush(DNSHandler *h)
+{
+  if (count == 0) {
+    return true;
+  }
+
+  int ns     = h->name_server;
+  int con_fd = h->udpcon[ns].fd;
+  struct iovec iov[DNS_BATCH_SIZE];
+  struct mmsghdr msgs[DNS_BATCH_SIZE];
+  for (int i = 0; i < count; ++i) {
+    iov[i].iov_base            = buffer[i];
+    iov[i].iov_len             = length[i];
+    msgs[i].msg_hdr            = {};
+    msgs[i].msg_hdr.msg_iov    = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  Debug("dns", "send %d queries to fd %d", count, con_fd);
+
+  int s    = socketManager.sendmmsg(con_fd, msgs, count, 0);
+  int sent = s > 0 ? s : 0;
+  for (int i = 0; i < sent; ++i) {
+    dns_sent(h, entry[i], ns);
+  }
+
+  bool ok = sent == count;
+  if (!ok) {
+    // Unsent entries are still not written, they are tried again later.
+    Debug("dns", "sendmmsg() failed: qname = %s, %d of %d sent, nameserver= %d", entry[sent]->qname, s, count, ns);
+    if (s < 0) {
+      if (dns_ns_rr) {
+        h->rr_failure(ns);
+      } else {
+        h->failover();
+      }
+    }
+  }
+  count = 0;
+  return ok;
+}
+
 /** Write up to dns_max_dns_in_flight entries. */
 static void
 write_dns(DNSHandler *h, bool tcp_retry)
@@ -1025,25 +1181,38 @@ write_dns(DNSHandler *h, bool tcp_retry)
   bool over_tcp   = (dns_conn_mode == DNS_CONN_MODE::TCP_ONLY) || ((dns_conn_mode == DNS_CONN_MODE::TCP_RETRY) && tcp_retry);
   // Debug("dns", "in_flight: %d, dns_max_dns_in_flight: %d", h->in_flight, dns_max_dns_in_flight);
   if (h->in_flight < dns_max_dns_in_flight) {
+    // UDP queries are batched, each batch goes to one name server.
+    DNSWriteBatch batch;
     DNSEntry *e = h->entries.head;
     while (e) {
       DNSEntry *n = (DNSEntry *)e->link.next;
       if (!e->written_flag) {
-        if (dns_ns_rr) {
+        if (dns_ns_rr && batch.count == 0) {
           int ns_start = h->name_server;
           do {
             h->name_server = (h->name_server + 1) % max_nscount;
           } while (h->ns_down[h->name_server] && h->name_server != ns_start);
         }
-        if (h->ns_down[h->name_server] || !write_dns_event(h, e, over_tcp)) {
+        if (h->ns_down[h->name_server]) {
           break;
         }
+        if (over_tcp) {
+          if (!write_dns_event(h, e, over_tcp)) {
+            break;
+          }
+        } else {
+          batch.add(h, e);
+          if (batch.full() && !batch.flush(h)) {
+            break;
+          }
+        }
       }
-      if (h->in_flight >= dns_max_dns_in_flight) {
+      if (h->in_flight + batch.count >= dns_max_dns_in_flight) {
         break;
       }
       e = n;
     }
+    batch.flush(h);
   }
   h->in_write_dns = false;
 }
@@ -1090,7 +1259,6 @@ DNSHandler::get_query_id()
 static bool
 write_dns_event(DNSHandler *h, DNSEntry *e, bool over_tcp)
 {
-  ProxyMutex *mutex = h->mutex.get();
   unsigned char buffer[MAX_DNS_PACKET_LEN];
   int offset     = over_tcp ? tcp_data_length_offset : 0;
   HEADER *header = (HEADER *)(buffer + offset);
@@ -1102,14 +1270,8 @@ write_dns_event(DNSHandler *h, DNSEntry *e, bool over_tcp)
     return true;
   }
 
-  uint16_t i = h->get_query_id();
-  header->id = htons(i);
-  if (e->id[dns_retries - e->retries] >= 0) {
-    // clear previous id in case named was switched or domain was expanded
-    h->release_query_id(e->id[dns_retries - e->retries]);
-  }
-  e->id[dns_retries - e->retries] = i;
-  int con_fd                      = over_tcp ? h->tcpcon[h->name_server].fd : h->udpcon[h->name_server].fd;
+  dns_set_query_id(h, e, header);
+  int con_fd = over_tcp ? h->tcpcon[h->name_server].fd : h->udpcon[h->name_server].fd;
   Debug("dns", "send query (qtype=%d) for %s to fd %d", e->qtype, e->qname, con_fd);
 
   int s = socketManager.send(con_fd, buffer, r, 0);
@@ -1126,26 +1288,7 @@ write_dns_event(DNSHandler *h, DNSEntry *e, bool over_tcp)
     return false;
   }
 
-  e->written_flag      = true;
-  e->which_ns          = h->name_server;
-  e->once_written_flag = true;
-  ++h->in_flight;
-  DNS_INCREMENT_DYN_STAT(dns_in_flight_stat);
-
-  e->send_time = Thread::get_hrtime();
-
-  if (e->timeout) {
-    e->timeout->cancel();
-  }
-
-  if (h->txn_lookup_timeout) {
-    e->timeout = h->mutex->thread_holding->schedule_in(e, HRTIME_MSECONDS(h->txn_lookup_timeout)); // this is in msec
-  } else {
-    e->timeout = h->mutex->thread_holding->schedule_in(e, HRTIME_SECONDS(dns_timeout));
-  }
-
-  Debug("dns", "sent qname = %s, id = %u, nameserver = %d", e->qname, e->id[dns_retries - e->retries], h->name_server);
-  h->sent_one();
+  dns_sent(h, e, h->name_server);
   return true;
 }
 
@@ -1197,6 +1340,7 @@ DNSEntry::mainEvent(int event, Event *e)
     if (dup) {
       Debug("dns", "collapsing NS request");
       dup->dups.enqueue(this);
+      DNS_INCREMENT_DYN_STAT(dns_coalesced_lookups_stat);
     } else {
       Debug("dns", "adding first to collapsing queue");
       dnsH->entries.enqueue(this);
@@ -1823,6 +1967,9 @@ ink_dns_init(ts::ModuleVersion v)
 
   RecRegisterRawStat(dns_rsb, RECT_PROCESS, "proxy.process.dns.in_flight", RECD_INT, RECP_NON_PERSISTENT, (int)dns_in_flight_stat,
                      RecRawStatSyncSum);
+
+  RecRegisterRawStat(dns_rsb, RECT_PROCESS, "proxy.process.dns.coalesced_lookups", RECD_INT, RECP_PERSISTENT,
+                     (int)dns_coalesced_lookups_stat, RecRawStatSyncSum);
 }
 
 #ifdef TS_HAS_TESTS
@@ -68,6 +68,7 @@ extern unsigned int dns_sequence_number;
 #define DNS_PRIMARY_REOPEN_PERIOD HRTIME_SECONDS(60)
 #define BAD_DNS_RESULT ((HostEnt *)(uintptr_t)-1)
 #define DEFAULT_NUM_TRY_SERVER 8
+#define DNS_BATCH_SIZE 16 // UDP queries sent or responses read per system call
 
 // these are from nameser.h
 #ifndef HFIXEDSZ
@@ -97,6 +98,7 @@ enum DNS_Stats {
   dns_max_retries_exceeded_stat,
   dns_sequence_number_stat,
   dns_in_flight_stat,
+  dns_coalesced_lookups_stat,
   DNS_Stat_Count
 };
 
@@ -195,7 +197,8 @@ struct DNSHandler : public Continuation {
   int in_flight;
   int name_server;
   int in_write_dns;
-  HostEnt *hostent_cache;
+  /// Receive buffers for the next batch of UDP responses, kept between reads if not used.
+  HostEnt *hostent_cache[DNS_BATCH_SIZE];
 
   int ns_down[MAX_NAMED];
   int failover_number[MAX_NAMED];
@@ -218,12 +221,12 @@ struct DNSHandler : public Continuation {
   }
 
   void
-  sent_one()
+  sent_one(int i)
   {
-    ++failover_number[name_server];
-    Debug("dns", "sent_one: failover_number for resolver %d is %d", name_server, failover_number[name_server]);
-    if (failover_number[name_server] >= dns_failover_number && !crossed_failover_number[name_server])
-      crossed_failover_number[name_server] = Thread::get_hrtime();
+    ++failover_number[i];
+    Debug("dns", "sent_one: failover_number for resolver %d is %d", i, failover_number[i]);
+    if (failover_number[i] >= dns_failover_number && !crossed_failover_number[i])
+      crossed_failover_number[i] = Thread::get_hrtime();
   }
 
   bool
@@ -317,7 +320,7 @@ DNSHandler::DNSHandler()
     in_flight(0),
     name_server(0),
     in_write_dns(0),
-    hostent_cache(nullptr),
+    hostent_cache{nullptr},
     last_primary_retry(0),
     last_primary_reopen(0),
     m_res(nullptr),
@@ -54,6 +54,14 @@
 
 #define DEFAULT_OPEN_MODE 0644
 
+#if !HAVE_RECVMMSG
+// As on Linux, where it comes with recvmmsg, for the fallback multiple message calls.
+struct mmsghdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
 class Thread;
 extern int net_config_poll_timeout;
 
@@ -84,6 +92,7 @@ struct SocketManager {
   int recv(int s, void *buf, int len, int flags);
   int recvfrom(int fd, void *buf, int size, int flags, struct sockaddr *addr, socklen_t *addrlen);
   int recvmsg(int fd, struct msghdr *m, int flags, void *pOLP = nullptr);
+  int recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 
   int64_t write(int fd, void *buf, int len, void *pOLP = nullptr);
   int64_t writev(int fd, struct iovec *vector, size_t count);
@@ -93,6 +102,7 @@ struct SocketManager {
   int send(int fd, void *buf, int len, int flags);
   int sendto(int fd, void *buf, int len, int flags, struct sockaddr const *to, int tolen);
   int sendmsg(int fd, struct msghdr *m, int flags, void *pOLP = nullptr);
+  int sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
   int64_t lseek(int fd, off_t offset, int whence);
   int fstat(int fd, struct stat *);
   int unlink(char *buf);
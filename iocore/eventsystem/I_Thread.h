@@ -121,6 +121,8 @@ public:
   ProxyAllocator http2ClientSessionAllocator;
   ProxyAllocator http2StreamAllocator;
   ProxyAllocator http1ServerSessionAllocator;
+  ProxyAllocator http2ServerSessionAllocator;
+  ProxyAllocator http2ServerStreamAllocator;
   ProxyAllocator hdrHeapAllocator;
   ProxyAllocator strHeapAllocator;
   ProxyAllocator cacheVConnectionAllocator;
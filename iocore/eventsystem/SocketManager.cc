@@ -78,6 +78,62 @@ SocketManager::accept4(int s, struct sockaddr *addr, socklen_t *addrlen, int fla
   return -errno;
 }
 
+#if !HAVE_RECVMMSG
+static int
+recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec * /* timeout ATS_UNUSED */)
+{
+  unsigned int i = 0;
+  for (; i < vlen; ++i) {
+    ssize_t r = recvmsg(fd, &msgvec[i].msg_hdr, flags);
+    if (r < 0) {
+      return i ? i : -1;
+    }
+    msgvec[i].msg_len = r;
+  }
+  return i;
+}
+#endif
+
+#if !HAVE_SENDMMSG
+static int
+sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  unsigned int i = 0;
+  for (; i < vlen; ++i) {
+    ssize_t r = sendmsg(fd, &msgvec[i].msg_hdr, flags);
+    if (r < 0) {
+      return i ? i : -1;
+    }
+    msgvec[i].msg_len = r;
+  }
+  return i;
+}
+#endif
+
+int
+SocketManager::recvmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  int r;
+  do {
+    if (unlikely((r = ::recvmmsg(fd, msgvec, vlen, flags, nullptr)) < 0)) {
+      r = -errno;
+    }
+  } while (r == -EINTR);
+  return r;
+}
+
+int
+SocketManager::sendmmsg(int fd, struct mmsghdr *msgvec, unsigned int vlen, int flags)
+{
+  int r;
+  do {
+    if (unlikely((r = ::sendmmsg(fd, msgvec, vlen, flags)) < 0)) {
+      r = -errno;
+    }
+  } while (r == -EINTR);
+  return r;
+}
+
 SocketManager::SocketManager() : pagesize(ats_pagesize()) {}
 
 SocketManager::~SocketManager()
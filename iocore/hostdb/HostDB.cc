@@ -29,6 +29,7 @@
 #include "tscore/Tokenizer.h"
 #include "tscore/ink_apidefs.h"
 
+#include <atomic>
 #include <utility>
 #include <vector>
 #include <algorithm>
@@ -50,6 +51,9 @@ unsigned int hostdb_ip_timeout_interval        = HOST_DB_IP_TIMEOUT;
 unsigned int hostdb_ip_fail_timeout_interval   = HOST_DB_IP_FAIL_TIMEOUT;
 unsigned int hostdb_serve_stale_but_revalidate = 0;
 unsigned int hostdb_hostfile_check_interval    = 86400; // 1 day
+unsigned int hostdb_prefetch_min_hits          = 0;
+unsigned int hostdb_prefetch_ttl_pct           = 80;
+unsigned int hostdb_prefetch_max_per_second    = 100;
 // Epoch timestamp of the current hosts file check.
 ink_time_t hostdb_current_interval = 0;
 // Epoch timestamp of the last time we actually checked for a hosts file update.
@@ -329,7 +333,7 @@ HostDBCache::start(int flags)
 
   // Setup the ref-counted cache (this must be done regardless of syncing or not).
   this->refcountcache = new RefCountCache<HostDBInfo>(hostdb_partitions, hostdb_max_size, hostdb_max_count, HostDBInfo::version(),
-                                                      "proxy.process.hostdb.cache.");
+                                                      "proxy.process.hostdb.cache.", HOST_DB_RETIRE_DELAY);
 
   //
   // Load and sync HostDB, if we've asked for it.
@@ -404,6 +408,9 @@ HostDBProcessor::start(int, size_t)
   REC_EstablishStaticConfigInt32U(hostdb_serve_stale_but_revalidate, "proxy.config.hostdb.serve_stale_for");
   REC_EstablishStaticConfigInt32U(hostdb_hostfile_check_interval, "proxy.config.hostdb.host_file.interval");
   REC_EstablishStaticConfigInt32U(hostdb_round_robin_max_count, "proxy.config.hostdb.round_robin_max_count");
+  REC_EstablishStaticConfigInt32U(hostdb_prefetch_min_hits, "proxy.config.hostdb.prefetch.min_hits");
+  REC_EstablishStaticConfigInt32U(hostdb_prefetch_ttl_pct, "proxy.config.hostdb.prefetch.ttl_pct");
+  REC_EstablishStaticConfigInt32U(hostdb_prefetch_max_per_second, "proxy.config.hostdb.prefetch.max_per_second");
 
   //
   // Set up hostdb_current_interval
@@ -436,6 +443,7 @@ HostDBContinuation::init(HostDBHash const &the_hash, Options const &opt)
 
   host_res_style     = opt.host_res_style;
   dns_lookup_timeout = opt.timeout;
+  prefetch           = opt.prefetch;
   mutex              = hostDB.refcountcache->lock_for_key(hash.hash.fold());
   if (opt.cont) {
     action = opt.cont;
@@ -577,6 +585,92 @@ probe(Ptr<ProxyMutex> mutex, HostDBHash const &hash, bool ignore_timeout)
   return r;
 }
 
+// Is @a r used enough, and far enough into its TTL, to look it up again before it times out?
+static bool
+is_prefetch_due(HostDBInfo const *r)
+{
+  return hostdb_prefetch_min_hits > 0 && r->hits >= hostdb_prefetch_min_hits && !r->reverse_dns && !r->is_failed() &&
+         uint64_t(r->ip_interval()) * 100 >= uint64_t(r->ip_timeout_interval) * hostdb_prefetch_ttl_pct;
+}
+
+// Count a lookup answered by @a r.
+static void
+note_hit(HostDBInfo *r)
+{
+  if (hostdb_prefetch_min_hits == 0) {
+    return;
+  }
+  ProxyMutex *mutex = this_ethread()->mutex.get();
+  // Counting stops at the threshold, so popular records aren't written by every lookup.
+  if (r->hits < hostdb_prefetch_min_hits) {
+    ink_atomic_increment(&r->hits, 1u);
+  }
+  // Past this point the record the prefetch replaced would have timed out.
+  if (r->prefetched && uint64_t(r->ip_interval()) * 100 >= uint64_t(r->ip_timeout_interval) * (100 - hostdb_prefetch_ttl_pct)) {
+    HOSTDB_INCREMENT_DYN_STAT(hostdb_prefetch_avoided_misses_stat);
+  }
+}
+
+// Limit prefetches to proxy.config.hostdb.prefetch.max_per_second, 0 is no limit.
+static bool
+is_prefetch_allowed()
+{
+  static std::atomic<ink_time_t> window{0};
+  static std::atomic<unsigned int> count{0};
+
+  if (hostdb_prefetch_max_per_second == 0) {
+    return true;
+  }
+  ink_time_t now = hostdb_current_interval;
+  ink_time_t w   = window.load(std::memory_order_relaxed);
+  if (w != now && window.compare_exchange_strong(w, now)) {
+    count = 0;
+  }
+  return count++ < hostdb_prefetch_max_per_second;
+}
+
+// Count a lookup answered by @a r, and if it is due look it up again in the background so lookups
+// don't wait for DNS when it times out. The partition lock must be held.
+static void
+note_hit_and_prefetch(HostDBInfo *r, HostDBHash const &hash)
+{
+  note_hit(r);
+  if (!is_prefetch_due(r) || hostDB.is_pending_dns_for_hash(hash.hash)) {
+    return;
+  }
+  ProxyMutex *mutex = this_ethread()->mutex.get();
+  if (!is_prefetch_allowed()) {
+    // Start counting again, otherwise the record stays due and keeps its lookups off the lockless path.
+    HOSTDB_INCREMENT_DYN_STAT(hostdb_prefetch_rate_limited_stat);
+    ink_atomic_swap(&r->hits, 0u);
+    return;
+  }
+  Debug("hostdb", "prefetching %.*s, %u hits %u of %u seconds into its TTL", hash.host_len, hash.host_name, r->hits,
+        r->ip_interval(), r->ip_timeout_interval);
+  HOSTDB_INCREMENT_DYN_STAT(hostdb_prefetches_stat);
+  HostDBContinuation *c = hostDBContAllocator.alloc();
+  HostDBContinuation::Options copt;
+  copt.host_res_style = host_res_style_for(r->ip());
+  copt.prefetch       = true;
+  c->init(hash, copt);
+  c->do_dns();
+}
+
+// Look up @a hash without the partition lock. Only records usable as they are are returned, failed
+// records and records that need refreshing or prefetching are left to probe().
+static Ptr<HostDBInfo>
+probe_lockless(HostDBHash const &hash)
+{
+  Ptr<HostDBInfo> r = hostDB.refcountcache->get_lockless(hash.hash.fold());
+  if (r && (r->is_failed() || r->is_ip_stale() || r->is_ip_timeout() || is_prefetch_due(r.get()))) {
+    r.clear();
+  }
+  if (r) {
+    note_hit(r.get());
+  }
+  return r;
+}
+
 //
 // Insert a HostDBInfo into the database
 // A null value indicates that the block is empty.
@@ -593,6 +687,7 @@ HostDBContinuation::insert(unsigned int attl)
 
   r->ip_timestamp        = hostdb_current_interval;
   r->ip_timeout_interval = std::clamp(attl, 1u, HOST_DB_MAX_TTL);
+  r->prefetched          = prefetch;
 
   Debug("hostdb", "inserting for: %.*s: (hash: %" PRIx64 ") now: %u timeout: %u ttl: %u", hash.host_len, hash.host_name,
         folded_hash, r->ip_timestamp, r->ip_timeout_interval, attl);
@@ -636,6 +731,17 @@ HostDBProcessor::getby(Continuation *cont, const char *hostname, int len, sockad
   if (!aforce_dns) {
     MUTEX_TRY_LOCK(lock, cont->mutex, thread);
     bool loop = lock.is_locked();
+    // Most hits need only the record, which doesn't need the partition lock.
+    if (loop) {
+      if (Ptr<HostDBInfo> r = probe_lockless(hash); r) {
+        Debug("hostdb", "immediate answer for %s without lock",
+              hostname ? hostname : ats_is_ip(ip) ? ats_ip_ntop(ip, ipb, sizeof ipb) : "<null>");
+        HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+        HOSTDB_INCREMENT_DYN_STAT(hostdb_total_lockless_hits_stat);
+        reply_to_cont(cont, r.get());
+        return ACTION_RESULT_DONE;
+      }
+    }
     while (loop) {
       loop = false; // Only loop on explicit set for retry.
       // find the partition lock
@@ -655,6 +761,7 @@ HostDBProcessor::getby(Continuation *cont, const char *hostname, int len, sockad
             Debug("hostdb", "immediate answer for %s",
                   hostname ? hostname : ats_is_ip(ip) ? ats_ip_ntop(ip, ipb, sizeof ipb) : "<null>");
             HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+            note_hit_and_prefetch(r.get(), hash);
             reply_to_cont(cont, r.get());
             return ACTION_RESULT_DONE;
           }
@@ -761,6 +868,14 @@ HostDBProcessor::getSRVbyname_imm(Continuation *cont, process_srv_info_pfn proce
 
   // Attempt to find the result in-line, for level 1 hits
   if (!force_dns) {
+    if (Ptr<HostDBInfo> r = probe_lockless(hash); r) {
+      Debug("dns_srv", "immediate SRV answer for %s from hostdb", hostname);
+      HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+      HOSTDB_INCREMENT_DYN_STAT(hostdb_total_lockless_hits_stat);
+      (cont->*process_srv_info)(r.get());
+      return ACTION_RESULT_DONE;
+    }
+
     // find the partition lock
     Ptr<ProxyMutex> bucket_mutex = hostDB.refcountcache->lock_for_key(hash.hash.fold());
     MUTEX_TRY_LOCK(lock, bucket_mutex, thread);
@@ -772,6 +887,7 @@ HostDBProcessor::getSRVbyname_imm(Continuation *cont, process_srv_info_pfn proce
         Debug("hostdb", "immediate SRV answer for %s from hostdb", hostname);
         Debug("dns_srv", "immediate SRV answer for %s from hostdb", hostname);
         HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+        note_hit_and_prefetch(r.get(), hash);
         (cont->*process_srv_info)(r.get());
         return ACTION_RESULT_DONE;
       }
@@ -847,6 +963,7 @@ HostDBProcessor::getbyname_imm(Continuation *cont, process_hostdb_info_pfn proce
           // No retry -> final result. Return it.
           Debug("hostdb", "immediate answer for %.*s", hash.host_len, hash.host_name);
           HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+          note_hit_and_prefetch(r.get(), hash);
           (cont->*process_hostdb_info)(r.get());
           return ACTION_RESULT_DONE;
         }
@@ -1344,7 +1461,8 @@ HostDBContinuation::dnsEvent(int event, HostEnt *e)
     HostDBInfo *r = HostDBInfo::alloc(allocSize);
     Debug("hostdb", "allocating %d bytes for %s with %d RR records at [%p]", allocSize, aname, valid_records, r);
     // set up the record
-    r->key = hash.hash.fold(); // always set the key
+    r->key        = hash.hash.fold(); // always set the key
+    r->prefetched = prefetch;
 
     r->hostname_offset = offset;
     ink_strlcpy(r->perm_hostname(), aname, s_size);
@@ -1356,6 +1474,13 @@ HostDBContinuation::dnsEvent(int event, HostEnt *e)
     if (failed && old_r && old_r->serve_stale_but_revalidate()) {
       r->free();
       r = old_r.get();
+    } else if (failed && old_r && prefetch && !old_r->is_ip_timeout()) {
+      // A failed prefetch leaves the old record until it times out. It has to be used as much again
+      // before it is prefetched again, which keeps a failing name from being looked up on every use.
+      Debug("hostdb", "prefetch failed for %.*s, keeping the old record", hash.host_len, hash.host_name);
+      ink_atomic_swap(&old_r->hits, 0u);
+      r->free();
+      r = old_r.get();
     } else if (is_byname()) {
       if (first_record) {
         ip_addr_set(tip, af, first_record);
@@ -1618,6 +1743,7 @@ HostDBContinuation::probeEvent(int /* event ATS_UNUSED */, Event *e)
 
     if (r) {
       HOSTDB_INCREMENT_DYN_STAT(hostdb_total_hits_stat);
+      note_hit_and_prefetch(r.get(), hash);
     }
 
     if (action.continuation && r) {
@@ -2213,6 +2339,18 @@ ink_hostdb_init(ts::ModuleVersion v)
   RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.re_dns_on_reload", RECD_INT, RECP_PERSISTENT,
                      (int)hostdb_re_dns_on_reload_stat, RecRawStatSyncSum);
 
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.total_lockless_hits", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_total_lockless_hits_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetches", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetches_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetch_rate_limited", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetch_rate_limited_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetch_avoided_misses", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetch_avoided_misses_stat, RecRawStatSyncSum);
+
   ts_host_res_global_init();
 }
 
@@ -182,6 +182,9 @@ struct HostDBInfo : public RefCountObj {
     // to mess with the refcount, since this is a fairly unique use case
     ret                 = new (ret) HostDBInfo();
     ret->iobuffer_index = buf_index;
+    // Hit counts are not meaningful across restarts, and older versions left this padding unset.
+    ret->hits       = 0;
+    ret->prefetched = 0;
     return ret;
   }
 
@@ -345,6 +348,10 @@ struct HostDBInfo : public RefCountObj {
 
   unsigned int round_robin : 1;     // This is the root of a round robin block
   unsigned int round_robin_elt : 1; // This is an address in a round robin block
+  unsigned int prefetched : 1;      // This record was looked up before the previous one timed out
+
+  // Kept after the flags, in what was trailing padding, so records saved by older versions load unchanged.
+  unsigned int hits; // lookups answered by this record, counted up to proxy.config.hostdb.prefetch.min_hits
 };
 
 struct HostDBRoundRobin {
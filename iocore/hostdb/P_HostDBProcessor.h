@@ -128,6 +128,8 @@ const unsigned int HOST_DB_MAX_TTL = (0x1FFFFF); // 24 days
 // period to wait for a remote probe...
 #define HOST_DB_RETRY_PERIOD HRTIME_MSECONDS(20)
 #define HOST_DB_ITERATE_PERIOD HRTIME_MSECONDS(5)
+// How long records removed from HostDB are kept for lookups that found them without the partition lock.
+#define HOST_DB_RETIRE_DELAY HRTIME_SECONDS(60)
 
 //#define TEST(_x) _x
 #define TEST(_x)
@@ -141,6 +143,10 @@ enum HostDB_Stats {
   hostdb_ttl_stat,         // D average TTL
   hostdb_ttl_expires_stat, // D == TTL Expires
   hostdb_re_dns_on_reload_stat,
+  hostdb_total_lockless_hits_stat,     // D == hits found without the partition lock
+  hostdb_prefetches_stat,              // D == records looked up again before they timed out
+  hostdb_prefetch_rate_limited_stat,   // D == prefetches skipped for proxy.config.hostdb.prefetch.max_per_second
+  hostdb_prefetch_avoided_misses_stat, // D == hits that needed a prefetched record
   HostDB_Stat_Count
 };
 
@@ -454,6 +460,7 @@ struct HostDBContinuation : public Continuation {
   unsigned int missing : 1;
   unsigned int force_dns : 1;
   unsigned int round_robin : 1;
+  unsigned int prefetch : 1; ///< Looking up a record again before it times out.
 
   int probeEvent(int event, Event *e);
   int iterateEvent(int event, Event *e);
@@ -493,16 +500,17 @@ struct HostDBContinuation : public Continuation {
     int timeout;                 ///< Timeout value. Default 0
     HostResStyle host_res_style; ///< IP address family fallback. Default @c HOST_RES_NONE
     bool force_dns;              ///< Force DNS lookup. Default @c false
+    bool prefetch;               ///< Prefetch of a record that is still valid. Default @c false
     Continuation *cont;          ///< Continuation / action. Default @c nullptr (none)
 
-    Options() : timeout(0), host_res_style(HOST_RES_NONE), force_dns(false), cont(nullptr) {}
+    Options() : timeout(0), host_res_style(HOST_RES_NONE), force_dns(false), prefetch(false), cont(nullptr) {}
   };
   static const Options DEFAULT_OPTIONS; ///< Default defaults.
   void init(HostDBHash const &hash, Options const &opt = DEFAULT_OPTIONS);
   int make_get_message(char *buf, int len);
   int make_put_message(HostDBInfo *r, Continuation *c, char *buf, int len);
 
-  HostDBContinuation() : missing(false), force_dns(DEFAULT_OPTIONS.force_dns), round_robin(false)
+  HostDBContinuation() : missing(false), force_dns(DEFAULT_OPTIONS.force_dns), round_robin(false), prefetch(false)
   {
     ink_zero(hash_host_name_store);
     ink_zero(hash.hash);
@@ -34,6 +34,10 @@
 #include "tscore/I_Version.h"
 #include <unistd.h>
 
+#include <atomic>
+#include <deque>
+#include <memory>
+
 #define REFCOUNT_CACHE_EVENT_SYNC REFCOUNT_CACHE_EVENT_EVENTS_START
 
 #define REFCOUNTCACHE_MAGIC_NUMBER 0x0BAD2D9
@@ -50,6 +54,7 @@ enum RefCountCache_Stats {
   refcountcache_total_failed_inserts_stat, // total items unable to insert
   refcountcache_total_lookups_stat,        // total get() calls
   refcountcache_total_hits_stat,           // total hits
+  refcountcache_total_lookup_retries_stat, // lock free lookups repeated because the index was rebuilt
 
   // Persistence metrics
   refcountcache_last_sync_time,   // seconds since epoch of last successful sync
@@ -149,13 +154,21 @@ struct RefCountCacheLinkage {
 
 // The RefCountCachePartition is simply a map of key -> Ptr<YourClass>
 // We partition the cache to reduce lock contention
+//
+// If the partition has a retire delay, lookups may also be done without the lock (get_lockless). Those
+// use an open addressing index of the map that is only changed with the lock held. Items removed from
+// the partition are kept for the retire delay, so a lookup that found one just before it was removed
+// can still take a reference to it.
 template <class C> class RefCountCachePartition
 {
 public:
   using hash_type = IntrusiveHashMap<RefCountCacheLinkage>;
 
-  RefCountCachePartition(unsigned int part_num, uint64_t max_size, unsigned int max_items, RecRawStatBlock *rsb = nullptr);
+  RefCountCachePartition(unsigned int part_num, uint64_t max_size, unsigned int max_items, RecRawStatBlock *rsb = nullptr,
+                         ink_hrtime retire_delay = 0);
+  ~RefCountCachePartition();
   Ptr<C> get(uint64_t key);
+  Ptr<C> get_lockless(uint64_t key);
   void put(uint64_t key, C *item, int size = 0, int expire_time = 0);
   void erase(uint64_t key, ink_time_t expiry_time = -1);
 
@@ -172,7 +185,39 @@ public:
   Ptr<ProxyMutex> lock; // Lock
 
 private:
+  // Index of the items in the map for lookups without the lock. A slot is claimed for a key and never
+  // released, removing the item only clears the slot item. Key 0 is an empty slot, so it is not indexed.
+  struct ReadIndex {
+    struct Slot {
+      std::atomic<uint64_t> key{0};
+      std::atomic<RefCountObj *> item{nullptr};
+    };
+
+    explicit ReadIndex(unsigned int bits) : bits(bits), slots(new Slot[size_t(1) << bits]) {}
+
+    // The slot for @a key, or the empty slot it would be put in.
+    Slot &
+    find(uint64_t key) const
+    {
+      size_t mask = (size_t(1) << bits) - 1;
+      // Keys in a partition share their remainder, so mix them before picking a slot.
+      for (size_t i = (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);; i = (i + 1) & mask) {
+        uint64_t k = slots[i].key.load(std::memory_order_acquire);
+        if (k == key || k == 0) {
+          return slots[i];
+        }
+      }
+    }
+
+    unsigned int bits;
+    size_t used = 0; // Slots with a key.
+    std::unique_ptr<Slot[]> slots;
+  };
+
   void metric_inc(RefCountCache_Stats metric_enum, int64_t data);
+  void index_set(uint64_t key, RefCountObj *item);
+  void index_rebuild();
+  void purge_retired();
 
   unsigned int part_num;
   uint64_t max_size;
@@ -184,13 +229,35 @@ private:
 
   PriorityQueue<RefCountCacheHashEntry *> expiry_queue;
   RecRawStatBlock *rsb;
+
+  ink_hrtime retire_delay;
+  std::atomic<ReadIndex *> read_index{nullptr};
+  // Removed items and replaced indexes, with the time they can be released.
+  std::deque<std::pair<ink_hrtime, Ptr<C>>> retired_items;
+  std::deque<std::pair<ink_hrtime, std::unique_ptr<ReadIndex>>> retired_indexes;
 };
 
 template <class C>
 RefCountCachePartition<C>::RefCountCachePartition(unsigned int part_num, uint64_t max_size, unsigned int max_items,
-                                                  RecRawStatBlock *rsb)
-  : lock(new_ProxyMutex()), part_num(part_num), max_size(max_size), max_items(max_items), size(0), items(0), rsb(rsb)
+                                                  RecRawStatBlock *rsb, ink_hrtime retire_delay)
+  : lock(new_ProxyMutex()),
+    part_num(part_num),
+    max_size(max_size),
+    max_items(max_items),
+    size(0),
+    items(0),
+    rsb(rsb),
+    retire_delay(retire_delay)
 {
+  if (retire_delay > 0) {
+    // Start small, the index grows as items are added. The item limit may be unbounded, so it is no guide.
+    this->read_index = new ReadIndex(6);
+  }
+}
+
+template <class C> RefCountCachePartition<C>::~RefCountCachePartition()
+{
+  delete this->read_index.load();
 }
 
 template <class C>
@@ -207,6 +274,35 @@ RefCountCachePartition<C>::get(uint64_t key)
   }
 }
 
+template <class C>
+Ptr<C>
+RefCountCachePartition<C>::get_lockless(uint64_t key)
+{
+  this->metric_inc(refcountcache_total_lookups_stat, 1);
+  ReadIndex *index = this->read_index.load(std::memory_order_acquire);
+  while (index != nullptr && key != 0) {
+    typename ReadIndex::Slot &slot = index->find(key);
+    // A slot key never changes once set, so any item in the slot is for that key.
+    RefCountObj *item = nullptr;
+    if (slot.key.load(std::memory_order_acquire) == key) {
+      item = slot.item.load(std::memory_order_acquire);
+    }
+
+    // If the index was replaced meanwhile the item may have been removed since, look again.
+    if (ReadIndex *current = this->read_index.load(std::memory_order_acquire); current != index) {
+      this->metric_inc(refcountcache_total_lookup_retries_stat, 1);
+      index = current;
+      continue;
+    }
+    if (item != nullptr) {
+      this->metric_inc(refcountcache_total_hits_stat, 1);
+      return make_ptr(static_cast<C *>(item));
+    }
+    break;
+  }
+  return Ptr<C>();
+}
+
 template <class C>
 void
 RefCountCachePartition<C>::put(uint64_t key, C *item, int size, int expire_time)
@@ -238,6 +334,9 @@ RefCountCachePartition<C>::put(uint64_t key, C *item, int size, int expire_time)
 
   // add the item to the map
   this->item_map.insert(val);
+  if (this->read_index.load(std::memory_order_relaxed) != nullptr) {
+    this->index_set(key, item);
+  }
   this->size += val->meta.size;
   this->items++;
   this->metric_inc(refcountcache_current_size_stat, (int64_t)val->meta.size);
@@ -248,6 +347,7 @@ template <class C>
 void
 RefCountCachePartition<C>::erase(uint64_t key, ink_time_t expiry_time)
 {
+  this->purge_retired();
   if (auto it = this->item_map.find(key); it != this->item_map.end()) {
     if (expiry_time >= 0 && it->meta.expiry_time != expiry_time) {
       return;
@@ -278,9 +378,78 @@ RefCountCachePartition<C>::dealloc_entry(hash_type::iterator ptr)
     ptr->expiry_entry = nullptr; // To avoid the destruction of `l` calling the destructor again-- and causing issues
   }
 
+  if (this->read_index.load(std::memory_order_relaxed) != nullptr) {
+    this->index_set(ptr->meta.key, nullptr);
+    this->retired_items.emplace_back(Thread::get_hrtime() + this->retire_delay, make_ptr(static_cast<C *>(ptr->item.get())));
+  }
+
   RefCountCacheHashEntry::free<C>(ptr);
 }
 
+// Set the item for @a key in the read index, nullptr to remove it.
+template <class C>
+void
+RefCountCachePartition<C>::index_set(uint64_t key, RefCountObj *item)
+{
+  if (key == 0) {
+    return;
+  }
+  ReadIndex *index               = this->read_index.load(std::memory_order_relaxed);
+  typename ReadIndex::Slot &slot = index->find(key);
+  if (slot.key.load(std::memory_order_relaxed) == key) {
+    slot.item.store(item, std::memory_order_release);
+  } else if (item != nullptr) {
+    // Keep a quarter of the slots empty, lookups stop at the first one.
+    if ((index->used + 1) * 4 > (size_t(1) << index->bits) * 3) {
+      this->index_rebuild();
+      return;
+    }
+    // The item must be visible before the key, lookups read them in the other order.
+    slot.item.store(item, std::memory_order_relaxed);
+    slot.key.store(key, std::memory_order_release);
+    ++index->used;
+  }
+}
+
+// Replace the read index with one of just the items in the map, larger if needed.
+template <class C>
+void
+RefCountCachePartition<C>::index_rebuild()
+{
+  ReadIndex *old_index = this->read_index.load(std::memory_order_relaxed);
+  unsigned int bits    = old_index->bits;
+  while ((size_t(1) << bits) < 2 * size_t(this->item_map.count())) {
+    ++bits;
+  }
+
+  ReadIndex *index = new ReadIndex(bits);
+  for (auto &&it : this->item_map) {
+    if (it.meta.key != 0) {
+      typename ReadIndex::Slot &slot = index->find(it.meta.key);
+      slot.item.store(it.item.get(), std::memory_order_relaxed);
+      slot.key.store(it.meta.key, std::memory_order_relaxed);
+      ++index->used;
+    }
+  }
+  Debug("refcountcache", "partition %d rebuilt read index, %zu slots used of %zu", this->part_num, index->used, size_t(1) << bits);
+
+  this->read_index.store(index, std::memory_order_release);
+  this->retired_indexes.emplace_back(Thread::get_hrtime() + this->retire_delay, old_index);
+}
+
+template <class C>
+void
+RefCountCachePartition<C>::purge_retired()
+{
+  ink_hrtime now = Thread::get_hrtime();
+  while (!this->retired_items.empty() && this->retired_items.front().first <= now) {
+    this->retired_items.pop_front();
+  }
+  while (!this->retired_indexes.empty() && this->retired_indexes.front().first <= now) {
+    this->retired_indexes.pop_front();
+  }
+}
+
 template <class C>
 void
 RefCountCachePartition<C>::clear()
@@ -395,13 +564,16 @@ template <class C> class RefCountCache
 {
 public:
   // Constructor
+  // A non-zero @a retire_delay enables get_lockless, it is how long a lookup without the lock may take.
   RefCountCache(unsigned int num_partitions, int size = -1, int items = -1, ts::VersionNumber object_version = ts::VersionNumber(),
-                std::string metrics_prefix = "");
+                std::string metrics_prefix = "", ink_hrtime retire_delay = 0);
   // Destructor
   ~RefCountCache();
 
   // User interface to the cache
   Ptr<C> get(uint64_t key);
+  // Like get, but without the partition lock held.
+  Ptr<C> get_lockless(uint64_t key);
   void put(uint64_t key, C *item, int size = 0, ink_time_t expiry_time = -1);
   void erase(uint64_t key);
   void clear();
@@ -427,7 +599,7 @@ private:
 
 template <class C>
 RefCountCache<C>::RefCountCache(unsigned int num_partitions, int size, int items, ts::VersionNumber object_version,
-                                std::string metrics_prefix)
+                                std::string metrics_prefix, ink_hrtime retire_delay)
   : header(RefCountCacheHeader(object_version)), rsb(nullptr)
 {
   this->max_size       = size;
@@ -455,6 +627,9 @@ RefCountCache<C>::RefCountCache(unsigned int num_partitions, int size, int items
     RecRegisterRawStat(this->rsb, RECT_PROCESS, (metrics_prefix + "total_hits").c_str(), RECD_INT, RECP_NON_PERSISTENT,
                        (int)refcountcache_total_hits_stat, RecRawStatSyncCount);
 
+    RecRegisterRawStat(this->rsb, RECT_PROCESS, (metrics_prefix + "total_lookup_retries").c_str(), RECD_INT, RECP_NON_PERSISTENT,
+                       (int)refcountcache_total_lookup_retries_stat, RecRawStatSyncCount);
+
     RecRegisterRawStat(this->rsb, RECT_PROCESS, (metrics_prefix + "last_sync.time").c_str(), RECD_INT, RECP_NON_PERSISTENT,
                        (int)refcountcache_last_sync_time, RecRawStatSyncCount);
 
@@ -467,7 +642,8 @@ RefCountCache<C>::RefCountCache(unsigned int num_partitions, int size, int items
   // Now lets create all the partitions
   this->partitions.reserve(num_partitions);
   for (unsigned int i = 0; i < num_partitions; i++) {
-    this->partitions.push_back(new RefCountCachePartition<C>(i, size / num_partitions, items / num_partitions, this->rsb));
+    this->partitions.push_back(
+      new RefCountCachePartition<C>(i, size / num_partitions, items / num_partitions, this->rsb, retire_delay));
   }
 }
 
@@ -487,6 +663,13 @@ RefCountCache<C>::get(uint64_t key)
   return this->partitions[this->partition_for_key(key)]->get(key);
 }
 
+template <class C>
+Ptr<C>
+RefCountCache<C>::get_lockless(uint64_t key)
+{
+  return this->partitions[this->partition_for_key(key)]->get_lockless(key);
+}
+
 template <class C>
 void
 RefCountCache<C>::put(uint64_t key, C *item, int size, ink_time_t expiry_time)
@@ -27,6 +27,10 @@
 #include "tscore/I_Layout.h"
 #include <diags.i>
 #include <set>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // TODO: add tests with expiry_time
 
@@ -203,6 +207,93 @@ testclear()
   return ret;
 }
 
+int
+testLockless()
+{
+  int ret = 0;
+
+  RefCountCache<ExampleStruct> *cache =
+    new RefCountCache<ExampleStruct>(4, -1, -1, ts::VersionNumber(), "", HRTIME_SECONDS(60));
+
+  // Without a retire delay there is nothing to look in
+  RefCountCache<ExampleStruct> plain(4);
+  ExampleStruct *unindexed = ExampleStruct::alloc();
+  plain.put(1, unindexed);
+  ret |= plain.get_lockless(1).get() != nullptr;
+  plain.erase(1);
+
+  ExampleStruct *item = ExampleStruct::alloc();
+  cache->put(1, item);
+  item->idx = 1;
+  ret |= cache->get_lockless(1).get() != item;
+  ret |= item->refcount() != 1;
+  printf("ret=%d ref=%d\n", ret, item->refcount());
+
+  // An erased item is no longer found, but is kept for lookups that found it just before
+  cache->erase(1);
+  ret |= cache->get_lockless(1).get() != nullptr;
+  ret |= item->refcount() != 1;
+  ret |= item->idx != 1;
+  printf("ret=%d ref=%d\n", ret, item->refcount());
+
+  // Enough items to rebuild the index a few times, all of them must still be found
+  fillCache(cache, 1, 10000);
+  for (int i = 1; i < 10000; i++) {
+    Ptr<ExampleStruct> found = cache->get_lockless(i);
+    ret |= found.get() == nullptr || found->idx != i;
+  }
+  ret |= cache->get_lockless(10000).get() != nullptr;
+  printf("ret=%d\n", ret);
+
+  // Retired items are released with the cache
+  delete cache;
+  ret |= item->idx != -1;
+
+  return ret;
+}
+
+// Compare lookups without the partition lock to lookups with it, from several threads.
+void
+benchLockless()
+{
+  const int numItems = 10000;
+  const int numLoops = 1000000;
+
+  RefCountCache<ExampleStruct> *cache =
+    new RefCountCache<ExampleStruct>(64, -1, -1, ts::VersionNumber(), "", HRTIME_SECONDS(60));
+  fillCache(cache, 1, numItems + 1);
+  std::vector<std::mutex> locks(cache->partition_count());
+
+  for (int numThreads : {1, 2, 4, 8, 16}) {
+    for (bool lockless : {true, false}) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+          for (int i = 0; i < numLoops; i++) {
+            uint64_t key = 1 + (i * 7 + t) % numItems;
+            if (lockless) {
+              cache->get_lockless(key);
+            } else {
+              std::lock_guard<std::mutex> lock(locks[cache->partition_for_key(key)]);
+              cache->get(key);
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      auto elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+      printf("%d threads %s: %lld lookups/sec\n", numThreads, lockless ? "lockless" : "locked",
+             elapsed ? numLoops * numThreads * 1000LL / elapsed : 0);
+    }
+  }
+
+  delete cache;
+}
+
 int
 test()
 {
@@ -221,6 +312,10 @@ test()
   ret |= testRefcounting();
   printf("refcount ret %d\n", ret);
 
+  printf("Testing lockless lookups\n");
+  ret |= testLockless();
+  printf("lockless ret %d\n", ret);
+
   // Initialize our cache
   int cachePartitions                 = 4;
   RefCountCache<ExampleStruct> *cache = new RefCountCache<ExampleStruct>(cachePartitions);
@@ -285,11 +380,16 @@ test()
   return ret;
 }
 
+// Run with --benchmark to also time lockless lookups.
 int
-main()
+main(int argc, char *argv[])
 {
   int ret = test();
 
+  if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+    benchLockless();
+  }
+
   for (const auto item : ExampleStruct::items_freed) {
     printf("really freeing: %p\n", item);
     ExampleStruct::dealloc(item);
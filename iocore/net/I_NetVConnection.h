@@ -204,6 +204,11 @@ struct NetVCOptions {
    */
   const char *ssl_client_ca_cert_path = nullptr;
 
+  /** Protocols to offer by ALPN on an outbound TLS connection, in wire format.
+   * Empty to offer none. The bytes must outlive the options.
+   */
+  std::string_view alpn_protos;
+
   /// Reset all values to defaults.
 
   /**
@@ -24,6 +24,15 @@
 
 #include <openssl/ssl.h>
 #include <openssl/ocsp.h>
+#include <poll.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "P_Net.h"
 #include "P_SSLConfig.h"
 #include "P_SSLUtils.h"
@@ -33,6 +42,10 @@
 // so 10K should be more than enough.
 #define MAX_STAPLING_DER 10240
 
+// Maximum number of certificate IDs in one OCSP request. Every ID adds a single response to what is
+// stapled for each of them, so this also bounds the size of the stapled response.
+#define MAX_OCSP_QUERY_IDS 16
+
 // Cached info stored in SSL_CTX ex_info
 struct certinfo {
   unsigned char idx[20]; // Index in session cache SHA1 hash of certificate
@@ -314,167 +327,261 @@ stapling_check_response(certinfo *cinf, OCSP_RESPONSE *rsp)
   return SSL_TLSEXT_ERR_OK;
 }
 
-static OCSP_RESPONSE *
-query_responder(BIO *b, char *host, char *path, OCSP_REQUEST *req, int req_timeout)
-{
-  ink_hrtime start, end;
-  OCSP_RESPONSE *resp = nullptr;
-  OCSP_REQ_CTX *ctx;
-  int rv;
-
-  start = Thread::get_hrtime();
-  end   = ink_hrtime_add(start, ink_hrtime_from_sec(req_timeout));
-
-  ctx = OCSP_sendreq_new(b, path, nullptr, -1);
-  OCSP_REQ_CTX_add1_header(ctx, "Host", host);
-  OCSP_REQ_CTX_set1_req(ctx, req);
-
-  do {
-    rv = OCSP_sendreq_nbio(&resp, ctx);
-    ink_hrtime_sleep(HRTIME_MSECONDS(1));
-  } while ((rv == -1) && BIO_should_retry(b) && (Thread::get_hrtime() < end));
-
-  OCSP_REQ_CTX_free(ctx);
+/* Refreshing one certificate at a time, each waiting out its responder, takes far too long with tens
+   of thousands of certificates. A refresh pass instead collects every certificate whose response has
+   expired and batches them by responder and issuer: one query asks the responder about up to
+   MAX_OCSP_QUERY_IDS certificate IDs of the same issuer, and a certificate that is in several contexts
+   is asked about once. Up to proxy.config.ssl.ocsp.max_concurrent_requests queries run at once,
+   polling their sockets together. The pass runs on the ET_OCSP thread.
+*/
+struct OCSPQuery {
+  std::vector<OCSP_CERTID *> ids; ///< Certificate IDs asked about, owned by the certificates.
+  std::vector<certinfo *> certs;  ///< Every certificate the response is for.
+  char *host        = nullptr;
+  char *port        = nullptr;
+  char *path        = nullptr;
+  OCSP_REQUEST *req = nullptr;
+  BIO *bio          = nullptr;
+  OCSP_REQ_CTX *ctx = nullptr;
+  ink_hrtime start  = 0;
 
-  if (rv) {
-    return resp;
+  ~OCSPQuery()
+  {
+    close();
+    OCSP_REQUEST_free(req);
+    OPENSSL_free(host);
+    OPENSSL_free(port);
+    OPENSSL_free(path);
   }
 
-  return nullptr;
-}
-
-static OCSP_RESPONSE *
-process_responder(OCSP_REQUEST *req, char *host, char *path, char *port, int req_timeout)
-{
-  BIO *cbio           = nullptr;
-  OCSP_RESPONSE *resp = nullptr;
-  cbio                = BIO_new_connect(host);
-  if (!cbio) {
-    goto end;
-  }
-  if (port) {
-    BIO_set_conn_port(cbio, port);
-  }
+  bool open(ink_hrtime now);
 
-  BIO_set_nbio(cbio, 1);
-  if (BIO_do_connect(cbio) <= 0 && !BIO_should_retry(cbio)) {
-    Debug("ssl_ocsp", "process_responder: failed to connect to OCSP response server. host=%s port=%s path=%s", host, port, path);
-    goto end;
+  void
+  close()
+  {
+    if (ctx) {
+      OCSP_REQ_CTX_free(ctx);
+      ctx = nullptr;
+    }
+    if (bio) {
+      BIO_free_all(bio);
+      bio = nullptr;
+    }
   }
-  resp = query_responder(cbio, host, path, req, req_timeout);
 
-end:
-  if (cbio) {
-    BIO_free_all(cbio);
-  }
-  return resp;
-}
+  void finish(OCSP_RESPONSE *rsp);
+};
 
-static bool
-stapling_refresh_response(certinfo *cinf, OCSP_RESPONSE **prsp)
+// Connect to the responder and queue the request, without blocking.
+bool
+OCSPQuery::open(ink_hrtime now)
 {
-  bool rv           = true;
-  OCSP_REQUEST *req = nullptr;
-  OCSP_CERTID *id   = nullptr;
-  char *host = nullptr, *port = nullptr, *path = nullptr;
-  int ssl_flag    = 0;
-  int req_timeout = -1;
-
-  Debug("ssl_ocsp", "stapling_refresh_response: querying responder");
-  *prsp = nullptr;
+  certinfo *cinf = certs.front();
+  int ssl_flag   = 0;
+  OCSP_CERTID *id;
 
+  start = now;
   if (!OCSP_parse_url(cinf->uri, &host, &port, &path, &ssl_flag)) {
-    goto err;
+    return false;
   }
 
   req = OCSP_REQUEST_new();
   if (!req) {
-    goto err;
-  }
-  id = OCSP_CERTID_dup(cinf->cid);
-  if (!id) {
-    goto err;
+    return false;
   }
-  if (!OCSP_request_add0_id(req, id)) {
-    goto err;
+  for (OCSP_CERTID *cid : ids) {
+    id = OCSP_CERTID_dup(cid);
+    if (!id || !OCSP_request_add0_id(req, id)) {
+      OCSP_CERTID_free(id);
+      return false;
+    }
   }
 
-  req_timeout = SSLConfigParams::ssl_ocsp_request_timeout;
-  *prsp       = process_responder(req, host, path, port, req_timeout);
-
-  if (*prsp == nullptr) {
-    goto done;
+  bio = BIO_new_connect(host);
+  if (!bio) {
+    return false;
   }
-
-  if (OCSP_response_status(*prsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL) {
-    Debug("ssl_ocsp", "stapling_refresh_response: query response received");
-    stapling_check_response(cinf, *prsp);
-  } else {
-    // TODO: We should log the actual openssl error
-    Error("stapling_refresh_response: responder error");
+  if (port) {
+    BIO_set_conn_port(bio, port);
   }
-
-  if (!stapling_cache_response(*prsp, cinf)) {
-    Error("stapling_refresh_response: can not cache response");
-  } else {
-    Debug("ssl_ocsp", "stapling_refresh_response: successful refresh OCSP response");
+  BIO_set_nbio(bio, 1);
+  if (BIO_do_connect(bio) <= 0 && !BIO_should_retry(bio)) {
+    Debug("ssl_ocsp", "failed to connect to OCSP response server. host=%s port=%s path=%s", host, port, path);
+    return false;
   }
-  goto done;
 
-err:
-  rv = false;
-  Error("stapling_refresh_response: failed to refresh OCSP response");
+  ctx = OCSP_sendreq_new(bio, path, nullptr, -1);
+  if (!ctx) {
+    return false;
+  }
+  OCSP_REQ_CTX_add1_header(ctx, "Host", host);
+  OCSP_REQ_CTX_set1_req(ctx, req);
+  return true;
+}
 
-done:
-  if (req) {
-    OCSP_REQUEST_free(req);
+// Store @a rsp, which is @c nullptr if the query failed, for every certificate of the query.
+void
+OCSPQuery::finish(OCSP_RESPONSE *rsp)
+{
+  close();
+
+  if (rsp != nullptr) {
+    if (OCSP_response_status(rsp) == OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+      Debug("ssl_ocsp", "query response for %zu certificates received from %s", ids.size(), certs.front()->uri);
+    } else {
+      // TODO: We should log the actual openssl error
+      Error("OCSP responder error from %s", certs.front()->uri);
+    }
   }
-  if (*prsp) {
-    OCSP_RESPONSE_free(*prsp);
+
+  for (certinfo *cinf : certs) {
+    if (rsp != nullptr) {
+      stapling_check_response(cinf, rsp);
+    }
+    if (rsp != nullptr && stapling_cache_response(rsp, cinf)) {
+      Debug("ssl_ocsp", "Successfully refreshed OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
+      SSL_INCREMENT_DYN_STAT(ssl_ocsp_refreshed_cert_stat);
+    } else {
+      Error("Failed to refresh OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
+      SSL_INCREMENT_DYN_STAT(ssl_ocsp_refresh_cert_failure_stat);
+    }
   }
-  OPENSSL_free(host);
-  OPENSSL_free(path);
-  OPENSSL_free(port);
-  return rv;
+}
+
+static bool
+stapling_is_current(certinfo *cinf, time_t current_time)
+{
+  ink_mutex_acquire(&cinf->stapling_mutex);
+  bool current = !(cinf->resp_derlen == 0 || cinf->is_expire || cinf->expire_time < current_time);
+  ink_mutex_release(&cinf->stapling_mutex);
+  return current;
 }
 
 void
 ocsp_update()
 {
-  SSL_CTX *ctx;
-  OCSP_RESPONSE *resp = nullptr;
-  time_t current_time;
-
+  std::vector<std::unique_ptr<OCSPQuery>> queries;
+  std::unordered_map<std::string, OCSPQuery *> by_id;                     // Query for each responder and certificate ID.
+  std::unordered_map<std::string, std::vector<OCSPQuery *>> by_responder; // Queries for each responder.
+  std::vector<OCSPQuery *> running;
+  std::vector<struct pollfd> fds;
+  ink_hrtime pass_start    = Thread::get_hrtime_updated();
+  ink_hrtime slowest_query = 0;
+  time_t current_time      = time(nullptr);
+  size_t next              = 0;
+  size_t max_running       = std::max(1, SSLConfigParams::ssl_ocsp_max_concurrent_requests);
+
+  // The certificate information belongs to the contexts, hold the configuration until the pass is done.
+  // Contexts built on demand can be released meanwhile, so hold a reference to each of those as well.
   SSLCertificateConfig::scoped_config certLookup;
   const unsigned ctxCount = certLookup->count();
+  std::unordered_set<SSL_CTX *> seen;
+  std::vector<SSL_CTX *> lazy_refs;
 
   for (unsigned i = 0; i < ctxCount; i++) {
     SSLCertContext *cc = certLookup->get(i);
+    SSL_CTX *ctx       = nullptr;
     if (cc && cc->ctx) {
-      ctx               = cc->ctx;
-      certinfo *cinf    = nullptr;
-      certinfo_map *map = stapling_get_cert_info(ctx);
-      if (map) {
-        // Walk over all certs associated with this CTX
-        for (certinfo_map::iterator iter = map->begin(); iter != map->end(); ++iter) {
-          cinf = iter->second;
-          ink_mutex_acquire(&cinf->stapling_mutex);
-          current_time = time(nullptr);
-          if (cinf->resp_derlen == 0 || cinf->is_expire || cinf->expire_time < current_time) {
-            ink_mutex_release(&cinf->stapling_mutex);
-            if (stapling_refresh_response(cinf, &resp)) {
-              Debug("Successfully refreshed OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
-              SSL_INCREMENT_DYN_STAT(ssl_ocsp_refreshed_cert_stat);
-            } else {
-              Error("Failed to refresh OCSP for %s certificate. url=%s", cinf->certname, cinf->uri);
-              SSL_INCREMENT_DYN_STAT(ssl_ocsp_refresh_cert_failure_stat);
-            }
-          } else {
-            ink_mutex_release(&cinf->stapling_mutex);
-          }
+      ctx = cc->ctx;
+    } else if (cc && cc->lazy && (ctx = certLookup->peek_lazy_ctx(*cc->lazy)) != nullptr) {
+      lazy_refs.push_back(ctx);
+    }
+    // A context is in the lookup once for every name it has.
+    certinfo_map *map = (ctx && seen.insert(ctx).second) ? stapling_get_cert_info(ctx) : nullptr;
+    if (!map) {
+      continue;
+    }
+    // Walk over all certs associated with this CTX
+    for (auto &[cert, cinf] : *map) {
+      if (stapling_is_current(cinf, current_time)) {
+        continue;
+      }
+
+      unsigned char *der = nullptr;
+      int derlen         = i2d_OCSP_CERTID(cinf->cid, &der);
+      std::string id(cinf->uri);
+      if (derlen > 0) {
+        id.append(reinterpret_cast<char *>(der), derlen);
+        OPENSSL_free(der);
+      }
+
+      OCSPQuery *&query = by_id[id];
+      if (query == nullptr) {
+        // Add the ID to a query to the same responder for the same issuer, if one has room.
+        auto &batches = by_responder[cinf->uri];
+        auto spot     = std::find_if(batches.begin(), batches.end(), [cinf](OCSPQuery *q) {
+          return q->ids.size() < MAX_OCSP_QUERY_IDS && OCSP_id_issuer_cmp(q->ids.front(), cinf->cid) == 0;
+        });
+        if (spot != batches.end()) {
+          query = *spot;
+        } else {
+          query = batches.emplace_back(queries.emplace_back(new OCSPQuery).get());
         }
+        query->ids.push_back(cinf->cid);
+      }
+      query->certs.push_back(cinf);
+    }
+  }
+
+  Debug("ssl_ocsp", "refreshing OCSP responses with %zu queries", queries.size());
+
+  while (next < queries.size() || !running.empty()) {
+    ink_hrtime now = Thread::get_hrtime_updated();
+
+    while (next < queries.size() && running.size() < max_running) {
+      OCSPQuery *query = queries[next++].get();
+      if (query->open(now)) {
+        running.push_back(query);
+      } else {
+        query->finish(nullptr);
       }
     }
+
+    // Take each query as far as it will go without blocking.
+    fds.clear();
+    for (auto spot = running.begin(); spot != running.end();) {
+      OCSPQuery *query   = *spot;
+      OCSP_RESPONSE *rsp = nullptr;
+      int rv             = OCSP_sendreq_nbio(&rsp, query->ctx);
+
+      if (rv == -1 && BIO_should_retry(query->bio) &&
+          now < ink_hrtime_add(query->start, ink_hrtime_from_sec(SSLConfigParams::ssl_ocsp_request_timeout))) {
+        fds.push_back({static_cast<int>(BIO_get_fd(query->bio, nullptr)),
+                       static_cast<short>(BIO_should_write(query->bio) ? POLLOUT : POLLIN), 0});
+        ++spot;
+        continue;
+      }
+
+      slowest_query = std::max(slowest_query, now - query->start);
+      query->finish(rv == 1 ? rsp : nullptr);
+      OCSP_RESPONSE_free(rsp);
+      spot = running.erase(spot);
+    }
+
+    if (!fds.empty()) {
+      poll(fds.data(), fds.size(), 10);
+    }
+  }
+
+  current_time       = time(nullptr);
+  unsigned stale     = 0;
+  int64_t pass_msecs = ink_hrtime_to_msec(Thread::get_hrtime_updated() - pass_start);
+  for (auto &query : queries) {
+    for (certinfo *cinf : query->certs) {
+      stale += stapling_is_current(cinf, current_time) ? 0 : 1;
+    }
+  }
+  SSL_SET_COUNT_DYN_STAT(ssl_ocsp_stale_cert_stat, stale);
+  SSL_SET_COUNT_DYN_STAT(ssl_ocsp_refresh_time_stat, pass_msecs);
+  SSL_SET_COUNT_DYN_STAT(ssl_ocsp_slowest_query_time_stat, ink_hrtime_to_msec(slowest_query));
+
+  if (!queries.empty()) {
+    Note("OCSP refresh made %zu queries in %" PRId64 "ms, %u certificates without a current response", queries.size(), pass_msecs,
+         stale);
+  }
+
+  for (SSL_CTX *ctx : lazy_refs) {
+    SSLReleaseContext(ctx);
   }
 }
 
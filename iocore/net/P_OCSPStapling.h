@@ -30,5 +30,7 @@
 void ssl_stapling_ex_init();
 bool ssl_stapling_init_cert(SSL_CTX *ctx, X509 *cert, const char *certname);
 void ocsp_update();
+/// Run ocsp_update() on the OCSP thread as soon as it is free, for contexts built after startup. Does nothing if stapling is off.
+void ocsp_update_soon();
 int ssl_callback_ocsp_stapling(SSL *);
 #endif
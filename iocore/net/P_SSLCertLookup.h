@@ -23,8 +23,16 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 #include "ProxyConfig.h"
 #include "P_SSLUtils.h"
+#include "tscore/List.h"
 
 struct SSLConfigParams;
 struct SSLContextStorage;
@@ -39,6 +47,36 @@ struct ssl_ticket_key_block {
   unsigned num_keys;
   ssl_ticket_key_t keys[];
 };
+
+/** An ssl_multicert.config line whose context is built on first use.
+
+    With proxy.config.ssl.server.multicert.lazy_load only the names in the certificates are read when
+    the configuration is loaded. Every name maps to an @c SSLCertContext without a context that refers
+    to the line, and the context is built the first time one of the names is requested. A bounded
+    number of built contexts is kept, least recently used first out.
+*/
+struct SSLLazyContext {
+  explicit SSLLazyContext(std::string_view line) : config_line(line) {}
+  ~SSLLazyContext();
+
+  std::string config_line; ///< The ssl_multicert.config line to build the context from.
+  std::mutex build_mutex;  ///< Held while building, so each context is built once.
+
+  // The rest is protected by the lookup's lazy mutex.
+  SSL_CTX *ctx = nullptr; ///< The built context, if it is live.
+  bool failed  = false;   ///< The context could not be built, don't keep trying.
+  LINK(SSLLazyContext, link);
+};
+
+/** A context built from an ssl_multicert.config line, kept so that the next reload can use it again
+    if neither the line nor anything the context was built from has changed.
+*/
+struct SSLReusableContext {
+  SSL_CTX *ctx = nullptr;                   ///< Reference to the context.
+  std::vector<X509 *> certs;                ///< References to the server certificates in the context.
+  ssl_ticket_key_block *keyblock = nullptr; ///< Ticket keys of an address mapped context, owned by the lookup.
+};
+
 /** A certificate context.
 
     This holds data about a certificate and how it is used by the SSL logic. Current this is mainly
@@ -66,9 +104,10 @@ struct SSLCertContext {
   SSLCertContext(SSL_CTX *c, Option o, ssl_ticket_key_block *kb) : ctx(c), opt(o), keyblock(kb) {}
   void release();
 
-  SSL_CTX *ctx;                   ///< openSSL context.
-  Option opt;                     ///< Special handling option.
-  ssl_ticket_key_block *keyblock; ///< session keys associated with this address
+  SSL_CTX *ctx;                         ///< openSSL context.
+  Option opt;                           ///< Special handling option.
+  ssl_ticket_key_block *keyblock;       ///< session keys associated with this address
+  std::shared_ptr<SSLLazyContext> lazy; ///< If @a ctx is built on first use, the line to build it from.
 };
 
 struct SSLCertLookup : public ConfigInfo {
@@ -99,11 +138,49 @@ struct SSLCertLookup : public ConfigInfo {
     return ssl_default;
   }
 
+  /** Get the context for a certificate loaded on demand, building it if it is not live.
+      @return A new reference to the context, which the caller must free, or @c nullptr if the
+      context can't be built.
+  */
+  SSL_CTX *get_lazy_ctx(SSLLazyContext &lazy) const;
+
+  /** Get the context for a certificate loaded on demand only if it is live, without building it or
+      making it the most recently used.
+      @return A new reference to the context, which the caller must free, or @c nullptr.
+  */
+  SSL_CTX *peek_lazy_ctx(SSLLazyContext &lazy) const;
+
   unsigned count() const;
   SSLCertContext *get(unsigned i) const;
 
+  /** Keep a context built from an ssl_multicert.config line for the next reload.
+      @a fingerprint identifies the line and the state of the files the context was built from.
+  */
+  void keep_reusable(std::string const &fingerprint, SSL_CTX *ctx, std::vector<X509 *> const &certs,
+                     ssl_ticket_key_block *keyblock);
+
+  /// @return The context kept for @a fingerprint, or @c nullptr if there is none.
+  const SSLReusableContext *find_reusable(std::string const &fingerprint) const;
+
+  unsigned contexts_built  = 0; ///< Contexts built while loading this configuration.
+  unsigned contexts_reused = 0; ///< Contexts taken from the previous configuration.
+
+  /// The most contexts loaded on demand to keep live.
+  unsigned lazy_max_contexts = 0;
+
   SSLCertLookup();
   ~SSLCertLookup() override;
+
+private:
+  /// Take a reference to a live context and make it the most recently used. Requires @a lazy_mutex.
+  SSL_CTX *use_lazy_ctx(SSLLazyContext &lazy) const;
+
+  // Contexts built on demand are an updatable cache on an otherwise immutable config object.
+  mutable std::mutex lazy_mutex;
+  mutable Queue<SSLLazyContext> lazy_live; ///< Live contexts, least recently used first.
+  mutable unsigned lazy_live_count = 0;
+
+  std::unordered_map<std::string, SSLReusableContext> reusable;
 };
 
 void ticket_block_free(void *ptr);
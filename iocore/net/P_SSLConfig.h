@@ -71,6 +71,9 @@ struct SSLConfigParams : public ConfigInfo {
   char *cipherSuite;
   char *client_cipherSuite;
   int configExitOnLoadError;
+  int configLazyLoad;
+  int configLazyMaxContexts;
+  unsigned generation = 0; ///< Distinct for each load of the configuration.
   int clientCertLevel;
   int verify_depth;
   int ssl_session_cache; // SSL_SESSION_CACHE_MODE
@@ -99,16 +102,20 @@ struct SSLConfigParams : public ConfigInfo {
 
   static int ssl_maxrecord;
   static bool ssl_allow_client_renegotiation;
+  static bool ssl_ktls_enabled;
 
   static bool ssl_ocsp_enabled;
   static int ssl_ocsp_cache_timeout;
   static int ssl_ocsp_request_timeout;
   static int ssl_ocsp_update_period;
+  static int ssl_ocsp_max_concurrent_requests;
   static int ssl_handshake_timeout_in;
 
   static size_t session_cache_number_buckets;
   static size_t session_cache_max_bucket_size;
   static bool session_cache_skip_on_lock_contention;
+  static int session_cache_sync_frequency;
+  static char *session_cache_sync_filename; // full path, set once at startup
 
   static IpMap *proxy_protocol_ipmap;
 
@@ -116,6 +123,11 @@ struct SSLConfigParams : public ConfigInfo {
   static load_ssl_file_func load_ssl_file_cb;
 
   static int async_handshake_enabled;
+  static int async_crypto_threads;
+
+  static int server_max_early_data;
+  static int early_data_replay_window;
+  static int early_data_replay_cache_size;
   static char *engine_conf_file;
 
   SSL_CTX *client_ctx;
@@ -65,6 +65,10 @@
 #define SSL_MAX_TLS_RECORD_SIZE 16383 // 2^14 - 1
 #define SSL_DEF_TLS_RECORD_BYTE_THRESHOLD 1000000
 #define SSL_DEF_TLS_RECORD_MSEC_THRESHOLD 1000
+// When TCP_INFO is available, records are sized to whole segments of the space left in the
+// congestion window, less this worst case TLS overhead (header, explicit IV, MAC and padding).
+#define SSL_TLS_RECORD_OVERHEAD 100
+#define SSL_TLS_RECORD_SIZE_BUCKETS 5 // <= 1500, <= 4K, <= 8K, < 16K and full size records
 
 class SSLNextProtocolSet;
 class SSLNextProtocolAccept;
@@ -160,6 +164,20 @@ public:
     return npnEndpoint;
   }
 
+  /// The protocol the server selected by ALPN on an outbound connection, empty if none.
+  std::string_view
+  get_alpn_selected() const
+  {
+    const unsigned char *proto = nullptr;
+    unsigned len               = 0;
+#if TS_USE_TLS_ALPN
+    if (ssl) {
+      SSL_get0_alpn_selected(ssl, &proto, &len);
+    }
+#endif
+    return {reinterpret_cast<const char *>(proto), len};
+  }
+
   bool
   getSSLClientRenegotiationAbort() const
   {
@@ -357,6 +375,26 @@ public:
   ink_hrtime sslHandshakeEndTime   = 0;
   ink_hrtime sslLastWriteTime      = 0;
   int64_t sslTotalBytesSent        = 0;
+
+  /// TLS 1.3 early data taken in during the handshake, read ahead of anything that follows it.
+  MIOBuffer *earlyDataBuf         = nullptr;
+  IOBufferReader *earlyDataReader = nullptr;
+  int64_t earlyDataLen            = 0; ///< Bytes of early data accepted.
+
+  /** Whether a new transaction may have been sent as early data.
+
+      That is the first transaction on a connection with early data, and any started before the
+      client finishes the handshake. Each call counts as a transaction.
+  */
+  bool takeEarlyData();
+
+  /// The session started on the early data and the handshake still waits for the client's Finished.
+  bool
+  isEarlyDataPending() const
+  {
+    return earlyDataPending;
+  }
+
   // The serverName is either a pointer to the name fetched from the
   // SSL object or the empty string.  Therefore, we do not allocate
   // extra memory for this value.  If plugins in the future can set the
@@ -376,10 +414,17 @@ public:
 private:
   std::string_view map_tls_protocol_to_tag(const char *proto_string) const;
   bool update_rbio(bool move_to_socket);
+  int sslAcceptWithEarlyData();
+  void checkKTLSSend();
+  uint32_t tcp_info_record_size(int msec_since_last_write);
 
   enum SSLHandshakeStatus sslHandshakeStatus = SSL_HANDSHAKE_ONGOING;
   bool sslClientRenegotiationAbort           = false;
   bool sslSessionCacheHit                    = false;
+  bool sslKTLSSend                           = false; ///< Kernel TLS encrypts what we write.
+  bool earlyDataFinish                       = false;
+  bool earlyDataPending                      = false;
+  bool earlyDataTaken                        = false; ///< A transaction has been given the early data.
   MIOBuffer *handShakeBuffer                 = nullptr;
   IOBufferReader *handShakeHolder            = nullptr;
   IOBufferReader *handShakeReader            = nullptr;
@@ -413,6 +458,9 @@ private:
   char *tunnel_host                = nullptr;
   in_port_t tunnel_port            = 0;
   bool tunnel_decrypt              = false;
+
+  /// Records written on this connection, by size.
+  uint32_t sslRecordSizeHistogram[SSL_TLS_RECORD_SIZE_BUCKETS] = {0};
 };
 
 typedef int (SSLNetVConnection::*SSLNetVConnHandler)(int, void *);
@@ -37,6 +37,7 @@
 #include <vector>
 #include <strings.h>
 #include "YamlSNIConfig.h"
+#include "SSLNameTrie.h"
 
 #include <unordered_map>
 
@@ -113,6 +114,15 @@ struct SNIConfigParams : public ConfigInfo {
   int Initialize();
   void loadSNIConfig();
   const actionVector *get(const std::string &servername) const;
+
+private:
+  /// @return The index of the first item matching @a servername, or -1 if none does.
+  int findItem(const std::string &servername, bool match_empty) const;
+
+  /// Items whose fqdn is a plain name or "*." and a domain, indexed by position in the lists above.
+  SSLNameTrie fqdn_index;
+  /// Items with any other fqdn, which are matched by their regular expression.
+  std::vector<int> unindexed_items;
 };
 
 struct SNIConfig {
@@ -35,6 +35,20 @@
 
 #include <unordered_map>
 
+// Kernel TLS offload needs an OpenSSL built with kTLS support (3.0 or later).
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+#define TS_USE_KTLS 1
+#else
+#define TS_USE_KTLS 0
+#endif
+
+// TLS 1.3 early data needs OpenSSL 1.1.1 or later.
+#if defined(SSL_READ_EARLY_DATA_SUCCESS)
+#define TS_USE_TLS_EARLY_DATA 1
+#else
+#define TS_USE_TLS_EARLY_DATA 0
+#endif
+
 struct SSLConfigParams;
 struct SSLCertLookup;
 class SSLNetVConnection;
@@ -81,6 +95,22 @@ enum SSL_Stats {
   ssl_session_cache_eviction,
   ssl_session_cache_lock_contention,
   ssl_session_cache_new_session,
+  ssl_session_cache_lookup_time,
+  ssl_session_cache_sync_sessions,
+  ssl_session_cache_sync_duration,
+  ssl_session_cache_load_duration,
+  ssl_lazy_context_build,
+  ssl_lazy_context_build_failure,
+  ssl_lazy_context_build_time,
+  ssl_lazy_context_hit,
+  ssl_lazy_context_eviction,
+  ssl_multicert_load_time,
+  ssl_multicert_contexts_built,
+  ssl_multicert_contexts_reused,
+  ssl_async_crypto_offloaded,
+  ssl_early_data_accepted,
+  ssl_early_data_rejected,
+  ssl_early_data_replayed,
 
   /* error stats */
   ssl_error_want_write,
@@ -98,6 +128,13 @@ enum SSL_Stats {
   ssl_ocsp_unknown_cert_stat,
   ssl_ocsp_refreshed_cert_stat,
   ssl_ocsp_refresh_cert_failure_stat,
+  ssl_ocsp_stale_cert_stat,
+  ssl_ocsp_refresh_time_stat,
+  ssl_ocsp_slowest_query_time_stat,
+
+  /* kernel TLS stats */
+  ssl_ktls_tx_connections_stat,
+  ssl_ktls_tx_bytes_stat,
 
   ssl_cipher_stats_start = 100,
   ssl_cipher_stats_end   = 300,
@@ -124,9 +161,18 @@ SSL_CTX *SSLDefaultServerContext();
 // Create a new SSL server context fully configured.
 SSL_CTX *SSLCreateServerContext(const SSLConfigParams *params);
 
+// Create the context for an ssl_multicert.config line that was loaded on demand.
+SSL_CTX *SSLCreateLazyContext(const char *config_line);
+
 // Initialize the SSL library.
 void SSLInitializeLibrary();
 
+// Start the threads that private key operations are offloaded to, if configured.
+void SSLAsyncCryptoStart(size_t stacksize);
+
+// Have the private key of a server context offload its operations to the crypto threads.
+bool SSLAsyncCryptoUseKey(SSL_CTX *ctx);
+
 // Initialize SSL library based on configuration settings
 void SSLPostConfigInitialize();
 
@@ -141,6 +187,8 @@ void SSLReleaseContext(SSL_CTX *ctx);
 ssl_error_t SSLWriteBuffer(SSL *ssl, const void *buf, int64_t nbytes, int64_t &nwritten);
 ssl_error_t SSLReadBuffer(SSL *ssl, void *buf, int64_t nbytes, int64_t &nread);
 ssl_error_t SSLAccept(SSL *ssl);
+ssl_error_t SSLReadEarlyData(SSL *ssl, void *buf, int64_t nbytes, int64_t &nread, bool &finished);
+ssl_error_t SSLWriteEarlyData(SSL *ssl, const void *buf, int64_t nbytes, int64_t &nwritten);
 ssl_error_t SSLConnect(SSL *ssl);
 
 // Log an SSL error.
@@ -164,8 +212,9 @@ const char *SSLErrorName(int ssl_error);
 // Log a SSL network buffer.
 void SSLDebugBufferPrint(const char *tag, const char *buffer, unsigned buflen, const char *message);
 
-// Load the SSL certificate configuration.
-bool SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *lookup);
+// Load the SSL certificate configuration. Contexts in @a previous that nothing has changed for are reused.
+bool SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *lookup,
+                                      const SSLCertLookup *previous = nullptr);
 
 // Attach a SSL NetVC back pointer to a SSL session.
 void SSLNetVCAttach(SSL *ssl, SSLNetVConnection *vc);
@@ -176,6 +225,9 @@ void SSLNetVCDetach(SSL *ssl);
 // Return the SSLNetVConnection (if any) attached to this SSL session.
 SSLNetVConnection *SSLNetVCAccess(const SSL *ssl);
 
+// Return true if the session is past its timeout.
+bool ssl_session_timed_out(SSL_SESSION *session);
+
 void setClientCertLevel(SSL *ssl, uint8_t certLevel);
 void setTLSValidProtocols(SSL *ssl, unsigned long proto_mask, unsigned long max_mask);
 
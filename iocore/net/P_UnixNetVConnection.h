@@ -71,6 +71,7 @@ NetVCOptions::reset()
   ssl_client_cert_name        = nullptr;
   ssl_client_private_key_name = nullptr;
   ssl_client_ca_cert_name     = nullptr;
+  alpn_protos                 = {};
 }
 
 inline void
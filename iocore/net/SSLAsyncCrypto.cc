@@ -0,0 +1,356 @@
+/** @file
+
+  Offload of TLS private key operations to a pool of crypto threads.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/* Without a hardware engine, the RSA and ECDSA signatures of a handshake are computed on the net
+   thread and hold up every other connection on it. With proxy.config.ssl.async.crypto.threads set,
+   server private keys get RSA and EC methods that, when called from inside an OpenSSL async job,
+   queue the operation to a crypto thread and pause the job. The crypto thread signals a file
+   descriptor registered in the job's wait context, which the net thread polls just as it would for
+   an async engine (see SSLNetVConnection::sslServerHandShakeEvent), and resuming the handshake picks
+   up the result.
+*/
+
+#include "P_Net.h"
+#include "P_SSLConfig.h"
+#include "P_SSLUtils.h"
+
+#if TS_USE_TLS_ASYNC
+
+#include <openssl/async.h>
+#include <openssl/ec.h>
+#include <openssl/rsa.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if HAVE_EVENTFD
+#include <sys/eventfd.h>
+#endif
+
+namespace
+{
+EventType ET_SSL_CRYPTO          = -1;
+RSA_METHOD *async_rsa_method     = nullptr;
+EC_KEY_METHOD *async_ec_method   = nullptr;
+const char async_crypto_wait_key = 0; ///< Identifies our descriptor in a job's wait context.
+
+using ec_sign_func = int (*)(int type, const unsigned char *dgst, int dlen, unsigned char *sig, unsigned int *siglen,
+                             const BIGNUM *kinv, const BIGNUM *r, EC_KEY *eckey);
+
+/** A private key operation run on a crypto thread.
+
+    The operation owns copies of its input and output, and references to its key, because the SSL can
+    be freed while its job is paused. It is released once by the crypto thread when done and once by
+    the job, either after it resumes or when the job's wait context is freed.
+*/
+struct SSLCryptoOp : public Continuation {
+  enum Kind { RSA_PRIV_ENC, RSA_PRIV_DEC, EC_SIGN };
+
+  SSLCryptoOp(Kind k, const unsigned char *from, int flen, int out_len)
+    : Continuation(new_ProxyMutex()), kind(k), in(from, from + flen), out(out_len)
+  {
+    SET_HANDLER(&SSLCryptoOp::mainEvent);
+  }
+
+  ~SSLCryptoOp() override
+  {
+    RSA_free(rsa);
+    EC_KEY_free(ec);
+    if (wait_fd >= 0) {
+      close(wait_fd);
+    }
+    if (signal_fd >= 0 && signal_fd != wait_fd) {
+      close(signal_fd);
+    }
+  }
+
+  bool
+  open_fds()
+  {
+#if HAVE_EVENTFD
+    wait_fd = signal_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return wait_fd >= 0;
+#else
+    int fds[2];
+    if (pipe(fds) < 0) {
+      return false;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    wait_fd   = fds[0];
+    signal_fd = fds[1];
+    return true;
+#endif
+  }
+
+  int
+  mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    switch (kind) {
+    case RSA_PRIV_ENC:
+      result = RSA_meth_get_priv_enc(RSA_PKCS1_OpenSSL())(in.size(), in.data(), out.data(), rsa, padding);
+      break;
+    case RSA_PRIV_DEC:
+      result = RSA_meth_get_priv_dec(RSA_PKCS1_OpenSSL())(in.size(), in.data(), out.data(), rsa, padding);
+      break;
+    case EC_SIGN:
+      result = ec_sign(type, in.data(), in.size(), out.data(), &siglen, nullptr, nullptr, ec);
+      break;
+    }
+
+    done.store(true, std::memory_order_release);
+#if HAVE_EVENTFD
+    uint64_t one = 1;
+#else
+    char one = 1;
+#endif
+    ATS_UNUSED_RETURN(write(signal_fd, &one, sizeof(one)));
+    release();
+    return EVENT_DONE;
+  }
+
+  void
+  release()
+  {
+    if (refcount.fetch_sub(1) == 1) {
+      delete this;
+    }
+  }
+
+  Kind kind;
+  std::vector<unsigned char> in;
+  std::vector<unsigned char> out;
+  RSA *rsa             = nullptr;
+  EC_KEY *ec           = nullptr;
+  ec_sign_func ec_sign = nullptr;
+  int padding          = 0;
+  int type             = 0;
+  unsigned siglen      = 0;
+  int result           = -1;
+  int wait_fd          = -1;
+  int signal_fd        = -1;
+  std::atomic<bool> done{false};
+  std::atomic<int> refcount{2};
+};
+
+// The wait context is being freed with the job still paused on @a custom_data.
+void
+ssl_async_crypto_cleanup(ASYNC_WAIT_CTX * /* ctx ATS_UNUSED */, const void * /* key ATS_UNUSED */, OSSL_ASYNC_FD /* fd ATS_UNUSED */,
+                         void *custom_data)
+{
+  static_cast<SSLCryptoOp *>(custom_data)->release();
+}
+
+/** Run @a op on a crypto thread and pause the current job until it is done.
+    @return @c true if @a op ran, in which case the caller must release it, @c false if it could
+    not be queued and has been freed.
+*/
+bool
+ssl_async_crypto_run(ASYNC_JOB *job, SSLCryptoOp *op)
+{
+  ASYNC_WAIT_CTX *waitctx = ASYNC_get_wait_ctx(job);
+
+  if (!op->open_fds() ||
+      !ASYNC_WAIT_CTX_set_wait_fd(waitctx, &async_crypto_wait_key, op->wait_fd, op, ssl_async_crypto_cleanup)) {
+    delete op;
+    return false;
+  }
+
+  SSL_INCREMENT_DYN_STAT(ssl_async_crypto_offloaded);
+  eventProcessor.schedule_imm(op, ET_SSL_CRYPTO);
+
+  // The job can be resumed before the result is ready, so check each time.
+  while (!op->done.load(std::memory_order_acquire)) {
+    if (!ASYNC_pause_job()) {
+      std::this_thread::yield();
+    }
+  }
+
+  // The wait context no longer refers to the operation, so the reference it had is now ours.
+  ASYNC_WAIT_CTX_clear_fd(waitctx, &async_crypto_wait_key);
+  return true;
+}
+
+int
+ssl_async_rsa_private(SSLCryptoOp::Kind kind, int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+  ASYNC_JOB *job = ASYNC_get_current_job();
+  auto inline_op = kind == SSLCryptoOp::RSA_PRIV_ENC ? RSA_meth_get_priv_enc(RSA_PKCS1_OpenSSL()) :
+                                                       RSA_meth_get_priv_dec(RSA_PKCS1_OpenSSL());
+
+  if (job == nullptr || ET_SSL_CRYPTO < 0) {
+    return inline_op(flen, from, to, rsa, padding);
+  }
+
+  SSLCryptoOp *op = new SSLCryptoOp(kind, from, flen, RSA_size(rsa));
+  RSA_up_ref(rsa);
+  op->rsa     = rsa;
+  op->padding = padding;
+  if (!ssl_async_crypto_run(job, op)) {
+    return inline_op(flen, from, to, rsa, padding);
+  }
+
+  int result = op->result;
+  if (result > 0) {
+    memcpy(to, op->out.data(), result);
+  }
+  op->release();
+  return result;
+}
+
+int
+ssl_async_rsa_priv_enc(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+  return ssl_async_rsa_private(SSLCryptoOp::RSA_PRIV_ENC, flen, from, to, rsa, padding);
+}
+
+int
+ssl_async_rsa_priv_dec(int flen, const unsigned char *from, unsigned char *to, RSA *rsa, int padding)
+{
+  return ssl_async_rsa_private(SSLCryptoOp::RSA_PRIV_DEC, flen, from, to, rsa, padding);
+}
+
+int
+ssl_async_ec_sign(int type, const unsigned char *dgst, int dlen, unsigned char *sig, unsigned int *siglen, const BIGNUM *kinv,
+                  const BIGNUM *r, EC_KEY *eckey)
+{
+  ASYNC_JOB *job       = ASYNC_get_current_job();
+  ec_sign_func ec_sign = nullptr;
+
+  EC_KEY_METHOD_get_sign(EC_KEY_OpenSSL(), &ec_sign, nullptr, nullptr);
+
+  // TLS never supplies precomputed values, leave any such call be.
+  if (job == nullptr || ET_SSL_CRYPTO < 0 || kinv != nullptr || r != nullptr) {
+    return ec_sign(type, dgst, dlen, sig, siglen, kinv, r, eckey);
+  }
+
+  SSLCryptoOp *op = new SSLCryptoOp(SSLCryptoOp::EC_SIGN, dgst, dlen, ECDSA_size(eckey));
+  EC_KEY_up_ref(eckey);
+  op->ec      = eckey;
+  op->ec_sign = ec_sign;
+  op->type    = type;
+  if (!ssl_async_crypto_run(job, op)) {
+    return ec_sign(type, dgst, dlen, sig, siglen, kinv, r, eckey);
+  }
+
+  int result = op->result;
+  if (result > 0) {
+    memcpy(sig, op->out.data(), op->siglen);
+    *siglen = op->siglen;
+  }
+  op->release();
+  return result;
+}
+
+// Keys are loaded before the crypto threads start, until then the methods compute inline.
+void
+ssl_async_crypto_init_methods()
+{
+  int (*sign_setup)(EC_KEY *, BN_CTX *, BIGNUM **, BIGNUM **)                                     = nullptr;
+  ECDSA_SIG *(*sign_sig)(const unsigned char *, int, const BIGNUM *, const BIGNUM *, EC_KEY *) = nullptr;
+
+  async_rsa_method = RSA_meth_dup(RSA_PKCS1_OpenSSL());
+  RSA_meth_set1_name(async_rsa_method, "ATS async crypto RSA method");
+  RSA_meth_set_priv_enc(async_rsa_method, ssl_async_rsa_priv_enc);
+  RSA_meth_set_priv_dec(async_rsa_method, ssl_async_rsa_priv_dec);
+
+  async_ec_method = EC_KEY_METHOD_new(EC_KEY_OpenSSL());
+  EC_KEY_METHOD_get_sign(EC_KEY_OpenSSL(), nullptr, &sign_setup, &sign_sig);
+  EC_KEY_METHOD_set_sign(async_ec_method, ssl_async_ec_sign, sign_setup, sign_sig);
+}
+
+} // namespace
+
+void
+SSLAsyncCryptoStart(size_t stacksize)
+{
+  if (SSLConfigParams::async_crypto_threads <= 0) {
+    return;
+  }
+
+  ET_SSL_CRYPTO = eventProcessor.spawn_event_threads("ET_SSL_CRYPTO", SSLConfigParams::async_crypto_threads, stacksize);
+  Note("offloading TLS private key operations to %d crypto threads", SSLConfigParams::async_crypto_threads);
+}
+
+bool
+SSLAsyncCryptoUseKey(SSL_CTX *ctx)
+{
+  static std::once_flag methods_once;
+  EVP_PKEY *pkey    = SSL_CTX_get0_privatekey(ctx);
+  EVP_PKEY *wrapped = nullptr;
+
+  std::call_once(methods_once, ssl_async_crypto_init_methods);
+  if (pkey == nullptr) {
+    return false;
+  }
+
+  switch (EVP_PKEY_base_id(pkey)) {
+  case EVP_PKEY_RSA: {
+    RSA *rsa = EVP_PKEY_get1_RSA(pkey);
+    if (rsa && RSA_set_method(rsa, async_rsa_method) && (wrapped = EVP_PKEY_new()) && EVP_PKEY_assign_RSA(wrapped, rsa)) {
+      rsa = nullptr;
+    }
+    RSA_free(rsa);
+    break;
+  }
+  case EVP_PKEY_EC: {
+    EC_KEY *ec = EVP_PKEY_get1_EC_KEY(pkey);
+    if (ec && EC_KEY_set_method(ec, async_ec_method) && (wrapped = EVP_PKEY_new()) && EVP_PKEY_assign_EC_KEY(wrapped, ec)) {
+      ec = nullptr;
+    }
+    EC_KEY_free(ec);
+    break;
+  }
+  default:
+    // Other key types are computed on the net thread as before.
+    return false;
+  }
+
+  bool ok = wrapped && SSL_CTX_use_PrivateKey(ctx, wrapped);
+  EVP_PKEY_free(wrapped);
+  if (!ok) {
+    SSLError("failed to set up private key operation offload");
+  }
+  return ok;
+}
+
+#else /* !TS_USE_TLS_ASYNC */
+
+void
+SSLAsyncCryptoStart(size_t /* stacksize ATS_UNUSED */)
+{
+  if (SSLConfigParams::async_crypto_threads > 0) {
+    Warning("proxy.config.ssl.async.crypto.threads is set, but this version of OpenSSL does not support async jobs");
+  }
+}
+
+bool
+SSLAsyncCryptoUseKey(SSL_CTX * /* ctx ATS_UNUSED */)
+{
+  return false;
+}
+
+#endif /* TS_USE_TLS_ASYNC */
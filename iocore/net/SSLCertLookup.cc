@@ -26,6 +26,8 @@
 #include "P_SSLCertLookup.h"
 #include "P_SSLUtils.h"
 #include "P_SSLConfig.h"
+#include "P_OCSPStapling.h"
+#include "SSLNameTrie.h"
 #include "I_EventSystem.h"
 #include "tscore/I_Layout.h"
 #include "tscore/MatcherUtils.h"
@@ -39,6 +41,10 @@
 #include <vector>
 #include <algorithm>
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define SSL_CTX_up_ref(c) CRYPTO_add(&(c)->references, 1, CRYPTO_LOCK_SSL_CTX)
+#endif
+
 // Check if the ticket_key callback #define is available, and if so, enable session tickets.
 #ifdef SSL_CTX_set_tlsext_ticket_key_cb
 
@@ -99,7 +105,6 @@ public:
   /// @return @a idx
   int insert(const char *name, int idx);
   SSLCertContext *lookup(const char *name);
-  void printWildDomains() const;
   unsigned
   count() const
   {
@@ -128,11 +133,9 @@ private:
     LINK(ContextRef, link); ///< Require by @c Trie
   };
 
-  /// We can only match one layer with the wildcards
-  /// This table stores the wildcarded subdomain
-  std::unordered_map<std::string, int> wilddomains;
-  /// Contexts stored by IP address or FQDN
-  std::unordered_map<std::string, int> hostnames;
+  /// Contexts stored by IP address, FQDN or wildcarded subdomain.
+  /// We can only match one layer with the wildcards.
+  SSLNameTrie names;
   /// List for cleanup.
   /// Exactly one pointer to each SSL context is stored here.
   std::vector<SSLCertContext> ctx_store;
@@ -243,11 +246,22 @@ SSLCertContext::release()
   ctx = nullptr;
 }
 
+SSLLazyContext::~SSLLazyContext()
+{
+  SSLReleaseContext(ctx);
+}
+
 SSLCertLookup::SSLCertLookup() : ssl_storage(new SSLContextStorage()), ssl_default(nullptr), is_valid(true) {}
 
 SSLCertLookup::~SSLCertLookup()
 {
   delete this->ssl_storage;
+  for (auto &&it : reusable) {
+    SSLReleaseContext(it.second.ctx);
+    for (auto cert : it.second.certs) {
+      X509_free(cert);
+    }
+  }
 }
 
 SSLCertContext *
@@ -289,6 +303,107 @@ SSLCertLookup::insert(const IpEndpoint &address, SSLCertContext const &cc)
   return this->ssl_storage->insert(key.get(), cc);
 }
 
+SSL_CTX *
+SSLCertLookup::use_lazy_ctx(SSLLazyContext &lazy) const
+{
+  lazy_live.remove(&lazy);
+  lazy_live.enqueue(&lazy);
+  SSL_CTX_up_ref(lazy.ctx);
+  return lazy.ctx;
+}
+
+SSL_CTX *
+SSLCertLookup::get_lazy_ctx(SSLLazyContext &lazy) const
+{
+  {
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    if (lazy.ctx) {
+      SSL_INCREMENT_DYN_STAT(ssl_lazy_context_hit);
+      return use_lazy_ctx(lazy);
+    } else if (lazy.failed) {
+      return nullptr;
+    }
+  }
+
+  // Build outside the lookup lock so other contexts can be used meanwhile. Anyone else wanting this
+  // one waits for it to be built.
+  std::lock_guard<std::mutex> build_lock(lazy.build_mutex);
+  {
+    std::lock_guard<std::mutex> lock(lazy_mutex);
+    if (lazy.ctx) {
+      SSL_INCREMENT_DYN_STAT(ssl_lazy_context_hit);
+      return use_lazy_ctx(lazy);
+    } else if (lazy.failed) {
+      return nullptr;
+    }
+  }
+
+  ink_hrtime start = Thread::get_hrtime_updated();
+  SSL_CTX *ctx     = SSLCreateLazyContext(lazy.config_line.c_str());
+  SSL_INCREMENT_DYN_STAT_EX(ssl_lazy_context_build_time, Thread::get_hrtime_updated() - start);
+
+  std::lock_guard<std::mutex> lock(lazy_mutex);
+  if (ctx == nullptr) {
+    SSL_INCREMENT_DYN_STAT(ssl_lazy_context_build_failure);
+    lazy.failed = true;
+    return nullptr;
+  }
+  SSL_INCREMENT_DYN_STAT(ssl_lazy_context_build);
+
+  lazy.ctx = ctx;
+  ++lazy_live_count;
+  ctx = use_lazy_ctx(lazy);
+#if TS_USE_TLS_OCSP
+  // Get an OCSP response for the new context now rather than at the next periodic refresh.
+  ocsp_update_soon();
+#endif
+
+  // Contexts in use by connections have their own references, so it's safe to drop ours.
+  while (lazy_live_count > lazy_max_contexts && lazy_live.head != &lazy) {
+    SSLLazyContext *oldest = lazy_live.pop();
+    Debug("ssl", "releasing SSL_CTX %p built on demand, %u are live", oldest->ctx, lazy_live_count);
+    SSLReleaseContext(oldest->ctx);
+    oldest->ctx = nullptr;
+    --lazy_live_count;
+    SSL_INCREMENT_DYN_STAT(ssl_lazy_context_eviction);
+  }
+
+  return ctx;
+}
+
+SSL_CTX *
+SSLCertLookup::peek_lazy_ctx(SSLLazyContext &lazy) const
+{
+  std::lock_guard<std::mutex> lock(lazy_mutex);
+  if (lazy.ctx) {
+    SSL_CTX_up_ref(lazy.ctx);
+  }
+  return lazy.ctx;
+}
+
+void
+SSLCertLookup::keep_reusable(std::string const &fingerprint, SSL_CTX *ctx, std::vector<X509 *> const &certs,
+                             ssl_ticket_key_block *keyblock)
+{
+  // Identical lines build identical contexts, so the first one is as good as any.
+  if (auto [spot, added] = reusable.try_emplace(fingerprint); added) {
+    SSL_CTX_up_ref(ctx);
+    spot->second.ctx = ctx;
+    for (auto cert : certs) {
+      X509_up_ref(cert);
+      spot->second.certs.push_back(cert);
+    }
+    spot->second.keyblock = keyblock;
+  }
+}
+
+const SSLReusableContext *
+SSLCertLookup::find_reusable(std::string const &fingerprint) const
+{
+  auto spot = reusable.find(fingerprint);
+  return spot == reusable.end() ? nullptr : &spot->second;
+}
+
 unsigned
 SSLCertLookup::count() const
 {
@@ -393,68 +508,40 @@ int
 SSLContextStorage::insert(const char *name, int idx)
 {
   ats_wildcard_matcher wildcard;
-  char lower_case_name[TS_MAX_HOST_NAME_LEN + 1];
-  make_to_lower_case(name, lower_case_name, sizeof(lower_case_name));
-  if (wildcard.match(lower_case_name)) {
+
+  if (wildcard.match(name)) {
     // Strip the wildcard and store the subdomain
-    const char *subdomain = index(lower_case_name, '*');
+    const char *subdomain = index(name, '*');
     if (subdomain && subdomain[1] == '.') {
       subdomain += 2; // Move beyond the '.'
     } else {
       subdomain = nullptr;
     }
     if (subdomain) {
-      if (auto it = this->wilddomains.find(subdomain); it != this->wilddomains.end()) {
-        Debug("ssl", "previously indexed '%s' with SSL_CTX #%d, cannot index it with SSL_CTX #%d now", lower_case_name, it->second,
-              idx);
+      if (int prev = this->names.insert_wildcard(subdomain, idx); prev != idx) {
+        Debug("ssl", "previously indexed '%s' with SSL_CTX #%d, cannot index it with SSL_CTX #%d now", name, prev, idx);
         idx = -1;
       } else {
-        this->wilddomains.emplace(subdomain, idx);
-        Debug("ssl", "indexed '%s' with SSL_CTX %p [%d]", lower_case_name, this->ctx_store[idx].ctx, idx);
+        Debug("ssl", "indexed '%s' with SSL_CTX %p [%d]", name, this->ctx_store[idx].ctx, idx);
       }
     }
   } else {
-    if (auto it = this->hostnames.find(lower_case_name); it != this->hostnames.end() && idx != it->second) {
-      Debug("ssl", "previously indexed '%s' with SSL_CTX %d, cannot index it with SSL_CTX #%d now", lower_case_name, it->second,
-            idx);
+    if (int prev = this->names.insert(name, idx); prev != idx) {
+      Debug("ssl", "previously indexed '%s' with SSL_CTX %d, cannot index it with SSL_CTX #%d now", name, prev, idx);
       idx = -1;
     } else {
-      this->hostnames.emplace(lower_case_name, idx);
-      Debug("ssl", "indexed '%s' with SSL_CTX %p [%d]", lower_case_name, this->ctx_store[idx].ctx, idx);
+      Debug("ssl", "indexed '%s' with SSL_CTX %p [%d]", name, this->ctx_store[idx].ctx, idx);
     }
   }
   return idx;
 }
 
-void
-SSLContextStorage::printWildDomains() const
-{
-  for (auto &&it : this->wilddomains) {
-    Debug("ssl", "Stored wilddomain %s", it.first.c_str());
-  }
-}
-
 SSLCertContext *
 SSLContextStorage::lookup(const char *name)
 {
-  // First look for an exact name match
-  if (auto it = this->hostnames.find(name); it != this->hostnames.end()) {
-    return &(this->ctx_store[it->second]);
-  }
-  // Try lower casing it
-  char lower_case_name[TS_MAX_HOST_NAME_LEN + 1];
-  make_to_lower_case(name, lower_case_name, sizeof(lower_case_name));
-  if (auto it_lower = this->hostnames.find(lower_case_name); it_lower != this->hostnames.end()) {
-    return &(this->ctx_store[it_lower->second]);
-  }
-
-  // Then strip off the top domain name and look for a wildcard domain match
-  const char *subdomain = index(lower_case_name, '.');
-  if (subdomain) {
-    ++subdomain; // Move beyond the '.'
-    if (auto it = this->wilddomains.find(subdomain); it != this->wilddomains.end()) {
-      return &(this->ctx_store[it->second]);
-    }
+  // Exact matches first, then a wildcard for the domain above.
+  if (int idx = this->names.find(name); idx >= 0) {
+    return &(this->ctx_store[idx]);
   }
   return nullptr;
 }
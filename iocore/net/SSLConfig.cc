@@ -48,19 +48,28 @@ int SSLCertificateConfig::configid                          = 0;
 int SSLTicketKeyConfig::configid                            = 0;
 int SSLConfigParams::ssl_maxrecord                          = 0;
 bool SSLConfigParams::ssl_allow_client_renegotiation        = false;
+bool SSLConfigParams::ssl_ktls_enabled                      = false;
 bool SSLConfigParams::ssl_ocsp_enabled                      = false;
 int SSLConfigParams::ssl_ocsp_cache_timeout                 = 3600;
 int SSLConfigParams::ssl_ocsp_request_timeout               = 10;
 int SSLConfigParams::ssl_ocsp_update_period                 = 60;
+int SSLConfigParams::ssl_ocsp_max_concurrent_requests       = 32;
 int SSLConfigParams::ssl_handshake_timeout_in               = 0;
 size_t SSLConfigParams::session_cache_number_buckets        = 1024;
 bool SSLConfigParams::session_cache_skip_on_lock_contention = false;
 size_t SSLConfigParams::session_cache_max_bucket_size       = 100;
+int SSLConfigParams::session_cache_sync_frequency           = 0;
+char *SSLConfigParams::session_cache_sync_filename          = nullptr;
 init_ssl_ctx_func SSLConfigParams::init_ssl_ctx_cb          = nullptr;
 load_ssl_file_func SSLConfigParams::load_ssl_file_cb        = nullptr;
 IpMap *SSLConfigParams::proxy_protocol_ipmap                = nullptr;
 
 int SSLConfigParams::async_handshake_enabled = 0;
+int SSLConfigParams::async_crypto_threads    = 0;
+
+int SSLConfigParams::server_max_early_data        = 0;
+int SSLConfigParams::early_data_replay_window     = 10;
+int SSLConfigParams::early_data_replay_cache_size = 65536;
 char *SSLConfigParams::engine_conf_file      = nullptr;
 
 static std::unique_ptr<ConfigUpdateHandler<SSLCertificateConfig>> sslCertUpdate;
@@ -115,6 +124,8 @@ SSLConfigParams::reset()
   ssl_session_cache_timeout            = 0;
   ssl_session_cache_auto_clear         = 1;
   configExitOnLoadError                = 1;
+  configLazyLoad                       = 0;
+  configLazyMaxContexts                = 1000;
 }
 
 void
@@ -294,6 +305,8 @@ SSLConfigParams::initialize()
 
   configFilePath = ats_stringdup(RecConfigReadConfigPath("proxy.config.ssl.server.multicert.filename"));
   REC_ReadConfigInteger(configExitOnLoadError, "proxy.config.ssl.server.multicert.exit_on_load_fail");
+  REC_ReadConfigInteger(configLazyLoad, "proxy.config.ssl.server.multicert.lazy_load");
+  REC_ReadConfigInteger(configLazyMaxContexts, "proxy.config.ssl.server.multicert.lazy_load.max_contexts");
 
   REC_ReadConfigStringAlloc(ssl_server_private_key_path, "proxy.config.ssl.server.private_key.path");
   set_paths_helper(ssl_server_private_key_path, nullptr, &serverKeyPathOnly, nullptr);
@@ -317,6 +330,17 @@ SSLConfigParams::initialize()
   SSLConfigParams::session_cache_skip_on_lock_contention = ssl_session_cache_skip_on_contention;
   SSLConfigParams::session_cache_number_buckets          = ssl_session_cache_num_buckets;
 
+  // Session cache persistence, the file is relative to the runtime directory.
+  REC_ReadConfigInt32(session_cache_sync_frequency, "proxy.config.ssl.session_cache.sync_frequency");
+  if (session_cache_sync_filename == nullptr) {
+    char *filename = nullptr;
+    REC_ReadConfigStringAlloc(filename, "proxy.config.ssl.session_cache.sync_filename");
+    if (filename != nullptr && *filename != '\0') {
+      session_cache_sync_filename = ats_strdup(Layout::relative_to(RecConfigReadRuntimeDir(), filename).c_str());
+    }
+    ats_free(filename);
+  }
+
   if (ssl_session_cache == SSL_SESSION_CACHE_MODE_SERVER_ATS_IMPL) {
     session_cache = new SSLSessionCache();
   }
@@ -324,15 +348,40 @@ SSLConfigParams::initialize()
   // SSL record size
   REC_EstablishStaticConfigInt32(ssl_maxrecord, "proxy.config.ssl.max_record_size");
 
+  // Kernel TLS offload
+  REC_ReadConfigInt32(ssl_ktls_enabled, "proxy.config.ssl.ktls.enabled");
+#if !TS_USE_KTLS
+  if (ssl_ktls_enabled) {
+    Warning("proxy.config.ssl.ktls.enabled is set but kTLS is not supported by this OpenSSL, disabling it");
+    ssl_ktls_enabled = false;
+  }
+#endif
+
   // SSL OCSP Stapling configurations
   REC_ReadConfigInt32(ssl_ocsp_enabled, "proxy.config.ssl.ocsp.enabled");
   REC_EstablishStaticConfigInt32(ssl_ocsp_cache_timeout, "proxy.config.ssl.ocsp.cache_timeout");
   REC_EstablishStaticConfigInt32(ssl_ocsp_request_timeout, "proxy.config.ssl.ocsp.request_timeout");
   REC_EstablishStaticConfigInt32(ssl_ocsp_update_period, "proxy.config.ssl.ocsp.update_period");
+  REC_EstablishStaticConfigInt32(ssl_ocsp_max_concurrent_requests, "proxy.config.ssl.ocsp.max_concurrent_requests");
 
   REC_ReadConfigInt32(async_handshake_enabled, "proxy.config.ssl.async.handshake.enabled");
+  REC_ReadConfigInt32(async_crypto_threads, "proxy.config.ssl.async.crypto.threads");
+  // Offloaded key operations pause the handshake the same way an async engine does.
+  if (async_crypto_threads > 0) {
+    async_handshake_enabled = 1;
+  }
   REC_ReadConfigStringAlloc(engine_conf_file, "proxy.config.ssl.engine.conf_file");
 
+  REC_ReadConfigInt32(server_max_early_data, "proxy.config.ssl.server.max_early_data");
+  REC_ReadConfigInt32(early_data_replay_window, "proxy.config.ssl.server.early_data.replay_window");
+  REC_ReadConfigInt32(early_data_replay_cache_size, "proxy.config.ssl.server.early_data.replay_cache_size");
+#if !TS_USE_TLS_EARLY_DATA
+  if (server_max_early_data > 0) {
+    Warning("proxy.config.ssl.server.max_early_data is set, but this version of OpenSSL does not support TLS 1.3 early data");
+    server_max_early_data = 0;
+  }
+#endif
+
   REC_ReadConfigStringAlloc(server_groups_list, "proxy.config.ssl.server.groups_list");
 
   // ++++++++++++++++++++++++ Client part ++++++++++++++++++++
@@ -468,9 +517,11 @@ SSLConfig::startup()
 void
 SSLConfig::reconfigure()
 {
+  static unsigned generation = 0;
   SSLConfigParams *params;
   params = new SSLConfigParams;
   params->initialize(); // re-read configuration
+  params->generation = ++generation;
   configid = configProcessor.set(configid, params);
 }
 
@@ -510,7 +561,8 @@ SSLCertificateConfig::reconfigure()
 {
   bool retStatus = true;
   SSLConfig::scoped_config params;
-  SSLCertLookup *lookup = new SSLCertLookup();
+  SSLCertLookup *lookup   = new SSLCertLookup();
+  SSLCertLookup *previous = configid ? acquire() : nullptr;
 
   // Test SSL certificate loading startup. With large numbers of certificates, reloading can take time, so delay
   // twice the healthcheck period to simulate a loading a large certificate set.
@@ -520,7 +572,12 @@ SSLCertificateConfig::reconfigure()
     ink_hrtime_sleep(HRTIME_SECONDS(secs));
   }
 
-  SSLParseCertificateConfiguration(params, lookup);
+  ink_hrtime start = Thread::get_hrtime_updated();
+  SSLParseCertificateConfiguration(params, lookup, previous);
+  int64_t msec = ink_hrtime_to_msec(Thread::get_hrtime_updated() - start);
+  // The lookup is deleted or handed to the config processor below, take the counts first.
+  unsigned built  = lookup->contexts_built;
+  unsigned reused = lookup->contexts_reused;
 
   if (!lookup->is_valid) {
     retStatus = false;
@@ -533,8 +590,18 @@ SSLCertificateConfig::reconfigure()
     delete lookup;
   }
 
+  if (previous) {
+    release(previous);
+  }
+
+  if (ssl_rsb != nullptr) { // ssl_rsb is not initialized during the first run.
+    SSL_SET_COUNT_DYN_STAT(ssl_multicert_load_time, msec);
+    SSL_SET_COUNT_DYN_STAT(ssl_multicert_contexts_built, built);
+    SSL_SET_COUNT_DYN_STAT(ssl_multicert_contexts_reused, reused);
+  }
+
   if (retStatus) {
-    Note("ssl_multicert.config done reloading!");
+    Note("ssl_multicert.config done reloading in %" PRId64 "ms, %u SSL contexts built and %u reused", msec, built, reused);
   } else {
     Note("failed to reload ssl_multicert.config");
   }
@@ -587,7 +654,15 @@ SSLTicketParams::LoadTicket()
     keyblock = ssl_create_ticket_keyblock(ticket_key_path);
     // Initialize if we don't have one yet
   } else if (no_default_keyblock) {
-    keyblock = ssl_create_ticket_keyblock(nullptr);
+    // Without a configured key, keep the generated one across restarts if the session cache is persisted so that
+    // tickets issued before a restart are still accepted.
+    if (SSLConfigParams::session_cache_sync_frequency > 0 && SSLConfigParams::session_cache_sync_filename) {
+      std::string ticket_key_path{SSLConfigParams::session_cache_sync_filename};
+      ticket_key_path += ".ticket_key";
+      keyblock = ssl_create_persistent_ticket_keyblock(ticket_key_path.c_str());
+    } else {
+      keyblock = ssl_create_ticket_keyblock(nullptr);
+    }
   } else {
     // No need to update.  Keep the previous ticket param
     return false;
@@ -0,0 +1,62 @@
+/** @file
+
+  Replay protection for TLS 1.3 early data.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "SSLEarlyData.h"
+#include "tscore/TestBox.h"
+
+bool
+SSLEarlyDataReplayCache::insert(std::string_view random, ink_hrtime now)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  while (!_order.empty() && _order.front().time + _window < now) {
+    _seen.erase(_order.front().random);
+    _order.pop_front();
+  }
+
+  if (_seen.find(random) != _seen.end() || _order.size() >= _capacity) {
+    return false;
+  }
+
+  // Elements of a deque stay put as others are added and removed at the ends.
+  _order.push_back({std::string(random), now});
+  _seen.insert(_order.back().random);
+  return true;
+}
+
+REGRESSION_TEST(SSLEarlyDataReplayCache)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  SSLEarlyDataReplayCache cache(2, HRTIME_SECONDS(10));
+  ink_hrtime now = HRTIME_SECONDS(1000);
+
+  box = REGRESSION_TEST_PASSED;
+
+  box.check(cache.insert("random one", now), "first sight of a random is accepted");
+  box.check(!cache.insert("random one", now + HRTIME_SECONDS(5)), "a replay within the window is refused");
+  box.check(cache.insert("random two", now + HRTIME_SECONDS(5)), "a second random is accepted");
+  box.check(!cache.insert("random three", now + HRTIME_SECONDS(6)), "a full cache refuses new randoms");
+  box.check(cache.insert("random three", now + HRTIME_SECONDS(11)), "expired randoms make room");
+  box.check(cache.size() == 2, "the expired random was dropped");
+  box.check(!cache.insert("random two", now + HRTIME_SECONDS(12)), "unexpired randoms are still refused");
+}
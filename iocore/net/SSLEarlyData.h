@@ -0,0 +1,69 @@
+/** @file
+
+  Replay protection for TLS 1.3 early data.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_hrtime.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+/** The ClientHello randoms of recent handshakes that offered early data.
+
+    A replayed ClientHello carries the same random as the original, so early data is accepted only
+    for a random not seen within the window (RFC 8446 8.2). OpenSSL already refuses early data for
+    tickets whose age is off by more than about 10 seconds, which bounds how long a replay can be
+    held back. The cache holds at most @a capacity randoms. When it is full of randoms still within
+    the window, early data is refused rather than risk forgetting one.
+*/
+class SSLEarlyDataReplayCache
+{
+public:
+  SSLEarlyDataReplayCache(size_t capacity, ink_hrtime window) : _capacity(capacity), _window(window) {}
+
+  /** Remember @a random, seen at @a now.
+      @return @c true if early data can be accepted for it.
+  */
+  bool insert(std::string_view random, ink_hrtime now);
+
+  size_t
+  size() const
+  {
+    return _order.size();
+  }
+
+private:
+  struct Entry {
+    std::string random;
+    ink_hrtime time;
+  };
+
+  size_t _capacity;
+  ink_hrtime _window;
+  std::mutex _mutex;
+  std::deque<Entry> _order;                   ///< Oldest first.
+  std::unordered_set<std::string_view> _seen; ///< Views of the randoms in @c _order.
+};
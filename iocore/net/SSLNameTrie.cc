@@ -0,0 +1,173 @@
+/** @file
+
+  Server name index shared by certificate and SNI configuration lookup.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "SSLNameTrie.h"
+#include "tscore/ParseRules.h"
+
+namespace
+{
+// Copy @a name to @a buf in lower case. @return The copy, or an empty view if @a name does not fit.
+std::string_view
+lower_case(std::string_view name, char (&buf)[SSLNameTrie::MAX_NAME_LEN])
+{
+  if (name.size() > sizeof(buf)) {
+    return {};
+  }
+  for (size_t i = 0; i < name.size(); ++i) {
+    buf[i] = ParseRules::ink_tolower(name[i]);
+  }
+  return {buf, name.size()};
+}
+
+// Remove and return the last label of @a name.
+std::string_view
+take_last_label(std::string_view &name)
+{
+  std::string_view label;
+  if (auto dot = name.rfind('.'); dot == std::string_view::npos) {
+    label = name;
+    name  = {};
+  } else {
+    label = name.substr(dot + 1);
+    name  = name.substr(0, dot);
+  }
+  return label;
+}
+
+} // namespace
+
+SSLNameTrie::Node &
+SSLNameTrie::add(std::string_view name)
+{
+  std::string lower;
+  uint32_t node = 0;
+
+  lower.reserve(name.size());
+  for (char c : name) {
+    lower += ParseRules::ink_tolower(c);
+  }
+
+  std::string_view rest = lower;
+  do {
+    std::string_view label = take_last_label(rest);
+    if (uint32_t next = child(node, label); next != 0) {
+      node = next;
+    } else {
+      std::string_view stored = _labels.emplace_back(label);
+      uint32_t added          = _nodes.size();
+      _edges.emplace(Edge{node, stored}, added);
+      _nodes.emplace_back();
+      node = added;
+    }
+  } while (!rest.empty());
+
+  return _nodes[node];
+}
+
+int
+SSLNameTrie::insert(std::string_view name, int value)
+{
+  Node &node = add(name);
+  if (node.exact < 0) {
+    node.exact = value;
+    ++_count;
+  }
+  return node.exact;
+}
+
+int
+SSLNameTrie::insert_wildcard(std::string_view domain, int value)
+{
+  Node &node = add(domain);
+  if (node.wildcard < 0) {
+    node.wildcard = value;
+    ++_count;
+  }
+  return node.wildcard;
+}
+
+int
+SSLNameTrie::find(std::string_view name) const
+{
+  char buf[MAX_NAME_LEN];
+  std::string_view rest = lower_case(name, buf);
+  uint32_t node         = 0;
+  uint32_t parent       = 0;
+
+  if (rest.empty()) {
+    return -1;
+  }
+
+  do {
+    parent = node;
+    node   = child(node, take_last_label(rest));
+  } while (node != 0 && !rest.empty());
+
+  if (node != 0 && _nodes[node].exact >= 0) {
+    return _nodes[node].exact;
+  }
+  // The name has to have been walked all the way to the domain above it, and have a label below that.
+  if (rest.empty() && parent != 0) {
+    return _nodes[parent].wildcard;
+  }
+  return -1;
+}
+
+int
+SSLNameTrie::find_first(std::string_view name) const
+{
+  char buf[MAX_NAME_LEN];
+  std::string_view rest = lower_case(name, buf);
+  uint32_t node         = 0;
+  int first             = -1;
+
+  auto consider = [&first](int value) -> void {
+    if (value >= 0 && (first < 0 || value < first)) {
+      first = value;
+    }
+  };
+
+  while (!rest.empty()) {
+    node = child(node, take_last_label(rest));
+    if (node == 0) {
+      break;
+    }
+    if (rest.empty()) {
+      consider(_nodes[node].exact);
+    } else {
+      consider(_nodes[node].wildcard);
+    }
+  }
+
+  return first;
+}
+
+void
+SSLNameTrie::clear()
+{
+  _nodes.resize(1);
+  _nodes[0] = Node();
+  _edges.clear();
+  _labels.clear();
+  _count = 0;
+}
@@ -0,0 +1,119 @@
+/** @file
+
+  Server name index shared by certificate and SNI configuration lookup.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/** Server names indexed by a trie of their labels, top level domain first.
+
+    An entry is either an exact name, such as "www.example.com", or a wildcard for the names below a
+    domain, written "*.example.com". Each entry maps to a non-negative value. Names are compared
+    without regard to case.
+
+    The trie is kept as a table of nodes and a single hash of (node, label) edges, so a lookup costs one
+    hash probe per label of the name, however many names there are and however many are wildcards.
+*/
+class SSLNameTrie
+{
+public:
+  /** Add an exact name.
+      @return @a value if the name was added, otherwise the value the name already had.
+  */
+  int insert(std::string_view name, int value);
+
+  /** Add a wildcard for the names below @a domain.
+      @return @a value if the wildcard was added, otherwise the value it already had.
+  */
+  int insert_wildcard(std::string_view domain, int value);
+
+  /** Find a name the way certificate names match: the exact name, else a wildcard for the domain
+      directly above it.
+      @return The value for @a name, or -1 if there is none.
+  */
+  int find(std::string_view name) const;
+
+  /** Find the first entry that matches a name, among the exact name and the wildcards of every domain
+      above it, in the order their values give.
+      @return The lowest value of the matching entries, or -1 if there are none.
+  */
+  int find_first(std::string_view name) const;
+
+  /// @return The number of entries.
+  size_t
+  size() const
+  {
+    return _count;
+  }
+
+  void clear();
+
+  /// Names longer than this are never found.
+  static constexpr size_t MAX_NAME_LEN = 255;
+
+private:
+  struct Node {
+    int exact    = -1; ///< Value of the name that ends at this node.
+    int wildcard = -1; ///< Value of the wildcard for the names below this node.
+  };
+
+  struct Edge {
+    uint32_t parent;
+    std::string_view label;
+
+    bool
+    operator==(Edge const &that) const
+    {
+      return parent == that.parent && label == that.label;
+    }
+  };
+
+  struct EdgeHash {
+    size_t
+    operator()(Edge const &edge) const
+    {
+      return std::hash<std::string_view>()(edge.label) ^ (static_cast<size_t>(edge.parent) * 0x9E3779B97F4A7C15ULL);
+    }
+  };
+
+  /// Walk or extend the trie to the node for @a name.
+  Node &add(std::string_view name);
+
+  /// @return The child of @a parent for @a label, or 0 if there is none.
+  uint32_t
+  child(uint32_t parent, std::string_view label) const
+  {
+    auto spot = _edges.find(Edge{parent, label});
+    return spot == _edges.end() ? 0 : spot->second;
+  }
+
+  std::vector<Node> _nodes{1}; ///< Node 0 is the root, which no name ends at.
+  std::unordered_map<Edge, uint32_t, EdgeHash> _edges;
+  std::deque<std::string> _labels; ///< Storage for the edge labels.
+  size_t _count = 0;
+};
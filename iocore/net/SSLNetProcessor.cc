@@ -37,10 +37,15 @@ NetProcessor &sslNetProcessor = ssl_NetProcessor;
 SNIActionPerformer sni_action_performer;
 
 #ifdef TS_USE_TLS_OCSP
+// Set while a refresh asked for by ocsp_update_soon() is waiting to run.
+static std::atomic<bool> ocsp_update_pending{false};
+
 struct OCSPContinuation : public Continuation {
   int
   mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   {
+    // Any pass covers the contexts built before it starts.
+    ocsp_update_pending = false;
     ocsp_update();
 
     return EVENT_CONT;
@@ -48,6 +53,17 @@ struct OCSPContinuation : public Continuation {
 
   OCSPContinuation() : Continuation(new_ProxyMutex()) { SET_HANDLER(&OCSPContinuation::mainEvent); }
 };
+
+static OCSPContinuation *ocsp_cont = nullptr;
+static EventType ocsp_event_type;
+
+void
+ocsp_update_soon()
+{
+  if (ocsp_cont && !ocsp_update_pending.exchange(true)) {
+    eventProcessor.schedule_imm(ocsp_cont, ocsp_event_type);
+  }
+}
 #endif /* TS_USE_TLS_OCSP */
 
 void
@@ -77,13 +93,18 @@ SSLNetProcessor::start(int, size_t stacksize)
 
 #ifdef TS_USE_TLS_OCSP
   if (SSLConfigParams::ssl_ocsp_enabled) {
-    // Call the update initially to get things populated
-    ocsp_update();
-    EventType ET_OCSP = eventProcessor.spawn_event_threads("ET_OCSP", 1, stacksize);
-    eventProcessor.schedule_every(new OCSPContinuation(), HRTIME_SECONDS(SSLConfigParams::ssl_ocsp_update_period), ET_OCSP);
+    // Populate the stapling caches right away, but on the OCSP thread so that startup doesn't wait on responders.
+    EventType ET_OCSP       = eventProcessor.spawn_event_threads("ET_OCSP", 1, stacksize);
+    OCSPContinuation *ocspc = new OCSPContinuation();
+    eventProcessor.schedule_imm(ocspc, ET_OCSP);
+    eventProcessor.schedule_every(ocspc, HRTIME_SECONDS(SSLConfigParams::ssl_ocsp_update_period), ET_OCSP);
+    ocsp_event_type = ET_OCSP;
+    ocsp_cont       = ocspc;
   }
 #endif /* TS_USE_TLS_OCSP */
 
+  SSLAsyncCryptoStart(stacksize);
+
   // We have removed the difference between ET_SSL threads and ET_NET threads,
   // So just keep on chugging
   return 0;
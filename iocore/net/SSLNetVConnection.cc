@@ -46,6 +46,12 @@ using namespace std::literals;
 #include <openssl/async.h>
 #endif
 
+#if defined(__linux__) && defined(TCP_INFO) && defined(HAVE_STRUCT_TCP_INFO)
+#define SSL_USE_TCP_INFO_RECORD_SIZE 1
+#else
+#define SSL_USE_TCP_INFO_RECORD_SIZE 0
+#endif
+
 #if !TS_USE_SET_RBIO
 // Defined in SSLInternal.c, should probably make a separate include
 // file for this at some point
@@ -175,7 +181,17 @@ make_ssl_connection(SSL_CTX *ctx, SSLNetVConnection *netvc)
     } else {
       netvc->initialize_handshake_buffers();
       BIO *rbio = BIO_new(BIO_s_mem());
-      BIO *wbio = BIO_new_fd(netvc->get_socket(), BIO_NOCLOSE);
+      BIO *wbio = nullptr;
+#if TS_USE_KTLS
+      // OpenSSL can only hand the transmit keys to the kernel through a socket BIO.
+      if (SSLConfigParams::ssl_ktls_enabled) {
+        SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+        wbio = BIO_new_socket(netvc->get_socket(), BIO_NOCLOSE);
+      }
+#endif
+      if (wbio == nullptr) {
+        wbio = BIO_new_fd(netvc->get_socket(), BIO_NOCLOSE);
+      }
       BIO_set_mem_eof_return(wbio, -1);
       SSL_set_bio(ssl, rbio, wbio);
     }
@@ -226,6 +242,16 @@ ssl_read_from_net(SSLNetVConnection *sslvc, EThread *lthread, int64_t &ret)
   }
 
   bytes_read = 0;
+  if (sslvc->earlyDataReader && sslvc->earlyDataReader->is_read_avail_more_than(0)) {
+    bytes_read = buf.writer()->write(sslvc->earlyDataReader, toread);
+    sslvc->earlyDataReader->consume(bytes_read);
+    Debug("ssl.early_data", "read %" PRId64 " bytes of early data", bytes_read);
+  }
+  if (sslvc->isEarlyDataPending()) {
+    // SSL_read fails until the client finishes the handshake, there is only early data until then.
+    sslErr = SSL_ERROR_WANT_READ;
+    event  = SSL_READ_WOULD_BLOCK;
+  }
   while (sslErr == SSL_ERROR_NONE && bytes_read < toread) {
     int64_t nread             = 0;
     int64_t block_write_avail = buf.writer()->block_write_avail();
@@ -604,6 +630,10 @@ SSLNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
       // the handshake is complete. Otherwise set up for continuing read
       // operations.
       if (ntodo <= 0) {
+        // Early data is already off the socket, so make sure the next read looks for it.
+        if (earlyDataReader && earlyDataReader->is_read_avail_more_than(0)) {
+          read.triggered = 1;
+        }
         readSignalDone(VC_EVENT_READ_COMPLETE, nh);
       } else {
         read.triggered = 1;
@@ -625,6 +655,20 @@ SSLNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
     return;
   }
 
+  // The session started on the early data, keep reading it until the client finishes the handshake.
+  if (earlyDataPending) {
+    int err = sslAcceptWithEarlyData();
+    if (!earlyDataPending) {
+      Debug("ssl.early_data", "handshake completed after %" PRId64 " bytes of early data", earlyDataLen);
+      this->checkKTLSSend();
+    } else if (err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE) {
+      Debug("ssl.early_data", "handshake failed after early data: %s (%d)", SSLErrorName(err), err);
+      read.triggered = 0;
+      readSignalError(nh, errno ? errno : EPIPE);
+      return;
+    }
+  }
+
   // At this point we are at the post-handshake SSL processing
   //
   // not sure if this do-while loop is really needed here, please replace
@@ -701,6 +745,56 @@ SSLNetVConnection::net_read_io(NetHandler *nh, EThread *lthread)
   }
 }
 
+static int
+record_size_bucket(int64_t size)
+{
+  if (size <= 1500) {
+    return 0;
+  } else if (size <= 4096) {
+    return 1;
+  } else if (size <= 8192) {
+    return 2;
+  }
+  return size < SSL_MAX_TLS_RECORD_SIZE ? 3 : 4;
+}
+
+/* A record can't be decrypted until all of its segments have arrived, so a record larger than the
+   congestion window allows to go out now costs the client another round trip before it sees any of
+   it. Size records to the whole segments that fit in the window, which keeps them to a single
+   segment in slow start and after the window restarts on idle, and lets bulk transfers use full
+   size records once the window has opened. @return 0 if the TCP state is not available.
+*/
+uint32_t
+SSLNetVConnection::tcp_info_record_size(int msec_since_last_write)
+{
+#if SSL_USE_TCP_INFO_RECORD_SIZE
+  struct tcp_info info;
+  socklen_t info_len = sizeof(info);
+
+  if (safe_getsockopt(con.fd, IPPROTO_TCP, TCP_INFO, reinterpret_cast<char *>(&info), reinterpret_cast<int *>(&info_len)) < 0 ||
+      info.tcpi_snd_mss <= SSL_TLS_RECORD_OVERHEAD) {
+    return 0;
+  }
+
+  uint32_t segments = info.tcpi_snd_cwnd > info.tcpi_unacked ? info.tcpi_snd_cwnd - info.tcpi_unacked : 1;
+  // Idle for longer than the retransmit timeout, the window restarts with the next send (RFC 5681 4.1).
+  if (sslLastWriteTime != 0 && static_cast<uint64_t>(msec_since_last_write) * 1000 > info.tcpi_rto) {
+    segments = 1;
+  } else if (static_cast<uint64_t>(info.tcpi_snd_cwnd) * info.tcpi_snd_mss >= SSL_MAX_TLS_RECORD_SIZE + SSL_TLS_RECORD_OVERHEAD) {
+    // Once the window holds a full size record, a full window in flight doesn't shrink records again.
+    segments = info.tcpi_snd_cwnd;
+  }
+
+  uint64_t size = static_cast<uint64_t>(segments) * info.tcpi_snd_mss - SSL_TLS_RECORD_OVERHEAD;
+  Debug("ssl.record_size", "cwnd=%u unacked=%u mss=%u rtt=%uus rto=%uus idle=%dms record=%" PRIu64, info.tcpi_snd_cwnd,
+        info.tcpi_unacked, info.tcpi_snd_mss, info.tcpi_rtt, info.tcpi_rto, msec_since_last_write, size);
+  return size < SSL_MAX_TLS_RECORD_SIZE ? size : SSL_MAX_TLS_RECORD_SIZE;
+#else
+  (void)msec_since_last_write;
+  return 0;
+#endif
+}
+
 int64_t
 SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs)
 {
@@ -710,11 +804,26 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf
   uint32_t dynamic_tls_record_size = 0;
   ssl_error_t err                  = SSL_ERROR_NONE;
 
+  if (HttpProxyPort::TRANSPORT_BLIND_TUNNEL == this->attributes) {
+    return this->super::load_buffer_and_write(towrite, buf, total_written, needs);
+  }
+
+  // With kTLS transmit offload the kernel frames and encrypts whatever is written to the
+  // socket, so skip SSL_write and its extra copy. Alerts such as close_notify still go out
+  // through OpenSSL, which sends them as control records on the same kernel TLS state.
+  if (sslKTLSSend) {
+    int64_t written_before = total_written;
+    int64_t r              = this->super::load_buffer_and_write(towrite, buf, total_written, needs);
+    SSL_INCREMENT_DYN_STAT_EX(ssl_ktls_tx_bytes_stat, total_written - written_before);
+    return r;
+  }
+
   // Dynamic TLS record sizing
-  ink_hrtime now = 0;
+  ink_hrtime now            = 0;
+  int msec_since_last_write = 0;
   if (SSLConfigParams::ssl_maxrecord == -1) {
-    now                       = Thread::get_hrtime_updated();
-    int msec_since_last_write = ink_hrtime_diff_msec(now, sslLastWriteTime);
+    now                   = Thread::get_hrtime_updated();
+    msec_since_last_write = ink_hrtime_diff_msec(now, sslLastWriteTime);
 
     if (msec_since_last_write > SSL_DEF_TLS_RECORD_MSEC_THRESHOLD) {
       // reset sslTotalBytesSent upon inactivity for SSL_DEF_TLS_RECORD_MSEC_THRESHOLD
@@ -724,10 +833,6 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf
           sslLastWriteTime, msec_since_last_write);
   }
 
-  if (HttpProxyPort::TRANSPORT_BLIND_TUNNEL == this->attributes) {
-    return this->super::load_buffer_and_write(towrite, buf, total_written, needs);
-  }
-
   do {
     // What is remaining left in the next block?
     l                   = buf.reader()->block_read_avail();
@@ -753,11 +858,19 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf
       if (SSLConfigParams::ssl_maxrecord > 0 && l > SSLConfigParams::ssl_maxrecord) {
         l = SSLConfigParams::ssl_maxrecord;
       } else if (SSLConfigParams::ssl_maxrecord == -1) {
-        if (sslTotalBytesSent < SSL_DEF_TLS_RECORD_BYTE_THRESHOLD) {
-          dynamic_tls_record_size = SSL_DEF_TLS_RECORD_SIZE;
+        // The window changes as records go out, so size each record until they reach full size.
+        if (dynamic_tls_record_size < SSL_MAX_TLS_RECORD_SIZE) {
+          dynamic_tls_record_size = tcp_info_record_size(msec_since_last_write);
+          if (dynamic_tls_record_size == 0) {
+            bool warm               = sslTotalBytesSent + total_written >= SSL_DEF_TLS_RECORD_BYTE_THRESHOLD;
+            dynamic_tls_record_size = warm ? SSL_MAX_TLS_RECORD_SIZE : SSL_DEF_TLS_RECORD_SIZE;
+          }
+          // Only the first record of a write can follow an idle period.
+          msec_since_last_write = 0;
+        }
+        if (dynamic_tls_record_size < SSL_MAX_TLS_RECORD_SIZE) {
           SSL_INCREMENT_DYN_STAT(ssl_total_dyn_def_tls_record_count);
         } else {
-          dynamic_tls_record_size = SSL_MAX_TLS_RECORD_SIZE;
           SSL_INCREMENT_DYN_STAT(ssl_total_dyn_max_tls_record_count);
         }
         if (l > dynamic_tls_record_size) {
@@ -774,12 +887,19 @@ SSLNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf
     num_really_written = 0;
     Debug("ssl", "SSLNetVConnection::loadBufferAndCallWrite, before SSLWriteBuffer, l=%" PRId64 ", towrite=%" PRId64 ", b=%p", l,
           towrite, current_block);
-    err = SSLWriteBuffer(ssl, current_block, l, num_really_written);
+    // Until the client finishes the handshake only SSL_write_early_data can write, what it sends is
+    // 0.5-RTT data (RFC 8446 section 2.3).
+    if (earlyDataPending) {
+      err = SSLWriteEarlyData(ssl, current_block, l, num_really_written);
+    } else {
+      err = SSLWriteBuffer(ssl, current_block, l, num_really_written);
+    }
 
     // We wrote all that we thought we should
     if (num_really_written > 0) {
       total_written += num_really_written;
       buf.reader()->consume(num_really_written);
+      ++sslRecordSizeHistogram[record_size_bucket(num_really_written)];
     }
 
     Debug("ssl", "SSLNetVConnection::loadBufferAndCallWrite,Number of bytes written=%" PRId64 " , total=%" PRId64 "",
@@ -896,12 +1016,29 @@ SSLNetVConnection::clear()
     ssl = nullptr;
   }
 
+  if (sslHandshakeStatus == SSL_HANDSHAKE_DONE) {
+    Debug("ssl.record_size", "writes by size: %u <= 1500, %u <= 4K, %u <= 8K, %u < 16K, %u full size", sslRecordSizeHistogram[0],
+          sslRecordSizeHistogram[1], sslRecordSizeHistogram[2], sslRecordSizeHistogram[3], sslRecordSizeHistogram[4]);
+  }
+  memset(sslRecordSizeHistogram, 0, sizeof(sslRecordSizeHistogram));
+
+  if (earlyDataBuf != nullptr) {
+    free_MIOBuffer(earlyDataBuf);
+  }
+  earlyDataBuf     = nullptr;
+  earlyDataReader  = nullptr;
+  earlyDataLen     = 0;
+  earlyDataFinish  = false;
+  earlyDataPending = false;
+  earlyDataTaken   = false;
+
   sslHandshakeStatus          = SSL_HANDSHAKE_ONGOING;
   sslHandshakeBeginTime       = 0;
   sslLastWriteTime            = 0;
   sslTotalBytesSent           = 0;
   sslClientRenegotiationAbort = false;
   sslSessionCacheHit          = false;
+  sslKTLSSend                 = false;
 
   curHook         = nullptr;
   hookOpRequested = SSL_HOOK_OP_DEFAULT;
@@ -1083,6 +1220,15 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
           SSL_INCREMENT_DYN_STAT(ssl_sni_name_set_failure);
         }
       }
+
+#if TS_USE_TLS_ALPN
+      if (!this->options.alpn_protos.empty()) {
+        if (SSL_set_alpn_protos(this->ssl, reinterpret_cast<const unsigned char *>(this->options.alpn_protos.data()),
+                                this->options.alpn_protos.size()) != 0) {
+          Debug("ssl.error", "failed to set ALPN protocols for client handshake");
+        }
+      }
+#endif /* TS_USE_TLS_ALPN */
     }
 
     return sslClientHandShakeEvent(err);
@@ -1093,6 +1239,76 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
   }
 }
 
+/* A client resuming a TLS 1.3 session may send its first request along with the ClientHello.
+   SSL_read_early_data takes that in and drives the handshake up to waiting for the client's
+   Finished, after which SSL_accept completes it as usual.
+
+   Once early data has been accepted and the server's flight is out, the handshake is reported
+   done so the session can start on the early data a round trip sooner. It stays pending, and
+   net_read_io calls this again to read the rest of the early data and complete the handshake.
+*/
+int
+SSLNetVConnection::sslAcceptWithEarlyData()
+{
+  while (!earlyDataFinish) {
+    if (earlyDataBuf == nullptr) {
+      earlyDataBuf    = new_MIOBuffer(BUFFER_SIZE_INDEX_16K);
+      earlyDataReader = earlyDataBuf->alloc_reader();
+    }
+    if (earlyDataBuf->block_write_avail() <= 0) {
+      earlyDataBuf->add_block();
+    }
+
+    int64_t nread   = 0;
+    ssl_error_t err = SSLReadEarlyData(ssl, earlyDataBuf->end(), earlyDataBuf->block_write_avail(), nread, earlyDataFinish);
+    if (err == SSL_ERROR_WANT_READ && this->handShakeReader && this->update_rbio(true)) {
+      // More of what was read for the handshake is buffered.
+      continue;
+    }
+    if (err != SSL_ERROR_NONE) {
+      if (err == SSL_ERROR_WANT_READ && earlyDataLen > 0 && !earlyDataPending) {
+        Debug("ssl.early_data", "starting the session on %" PRId64 " bytes of early data", earlyDataLen);
+        earlyDataPending = true;
+        return SSL_ERROR_NONE;
+      }
+      return err;
+    }
+    if (nread > 0) {
+      earlyDataBuf->fill(nread);
+      earlyDataLen += nread;
+    }
+  }
+
+  ssl_error_t err = SSLAccept(ssl);
+  if (err == SSL_ERROR_NONE) {
+    earlyDataPending = false;
+  }
+  return err;
+}
+
+void
+SSLNetVConnection::checkKTLSSend()
+{
+#if TS_USE_KTLS
+  // OpenSSL turns on kTLS when the traffic keys are installed if the kernel supports the
+  // negotiated cipher. Receiving still goes through SSL_read, which lets OpenSSL handle
+  // alerts and post handshake messages.
+  if (SSLConfigParams::ssl_ktls_enabled && BIO_get_ktls_send(SSL_get_wbio(ssl))) {
+    Debug("ssl", "kTLS transmit offload enabled");
+    sslKTLSSend = true;
+    SSL_INCREMENT_DYN_STAT(ssl_ktls_tx_connections_stat);
+  }
+#endif
+}
+
+bool
+SSLNetVConnection::takeEarlyData()
+{
+  bool early     = earlyDataLen > 0 && (!earlyDataTaken || earlyDataPending);
+  earlyDataTaken = true;
+  return early;
+}
+
 int
 SSLNetVConnection::sslServerHandShakeEvent(int &err)
 {
@@ -1176,7 +1392,7 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
     SSL_set_mode(ssl, SSL_MODE_ASYNC);
   }
 #endif
-  ssl_error_t ssl_error = SSLAccept(ssl);
+  ssl_error_t ssl_error = SSLConfigParams::server_max_early_data > 0 ? sslAcceptWithEarlyData() : SSLAccept(ssl);
 #if TS_USE_TLS_ASYNC
   if (ssl_error == SSL_ERROR_WANT_ASYNC) {
     size_t numfds;
@@ -1238,6 +1454,25 @@ SSLNetVConnection::sslServerHandShakeEvent(int &err)
 
     sslHandshakeStatus = SSL_HANDSHAKE_DONE;
 
+#if TS_USE_TLS_EARLY_DATA
+    switch (SSL_get_early_data_status(ssl)) {
+    case SSL_EARLY_DATA_ACCEPTED:
+      Debug("ssl.early_data", "accepted %" PRId64 " bytes of early data", earlyDataLen);
+      SSL_INCREMENT_DYN_STAT(ssl_early_data_accepted);
+      break;
+    case SSL_EARLY_DATA_REJECTED:
+      SSL_INCREMENT_DYN_STAT(ssl_early_data_rejected);
+      break;
+    default:
+      break;
+    }
+#endif
+
+    // While the handshake is pending writes go through SSL_write_early_data, check once it completes.
+    if (!earlyDataPending) {
+      this->checkKTLSSend();
+    }
+
     if (sslHandshakeBeginTime) {
       sslHandshakeEndTime                 = Thread::get_hrtime();
       const ink_hrtime ssl_handshake_time = sslHandshakeEndTime - sslHandshakeBeginTime;
@@ -36,6 +36,7 @@
 #include "tscore/ink_memory.h"
 #include "tscpp/util/TextView.h"
 #include "tscore/I_Layout.h"
+#include "tscore/ParseRules.h"
 #include <sstream>
 #include <pcre.h>
 
@@ -43,28 +44,75 @@ static ConfigUpdateHandler<SNIConfig> *sniConfigUpdate;
 struct NetAccept;
 std::unordered_map<int, SSLNextProtocolSet *> snpsMap;
 
-const NextHopProperty *
-SNIConfigParams::getPropertyConfig(const std::string &servername) const
+// An fqdn can go in the name index if it is a plain host name, optionally with a leading "*." that
+// covers every name below the domain. Anything else is left to its regular expression.
+static bool
+sni_fqdn_indexable(std::string_view fqdn)
+{
+  if (fqdn.size() > 2 && fqdn[0] == '*' && fqdn[1] == '.') {
+    fqdn.remove_prefix(2);
+  }
+  if (fqdn.empty() || fqdn.front() == '.' || fqdn.back() == '.') {
+    return false;
+  }
+  for (char c : fqdn) {
+    if (!ParseRules::is_alnum(c) && c != '-' && c != '_' && c != '.') {
+      return false;
+    }
+  }
+  return true;
+}
+
+int
+SNIConfigParams::findItem(const std::string &servername, bool match_empty) const
 {
-  const NextHopProperty *nps = nullptr;
-  for (auto &&item : next_hop_list) {
-    if (pcre_exec(item.match, nullptr, servername.c_str(), servername.length(), 0, 0, nullptr, 0) >= 0) {
-      // Found a match
-      nps = &item.prop;
+  int first = servername.empty() ? -1 : fqdn_index.find_first(servername);
+
+  // Items only the regular expression can match are checked if they come before the indexed match.
+  for (int idx : unindexed_items) {
+    if (first >= 0 && idx > first) {
       break;
     }
+    const pcre *match = sni_action_list[idx].match;
+    if (match == nullptr) {
+      if (match_empty && servername.empty()) {
+        return idx;
+      }
+    } else if (pcre_exec(match, nullptr, servername.c_str(), servername.length(), 0, 0, nullptr, 0) >= 0) {
+      return idx;
+    }
   }
-  return nps;
+  return first;
+}
+
+const NextHopProperty *
+SNIConfigParams::getPropertyConfig(const std::string &servername) const
+{
+  int idx = findItem(servername, false);
+  return idx < 0 ? nullptr : &next_hop_list[idx].prop;
 }
 
 void
 SNIConfigParams::loadSNIConfig()
 {
   for (auto &item : Y_sni.items) {
+    int idx = sni_action_list.size();
     auto ai = sni_action_list.emplace(sni_action_list.end());
     ai->setGlobName(item.fqdn);
     Debug("ssl", "name: %s", item.fqdn.data());
 
+    if (sni_fqdn_indexable(item.fqdn)) {
+      std::string_view fqdn = item.fqdn;
+      // Of two items for the same name the first wins, as it always has.
+      if (fqdn[0] == '*') {
+        fqdn_index.insert_wildcard(fqdn.substr(2), idx);
+      } else {
+        fqdn_index.insert(fqdn, idx);
+      }
+    } else {
+      unindexed_items.push_back(idx);
+    }
+
     // set SNI based actions to be called in the ssl_servername_only callback
     if (item.disable_h2) {
       ai->actions.push_back(std::make_unique<DisableH2>());
@@ -109,14 +157,8 @@ SNIConfigParams::SNIConfigParams() {}
 const actionVector *
 SNIConfigParams::get(const std::string &servername) const
 {
-  for (auto retval = sni_action_list.begin(); retval != sni_action_list.end(); ++retval) {
-    if (retval->match == nullptr && servername.length() == 0) {
-      return &retval->actions;
-    } else if (pcre_exec(retval->match, nullptr, servername.c_str(), servername.length(), 0, 0, nullptr, 0) >= 0) {
-      return &retval->actions;
-    }
-  }
-  return nullptr;
+  int idx = findItem(servername, true);
+  return idx < 0 ? nullptr : &sni_action_list[idx].actions;
 }
 
 int
@@ -20,8 +20,18 @@
  */
 
 #include "P_SSLConfig.h"
+#include "P_SSLCertLookup.h"
 #include "SSLSessionCache.h"
+#include "I_Tasks.h"
+#include "tscore/MatcherUtils.h"
 #include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <openssl/rand.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define SSL_SESSION_up_ref(s) CRYPTO_add(&(s)->references, 1, CRYPTO_LOCK_SSL_SESSION)
+#endif
 
 #define SSLSESSIONCACHE_STRINGIFY0(x) #x
 #define SSLSESSIONCACHE_STRINGIFY(x) SSLSESSIONCACHE_STRINGIFY0(x)
@@ -71,7 +81,12 @@ SSLSessionCache::getSession(const SSLSessionID &sid, SSL_SESSION **sess) const
           target_bucket, bucket, buf, hash);
   }
 
-  return bucket->getSession(sid, sess);
+  ink_hrtime start = Thread::get_hrtime_updated();
+  bool found       = bucket->getSession(sid, sess);
+  if (ssl_rsb) {
+    SSL_INCREMENT_DYN_STAT_EX(ssl_session_cache_lookup_time, Thread::get_hrtime_updated() - start);
+  }
+  return found;
 }
 
 void
@@ -111,6 +126,306 @@ SSLSessionCache::insertSession(const SSLSessionID &sid, SSL_SESSION *sess)
   bucket->insertSession(sid, sess);
 }
 
+namespace
+{
+/* A snapshot is a header followed by the DER encoding of each session, each preceded by its length. */
+struct SessionFileHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+constexpr uint32_t SESSION_FILE_MAGIC   = 0x54535343; // "TSSC"
+constexpr uint32_t SESSION_FILE_VERSION = 1;
+
+/* A file written under a temporary name and renamed into place once complete, in the same way as
+   RefCountCacheSerializer, so a crash never leaves a partial file behind. All the int returns are
+   0 on success or -errno.
+*/
+class SyncFile
+{
+public:
+  SyncFile(const char *path, mode_t mode) : path(path), tmp_path(this->path + ".syncing")
+  {
+    fd = socketManager.open(tmp_path.c_str(), O_TRUNC | O_WRONLY | O_CREAT, mode);
+  }
+
+  ~SyncFile()
+  {
+    if (fd >= 0) {
+      socketManager.close(fd);
+      unlink(tmp_path.c_str());
+    }
+  }
+
+  int
+  open_error() const
+  {
+    return fd < 0 ? fd : 0;
+  }
+
+  int
+  write(const void *ptr, size_t n_bytes)
+  {
+    size_t written = 0;
+    while (written < n_bytes) {
+      int ret = socketManager.write(fd, (char *)ptr + written, n_bytes - written);
+      if (ret <= 0) {
+        return ret < 0 ? ret : -EIO;
+      }
+      written += ret;
+    }
+    return 0;
+  }
+
+  int
+  commit()
+  {
+    int error;
+    if ((error = socketManager.fsync(fd))) {
+      return error;
+    }
+
+    std::string dirname = path.substr(0, path.rfind('/') + 1);
+#ifdef O_DIRECTORY
+    int dirfd = socketManager.open(dirname.empty() ? "." : dirname.c_str(), O_DIRECTORY);
+#else
+    int dirfd = socketManager.open(dirname.empty() ? "." : dirname.c_str(), 0);
+#endif
+    if (dirfd < 0) {
+      return dirfd;
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+      error = -errno;
+    } else {
+      error = socketManager.fsync(dirfd);
+    }
+    socketManager.close(dirfd);
+    if (error == 0) {
+      socketManager.close(fd);
+      fd = -1;
+    }
+    return error;
+  }
+
+private:
+  std::string path;
+  std::string tmp_path;
+  int fd = -1;
+};
+
+} // namespace
+
+int
+SSLSessionCache::save(const char *path) const
+{
+  // Sessions carry their master secret, so keep the file private.
+  SyncFile file(path, 0600);
+  int error = file.open_error();
+  int count = 0;
+
+  if (error == 0) {
+    SessionFileHeader header = {SESSION_FILE_MAGIC, SESSION_FILE_VERSION};
+    error                    = file.write(&header, sizeof(header));
+  }
+
+  // Take the sessions a bucket at a time, so the bucket locks are held only to add references.
+  std::vector<SSL_SESSION *> sessions;
+  std::string buffer;
+  for (size_t i = 0; i < nbuckets && error == 0; ++i) {
+    sessions.clear();
+    session_bucket[i].getSessions(sessions);
+    for (SSL_SESSION *sess : sessions) {
+      uint32_t len = i2d_SSL_SESSION(sess, nullptr);
+      if (len > 0 && len <= SSL_MAX_SESSION_SIZE && !ssl_session_timed_out(sess)) {
+        unsigned char der[SSL_MAX_SESSION_SIZE];
+        unsigned char *loc = der;
+        i2d_SSL_SESSION(sess, &loc);
+        buffer.append(reinterpret_cast<char *>(&len), sizeof(len));
+        buffer.append(reinterpret_cast<char *>(der), len);
+        ++count;
+      }
+      SSL_SESSION_free(sess);
+    }
+    if (buffer.size() >= 64 * 1024) {
+      error = file.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+
+  if (error == 0 && !buffer.empty()) {
+    error = file.write(buffer.data(), buffer.size());
+  }
+  if (error == 0) {
+    error = file.commit();
+  }
+  if (error) {
+    Warning("Unable to save the SSL session cache to %s: %s", path, strerror(-error));
+    return -1;
+  }
+  return count;
+}
+
+int
+SSLSessionCache::load(const char *path)
+{
+  if (access(path, R_OK) != 0) {
+    Debug("ssl.session_cache", "No saved SSL session cache at %s: %s", path, strerror(errno));
+    return errno == ENOENT ? 0 : -1;
+  }
+
+  int size = 0;
+  ats_scoped_str data(readIntoBuffer(path, "[SSLSessionCache]", &size));
+  if (!data) {
+    return -1;
+  }
+
+  SessionFileHeader header = {0, 0};
+  if (size >= static_cast<int>(sizeof(header))) {
+    memcpy(&header, data, sizeof(header));
+  }
+  if (header.magic != SESSION_FILE_MAGIC || header.version != SESSION_FILE_VERSION) {
+    Warning("Ignoring SSL session cache file %s, it is not a version %u session cache", path, SESSION_FILE_VERSION);
+    return -1;
+  }
+
+  const char *cur = data.get() + sizeof(header);
+  const char *end = data.get() + size;
+  int count       = 0;
+  while (end - cur >= static_cast<ptrdiff_t>(sizeof(uint32_t))) {
+    uint32_t len;
+    memcpy(&len, cur, sizeof(len));
+    cur += sizeof(len);
+    if (len > SSL_MAX_SESSION_SIZE || len > static_cast<size_t>(end - cur)) {
+      Warning("SSL session cache file %s is truncated or corrupt, loaded %d sessions", path, count);
+      break;
+    }
+
+    const unsigned char *der = reinterpret_cast<const unsigned char *>(cur);
+    SSL_SESSION *sess        = d2i_SSL_SESSION(nullptr, &der, len);
+    cur += len;
+    if (sess == nullptr) {
+      continue;
+    }
+    if (!ssl_session_timed_out(sess)) {
+      unsigned int id_len = 0;
+      const unsigned char *id = SSL_SESSION_get_id(sess, &id_len);
+      if (id_len > 0) {
+        insertSession(SSLSessionID(id, id_len), sess);
+        ++count;
+      }
+    }
+    SSL_SESSION_free(sess);
+  }
+
+  return count;
+}
+
+/* Session cache persistence */
+
+namespace
+{
+// Saves are not allowed to start until the load is done, otherwise a save could replace the file with
+// a partial cache. The mutex keeps the final save from overlapping a periodic one.
+std::atomic<bool> session_cache_loaded{false};
+std::mutex session_cache_sync_mutex;
+
+void
+session_cache_save()
+{
+  std::lock_guard<std::mutex> lock(session_cache_sync_mutex);
+  if (!session_cache || !session_cache_loaded) {
+    return;
+  }
+
+  ink_hrtime start = Thread::get_hrtime_updated();
+  int count        = session_cache->save(SSLConfigParams::session_cache_sync_filename);
+  ink_hrtime msecs = ink_hrtime_to_msec(Thread::get_hrtime_updated() - start);
+
+  if (count >= 0) {
+    Debug("ssl.session_cache", "Saved %d SSL sessions to %s in %" PRId64 "ms", count, SSLConfigParams::session_cache_sync_filename,
+          msecs);
+    if (ssl_rsb) {
+      SSL_SET_COUNT_DYN_STAT(ssl_session_cache_sync_sessions, count);
+      SSL_SET_COUNT_DYN_STAT(ssl_session_cache_sync_duration, msecs);
+    }
+  }
+}
+
+struct SSLSessionCacheSync : public Continuation {
+  SSLSessionCacheSync() : Continuation(new_ProxyMutex()) { SET_HANDLER(&SSLSessionCacheSync::load_event); }
+
+  int
+  load_event(int, Event *e)
+  {
+    if (session_cache) {
+      ink_hrtime start = Thread::get_hrtime_updated();
+      int count        = session_cache->load(SSLConfigParams::session_cache_sync_filename);
+      ink_hrtime msecs = ink_hrtime_to_msec(Thread::get_hrtime_updated() - start);
+      if (count > 0) {
+        Note("loaded %d SSL sessions from %s in %" PRId64 "ms", count, SSLConfigParams::session_cache_sync_filename, msecs);
+      }
+      if (ssl_rsb) {
+        SSL_SET_COUNT_DYN_STAT(ssl_session_cache_load_duration, msecs);
+      }
+    }
+    session_cache_loaded = true;
+
+    SET_HANDLER(&SSLSessionCacheSync::sync_event);
+    e->schedule_every(HRTIME_SECONDS(SSLConfigParams::session_cache_sync_frequency));
+    return EVENT_CONT;
+  }
+
+  int
+  sync_event(int, Event *)
+  {
+    session_cache_save();
+    return EVENT_CONT;
+  }
+};
+
+} // namespace
+
+void
+SSLSessionCacheStartSync()
+{
+  if (SSLConfigParams::session_cache_sync_frequency > 0 && SSLConfigParams::session_cache_sync_filename && session_cache) {
+    Debug("ssl.session_cache", "Syncing the SSL session cache to %s every %ds", SSLConfigParams::session_cache_sync_filename,
+          SSLConfigParams::session_cache_sync_frequency);
+    eventProcessor.schedule_imm(new SSLSessionCacheSync(), ET_TASK);
+  }
+}
+
+void
+SSLSessionCacheFinalSync()
+{
+  if (SSLConfigParams::session_cache_sync_frequency > 0 && SSLConfigParams::session_cache_sync_filename) {
+    session_cache_save();
+  }
+}
+
+ssl_ticket_key_block *
+ssl_create_persistent_ticket_keyblock(const char *path)
+{
+  if (access(path, R_OK) == 0) {
+    Debug("ssl", "loading the saved session ticket key from %s", path);
+    return ssl_create_ticket_keyblock(path);
+  }
+
+  ssl_ticket_key_t key;
+  RAND_bytes(reinterpret_cast<unsigned char *>(&key), sizeof(key));
+
+  SyncFile file(path, 0600);
+  int error = file.open_error();
+  if (error == 0 && (error = file.write(&key, sizeof(key))) == 0) {
+    error = file.commit();
+  }
+  if (error) {
+    Warning("Unable to save the session ticket key to %s, tickets will not survive a restart: %s", path, strerror(-error));
+  }
+
+  return ticket_block_create(reinterpret_cast<char *>(&key), sizeof(key));
+}
+
 void
 SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
 {
@@ -127,51 +442,58 @@ SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
     Debug("ssl.session_cache", "Inserting session '%s' to bucket %p.", buf, this);
   }
 
-  MUTEX_TRY_LOCK(lock, mutex, this_ethread());
-  if (!lock.is_locked()) {
+  std::unique_lock lock(mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
     if (ssl_rsb) {
       SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
     }
     if (SSLConfigParams::session_cache_skip_on_lock_contention) {
       return;
     }
-    lock.acquire(this_ethread());
+    lock.lock();
   }
 
   PRINT_BUCKET("insertSession before")
-  if (queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
-    removeOldestSession();
-  }
 
   // Don't insert if it is already there
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      return;
-    }
-    node = node->link.prev;
+  if (sessions.find(id) != sessions.end()) {
+    return;
   }
 
-  Ptr<IOBufferData> buf;
-  buf = new_IOBufferData(buffer_size_to_index(len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-  ink_release_assert(static_cast<size_t>(buf->block_size()) >= len);
-  unsigned char *loc = reinterpret_cast<unsigned char *>(buf->data());
-  i2d_SSL_SESSION(sess, &loc);
+  if (queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
+    removeOldestSession();
+  }
 
-  ats_scoped_obj<SSLSession> ssl_session(new SSLSession(id, buf, len));
+  SSLSession *ssl_session = new SSLSession(id, sess);
 
   /* do the actual insert */
-  queue.enqueue(ssl_session.release());
+  sessions.emplace(ssl_session->session_id, ssl_session);
+  queue.enqueue(ssl_session);
 
   PRINT_BUCKET("insertSession after")
 }
 
+// Return a new reference to the cached session, or nullptr. The caller must hold the lock, shared is enough.
+SSL_SESSION *
+SSLSessionBucket::findSession(const SSLSessionID &id)
+{
+  auto spot = sessions.find(id);
+  if (spot == sessions.end()) {
+    return nullptr;
+  }
+
+  SSLSession *node = spot->second;
+  node->accessed.store(true, std::memory_order_relaxed);
+  SSL_SESSION_up_ref(node->session);
+  return node->session;
+}
+
 int
 SSLSessionBucket::getSessionBuffer(const SSLSessionID &id, char *buffer, int &len)
 {
   int true_len = 0;
-  MUTEX_TRY_LOCK(lock, mutex, this_ethread());
-  if (!lock.is_locked()) {
+  std::shared_lock lock(mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
     if (ssl_rsb) {
       SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
     }
@@ -179,26 +501,31 @@ SSLSessionBucket::getSessionBuffer(const SSLSessionID &id, char *buffer, int &le
       return true_len;
     }
 
-    lock.acquire(this_ethread());
+    lock.lock();
   }
 
-  // We work backwards because that's the most likely place we'll find our session...
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      true_len = node->len_asn1_data;
-      if (buffer) {
-        const unsigned char *loc = reinterpret_cast<const unsigned char *>(node->asn1_data->data());
-        if (true_len < len) {
-          len = true_len;
-        }
-        memcpy(buffer, loc, len);
-        return true_len;
+  SSL_SESSION *sess = findSession(id);
+  lock.unlock();
+
+  if (sess) {
+    true_len = i2d_SSL_SESSION(sess, nullptr);
+    if (buffer && true_len > 0) {
+      if (true_len <= len) {
+        unsigned char *loc = reinterpret_cast<unsigned char *>(buffer);
+        i2d_SSL_SESSION(sess, &loc);
+        len = true_len;
+      } else {
+        // Too small for the session, copy the part that fits. The session may be larger than
+        // SSL_MAX_SESSION_SIZE, so encode it into a buffer of its own size.
+        std::vector<unsigned char> tmp(true_len);
+        unsigned char *loc = tmp.data();
+        i2d_SSL_SESSION(sess, &loc);
+        memcpy(buffer, tmp.data(), len);
       }
     }
-    node = node->link.prev;
+    SSL_SESSION_free(sess);
   }
-  return 0;
+  return true_len;
 }
 
 bool
@@ -212,8 +539,8 @@ SSLSessionBucket::getSession(const SSLSessionID &id, SSL_SESSION **sess)
 
   Debug("ssl.session_cache", "Looking for session with id '%s' in bucket %p", buf, this);
 
-  MUTEX_TRY_LOCK(lock, mutex, this_ethread());
-  if (!lock.is_locked()) {
+  std::shared_lock lock(mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
     if (ssl_rsb) {
       SSL_INCREMENT_DYN_STAT(ssl_session_cache_lock_contention);
     }
@@ -221,21 +548,11 @@ SSLSessionBucket::getSession(const SSLSessionID &id, SSL_SESSION **sess)
       return false;
     }
 
-    lock.acquire(this_ethread());
+    lock.lock();
   }
 
-  PRINT_BUCKET("getSession")
-
-  // We work backwards because that's the most likely place we'll find our session...
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      const unsigned char *loc = reinterpret_cast<const unsigned char *>(node->asn1_data->data());
-      *sess                    = d2i_SSL_SESSION(nullptr, &loc, node->len_asn1_data);
-
-      return true;
-    }
-    node = node->link.prev;
+  if ((*sess = findSession(id)) != nullptr) {
+    return true;
   }
 
   Debug("ssl.session_cache", "Session with id '%s' not found in bucket %p.", buf, this);
@@ -264,18 +581,25 @@ void inline SSLSessionBucket::print(const char *ref_str) const
 
 void inline SSLSessionBucket::removeOldestSession()
 {
-  // Caller must hold the bucket lock.
-  ink_assert(this_ethread() == mutex->thread_holding);
-
+  // Caller must hold the bucket lock exclusively.
   PRINT_BUCKET("removeOldestSession before")
+
+  // Second chance eviction: a session looked up since it was last at the head goes to the back of the
+  // queue instead. Bound the passes so a bucket where everything is hot still makes progress.
+  int passes = queue.size;
   while (queue.head && queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
     SSLSession *old_head = queue.pop();
+    if (passes-- > 0 && old_head->accessed.exchange(false, std::memory_order_relaxed)) {
+      queue.enqueue(old_head);
+      continue;
+    }
     if (is_debug_tag_set("ssl.session_cache")) {
       char buf[old_head->session_id.len * 2 + 1];
       old_head->session_id.toString(buf, sizeof(buf));
       Debug("ssl.session_cache", "Removing session '%s' from bucket %p because the bucket has size %d and max %zd", buf, this,
             (queue.size + 1), SSLConfigParams::session_cache_max_bucket_size);
     }
+    sessions.erase(old_head->session_id);
     delete old_head;
   }
   PRINT_BUCKET("removeOldestSession after")
@@ -284,19 +608,43 @@ void inline SSLSessionBucket::removeOldestSession()
 void
 SSLSessionBucket::removeSession(const SSLSessionID &id)
 {
-  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread()); // We can't bail on contention here because this session MUST be removed.
-  SSLSession *node = queue.head;
-  while (node) {
-    if (node->session_id == id) {
-      queue.remove(node);
-      delete node;
-      return;
-    }
-    node = node->link.next;
+  std::unique_lock lock(mutex); // We can't bail on contention here because this session MUST be removed.
+  if (auto spot = sessions.find(id); spot != sessions.end()) {
+    SSLSession *node = spot->second;
+    sessions.erase(spot);
+    queue.remove(node);
+    delete node;
+  }
+}
+
+void
+SSLSessionBucket::getSessions(std::vector<SSL_SESSION *> &out)
+{
+  std::shared_lock lock(mutex);
+  out.reserve(out.size() + queue.size);
+  for (SSLSession *node = queue.head; node; node = node->link.next) {
+    SSL_SESSION_up_ref(node->session);
+    out.push_back(node->session);
   }
 }
 
 /* Session Bucket */
-SSLSessionBucket::SSLSessionBucket() : mutex(new_ProxyMutex()) {}
+SSLSessionBucket::SSLSessionBucket() {}
 
-SSLSessionBucket::~SSLSessionBucket() {}
+SSLSessionBucket::~SSLSessionBucket()
+{
+  SSLSession *node;
+  while ((node = queue.pop()) != nullptr) {
+    delete node;
+  }
+}
+
+SSLSession::SSLSession(const SSLSessionID &id, SSL_SESSION *sess) : session_id(id), session(sess)
+{
+  SSL_SESSION_up_ref(session);
+}
+
+SSLSession::~SSLSession()
+{
+  SSL_SESSION_free(session);
+}
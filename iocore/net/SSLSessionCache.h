@@ -29,9 +29,16 @@
 #include "P_SSLUtils.h"
 #include "ts/apidefs.h"
 #include <openssl/ssl.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
 
 #define SSL_MAX_SESSION_SIZE 256
 
+struct ssl_ticket_key_block;
+
 struct SSLSessionID : public TSSslSessionID {
   SSLSessionID(const unsigned char *s, size_t l)
   {
@@ -113,13 +120,13 @@ class SSLSession
 {
 public:
   SSLSessionID session_id;
-  Ptr<IOBufferData> asn1_data; /* this is the ASN1 representation of the SSL_CTX */
-  size_t len_asn1_data;
+  SSL_SESSION *session; /* the cache holds a reference on this */
 
-  SSLSession(const SSLSessionID &id, Ptr<IOBufferData> ssl_asn1_data, size_t len_asn1)
-    : session_id(id), asn1_data(ssl_asn1_data), len_asn1_data(len_asn1)
-  {
-  }
+  /* set by lookups, which only hold the bucket lock shared; gives the entry a second chance at eviction */
+  std::atomic<bool> accessed{false};
+
+  SSLSession(const SSLSessionID &id, SSL_SESSION *sess);
+  ~SSLSession();
 
   LINK(SSLSession, link);
 };
@@ -133,14 +140,19 @@ public:
   bool getSession(const SSLSessionID &, SSL_SESSION **ctx);
   int getSessionBuffer(const SSLSessionID &, char *buffer, int &len);
   void removeSession(const SSLSessionID &);
+  /* add a new reference to each session in the bucket to @a out */
+  void getSessions(std::vector<SSL_SESSION *> &out);
 
 private:
   /* these method must be used while hold the lock */
   void print(const char *) const;
   void removeOldestSession();
+  SSL_SESSION *findSession(const SSLSessionID &);
 
-  Ptr<ProxyMutex> mutex;
-  CountQueue<SSLSession> queue;
+  /* Lookups take the lock shared so they only contend with inserts and removals. */
+  std::shared_mutex mutex;
+  std::map<SSLSessionID, SSLSession *> sessions;
+  CountQueue<SSLSession> queue; /* insertion order, for eviction */
 };
 
 class SSLSessionCache
@@ -150,6 +162,17 @@ public:
   int getSessionBuffer(const SSLSessionID &sid, char *buffer, int &len) const;
   void insertSession(const SSLSessionID &sid, SSL_SESSION *sess);
   void removeSession(const SSLSessionID &sid);
+
+  /** Write the unexpired sessions to @a path, replacing the file only once it is complete.
+      @return The number of sessions written, or -1 on error.
+  */
+  int save(const char *path) const;
+
+  /** Insert the unexpired sessions from a file written by save().
+      @return The number of sessions loaded, or -1 if the file could not be read.
+  */
+  int load(const char *path);
+
   SSLSessionCache();
   ~SSLSessionCache();
 
@@ -157,3 +180,14 @@ private:
   SSLSessionBucket *session_bucket;
   size_t nbuckets;
 };
+
+/* Persistence of the session cache across restarts, see proxy.config.ssl.session_cache.sync_frequency. */
+
+/// Load the saved sessions in the background, then save them periodically. Needs the ET_TASK threads.
+void SSLSessionCacheStartSync();
+
+/// Save the sessions now, on a graceful shutdown.
+void SSLSessionCacheFinalSync();
+
+/// Load the ticket key block saved at @a path, or create a random one and save it there.
+ssl_ticket_key_block *ssl_create_persistent_ticket_keyblock(const char *path);
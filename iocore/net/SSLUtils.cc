@@ -28,6 +28,7 @@
 #include "tscore/ink_mutex.h"
 #include "P_OCSPStapling.h"
 #include "SSLSessionCache.h"
+#include "SSLEarlyData.h"
 #include "InkAPIInternal.h"
 #include "SSLDynlock.h"
 #include "P_SSLSNI.h"
@@ -322,6 +323,7 @@ int
 set_context_cert(SSL *ssl)
 {
   SSL_CTX *ctx       = nullptr;
+  SSL_CTX *lazy_ctx  = nullptr; // reference to a context loaded on demand
   SSLCertContext *cc = nullptr;
   SSLCertificateConfig::scoped_config lookup;
   const char *servername   = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
@@ -345,6 +347,8 @@ set_context_cert(SSL *ssl)
     cc = lookup->find((char *)servername);
     if (cc && cc->ctx) {
       ctx = cc->ctx;
+    } else if (cc && cc->lazy) {
+      ctx = lazy_ctx = lookup->get_lazy_ctx(*cc->lazy);
     }
     if (cc && SSLCertContext::OPT_TUNNEL == cc->opt && netvc->get_is_transparent()) {
       netvc->attributes = HttpProxyPort::TRANSPORT_BLIND_TUNNEL;
@@ -385,6 +389,8 @@ set_context_cert(SSL *ssl)
     goto done;
   }
 done:
+  // The SSL has its own reference now.
+  SSLReleaseContext(lazy_ctx);
   return retval;
 }
 
@@ -900,6 +906,25 @@ ssl_private_key_validate_exec(const char *cmdLine)
   return bReturn;
 }
 
+#if TS_USE_TLS_EARLY_DATA
+// Refuse early data from a ClientHello that has been seen before, it may be a replay.
+static int
+ssl_callback_allow_early_data(SSL *ssl, void * /* arg ATS_UNUSED */)
+{
+  static SSLEarlyDataReplayCache replay_cache(SSLConfigParams::early_data_replay_cache_size,
+                                              HRTIME_SECONDS(SSLConfigParams::early_data_replay_window));
+  unsigned char random[SSL3_RANDOM_SIZE];
+  size_t len = SSL_get_client_random(ssl, random, sizeof(random));
+
+  if (!replay_cache.insert({reinterpret_cast<char *>(random), len}, Thread::get_hrtime())) {
+    Debug("ssl.early_data", "refusing early data, the ClientHello was seen before or the replay cache is full");
+    SSL_INCREMENT_DYN_STAT(ssl_early_data_replayed);
+    return 0;
+  }
+  return 1;
+}
+#endif
+
 static int
 SSLRecRawStatSyncCount(const char *name, RecDataT data_type, RecData *data, RecRawStatBlock *rsb, int id)
 {
@@ -1156,6 +1181,42 @@ SSLInitializeStatistics()
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_session_cache_lock_contention", RECD_COUNTER, RECP_PERSISTENT,
                      (int)ssl_session_cache_lock_contention, RecRawStatSyncCount);
 
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_session_cache_lookup_time", RECD_INT, RECP_PERSISTENT,
+                     (int)ssl_session_cache_lookup_time, RecRawStatSyncSum);
+
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_session_cache_sync_sessions", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_session_cache_sync_sessions, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_session_cache_sync_duration", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_session_cache_sync_duration, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_session_cache_load_duration", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_session_cache_load_duration, RecRawStatSyncCount);
+
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.lazy_context_build", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_lazy_context_build, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.lazy_context_build_failure", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_lazy_context_build_failure, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.lazy_context_build_time", RECD_INT, RECP_PERSISTENT,
+                     (int)ssl_lazy_context_build_time, RecRawStatSyncSum);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.lazy_context_hit", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_lazy_context_hit, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.lazy_context_eviction", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_lazy_context_eviction, RecRawStatSyncCount);
+
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.multicert_load_time", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_multicert_load_time, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.multicert_contexts_built", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_multicert_contexts_built, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.multicert_contexts_reused", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_multicert_contexts_reused, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.async_crypto_offloaded", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_async_crypto_offloaded, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.early_data_accepted", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_early_data_accepted, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.early_data_rejected", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_early_data_rejected, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.early_data_replayed", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_early_data_replayed, RecRawStatSyncCount);
+
   /* Track dynamic record size */
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.default_record_size_count", RECD_COUNTER, RECP_PERSISTENT,
                      (int)ssl_total_dyn_def_tls_record_count, RecRawStatSyncSum);
@@ -1191,6 +1252,18 @@ SSLInitializeStatistics()
                      (int)ssl_ocsp_refreshed_cert_stat, RecRawStatSyncCount);
   RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_refresh_cert_failure", RECD_INT, RECP_PERSISTENT,
                      (int)ssl_ocsp_refresh_cert_failure_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_stale_cert", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_ocsp_stale_cert_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_refresh_time", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_ocsp_refresh_time_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ssl_ocsp_slowest_query_time", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)ssl_ocsp_slowest_query_time_stat, RecRawStatSyncCount);
+
+  /* kernel TLS stats */
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ktls_tx_connections", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_ktls_tx_connections_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(ssl_rsb, RECT_PROCESS, "proxy.process.ssl.ktls_tx_bytes", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)ssl_ktls_tx_bytes_stat, RecRawStatSyncSum);
 
   // Get and register the SSL cipher stats. Note that we are using the default SSL context to obtain
   // the cipher list. This means that the set of ciphers is fixed by the build configuration and not
@@ -1464,6 +1537,10 @@ SSLPrivateKeyHandler(SSL_CTX *ctx, const SSLConfigParams *params, const std::str
     return false;
   }
 
+  if (e == nullptr && SSLConfigParams::async_crypto_threads > 0 && !SSLAsyncCryptoUseKey(ctx)) {
+    return false;
+  }
+
   return true;
 }
 
@@ -1741,6 +1818,14 @@ SSLInitServerContext(const SSLConfigParams *params, const ssl_user_config *sslMu
   SSL_CTX_set_options(ctx, SSL_OP_SAFARI_ECDHE_ECDSA_BUG);
 #endif
 
+#if TS_USE_TLS_EARLY_DATA
+  if (params->server_max_early_data > 0) {
+    SSL_CTX_set_max_early_data(ctx, params->server_max_early_data);
+    SSL_CTX_set_recv_max_early_data(ctx, params->server_max_early_data);
+    SSL_CTX_set_allow_early_data_cb(ctx, ssl_callback_allow_early_data, nullptr);
+  }
+#endif
+
   if (sslMultCertSettings) {
     if (sslMultCertSettings->dialog) {
       passphrase_cb_userdata ud(params, sslMultCertSettings->dialog, sslMultCertSettings->first_cert, sslMultCertSettings->key);
@@ -2026,13 +2111,138 @@ SSLCreateServerContext(const SSLConfigParams *params)
   return ctx;
 }
 
+// Set up session tickets and OCSP stapling for the context of an ssl_multicert.config line.
+// @return The session ticket key block, if tickets are enabled.
+static ssl_ticket_key_block *
+ssl_context_enable_multicert_options(SSL_CTX *ctx, const ssl_user_config *sslMultCertSettings, std::vector<X509 *> const &cert_list)
+{
+  ssl_ticket_key_block *keyblock = nullptr;
+  const char *certname           = sslMultCertSettings->cert.get();
+
+  // Load the session ticket key if session tickets are not disabled
+  if (sslMultCertSettings->session_ticket_enabled != 0) {
+    keyblock = ssl_context_enable_tickets(ctx, nullptr);
+  }
+
+#if defined(SSL_OP_NO_TICKET)
+  // Session tickets are enabled by default. Disable if explicitly requested.
+  if (sslMultCertSettings->session_ticket_enabled == 0) {
+    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    Debug("ssl", "ssl session ticket is disabled");
+  }
+#endif
+
+#ifdef TS_USE_TLS_OCSP
+  if (SSLConfigParams::ssl_ocsp_enabled) {
+    Debug("ssl", "SSL OCSP Stapling is enabled");
+    SSL_CTX_set_tlsext_status_cb(ctx, ssl_callback_ocsp_stapling);
+    for (auto cert : cert_list) {
+      if (!ssl_stapling_init_cert(ctx, cert, certname)) {
+        Warning("failed to configure SSL_CTX for OCSP Stapling info for certificate at %s", (const char *)certname);
+      }
+    }
+  } else {
+    Debug("ssl", "SSL OCSP Stapling is disabled");
+  }
+#else
+  (void)certname;
+  if (SSLConfigParams::ssl_ocsp_enabled) {
+    Warning("failed to enable SSL OCSP Stapling; this version of OpenSSL does not support it");
+  }
+#endif /* TS_USE_TLS_OCSP */
+
+  return keyblock;
+}
+
+#if HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC
+#define SSL_STAT_MTIME_NSEC(t) ((t).st_mtimespec.tv_nsec)
+#elif HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+#define SSL_STAT_MTIME_NSEC(t) ((t).st_mtim.tv_nsec)
+#else
+#define SSL_STAT_MTIME_NSEC(t) 0
+#endif
+
+// Identify an ssl_multicert.config line together with everything its context is built from, so that a
+// reload can tell if the context would come out the same. Files are identified by inode, size and
+// modification time, settings from records.config by the generation of the configuration.
+static std::string
+ssl_multicert_fingerprint(const SSLConfigParams *params, const ssl_user_config *sslMultCertSettings, const char *line)
+{
+  std::string fingerprint(line);
+
+  auto add_file = [&](std::string const &path) -> void {
+    struct stat st;
+    fingerprint += '\n';
+    fingerprint += path;
+    if (stat(path.c_str(), &st) == 0) {
+      fingerprint += ' ' + std::to_string(st.st_dev) + ':' + std::to_string(st.st_ino) + ' ' + std::to_string(st.st_size) + ' ' +
+                     std::to_string(st.st_mtime) + '.' + std::to_string(SSL_STAT_MTIME_NSEC(st));
+    }
+  };
+
+  fingerprint += '\n';
+  fingerprint += std::to_string(params->generation);
+
+  if (sslMultCertSettings->cert) {
+    SimpleTokenizer cert_tok((const char *)sslMultCertSettings->cert, SSL_CERT_SEPARATE_DELIM);
+    for (const char *certname = cert_tok.getNext(); certname; certname = cert_tok.getNext()) {
+      add_file(Layout::relative_to(params->serverCertPathOnly, certname));
+    }
+  }
+  if (sslMultCertSettings->key && params->serverKeyPathOnly) {
+    SimpleTokenizer key_tok((const char *)sslMultCertSettings->key, SSL_CERT_SEPARATE_DELIM);
+    for (const char *keyname = key_tok.getNext(); keyname; keyname = key_tok.getNext()) {
+      add_file(Layout::relative_to(params->serverKeyPathOnly, keyname));
+    }
+  }
+  if (sslMultCertSettings->ca) {
+    SimpleTokenizer ca_tok((const char *)sslMultCertSettings->ca, SSL_CERT_SEPARATE_DELIM);
+    for (const char *ca_name = ca_tok.getNext(); ca_name; ca_name = ca_tok.getNext()) {
+      add_file(Layout::relative_to(params->serverCertPathOnly, ca_name));
+    }
+  }
+  if (params->serverCertChainFilename) {
+    add_file(Layout::relative_to(params->serverCertPathOnly, params->serverCertChainFilename));
+  }
+  for (const char *path : {params->serverCACertFilename, params->serverCACertPath, params->dhparamsFile}) {
+    if (path) {
+      add_file(path);
+    }
+  }
+
+  return fingerprint;
+}
+
 static SSL_CTX *
-ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, const ssl_user_config *sslMultCertSettings)
+ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, const ssl_user_config *sslMultCertSettings,
+                      const char *line = nullptr, const SSLCertLookup *previous = nullptr)
 {
   std::vector<X509 *> cert_list;
-  SSL_CTX *ctx                   = SSLInitServerContext(params, sslMultCertSettings, cert_list);
+  SSL_CTX *ctx                   = nullptr;
   ssl_ticket_key_block *keyblock = nullptr;
   bool inserted                  = false;
+  std::string fingerprint;
+  const SSLReusableContext *reuse = nullptr;
+
+  if (line && sslMultCertSettings) {
+    fingerprint = ssl_multicert_fingerprint(params, sslMultCertSettings, line);
+    if (previous) {
+      reuse = previous->find_reusable(fingerprint);
+    }
+  }
+
+  if (reuse) {
+    // Connections hold their own references, so sharing the context with the old configuration is safe.
+    ctx = reuse->ctx;
+    SSL_CTX_up_ref(ctx);
+    for (auto cert : reuse->certs) {
+      X509_up_ref(cert);
+      cert_list.push_back(cert);
+    }
+    Debug("ssl", "reusing SSL_CTX %p for %s", ctx, (const char *)sslMultCertSettings->cert);
+  } else {
+    ctx = SSLInitServerContext(params, sslMultCertSettings, cert_list);
+  }
 
   if (!ctx || !sslMultCertSettings) {
     lookup->is_valid = false;
@@ -2049,9 +2259,16 @@ ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, cons
     }
   }
 
-  // Load the session ticket key if session tickets are not disabled
-  if (sslMultCertSettings->session_ticket_enabled != 0) {
-    keyblock = ssl_context_enable_tickets(ctx, nullptr);
+  if (reuse == nullptr) {
+    keyblock = ssl_context_enable_multicert_options(ctx, sslMultCertSettings, cert_list);
+  } else if (sslMultCertSettings->addr) {
+    // The address mapped context keeps its ticket keys, so tickets issued before the reload stay valid.
+    if (reuse->keyblock) {
+      keyblock = ticket_block_create(reinterpret_cast<char *>(reuse->keyblock->keys),
+                                     reuse->keyblock->num_keys * sizeof(ssl_ticket_key_t));
+    } else if (sslMultCertSettings->session_ticket_enabled != 0) {
+      keyblock = ssl_create_ticket_keyblock(nullptr);
+    }
   }
 
   // Index this certificate by the specified IP(v6) address. If the address is "*", make it the default context.
@@ -2060,7 +2277,9 @@ ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, cons
       if (lookup->insert(sslMultCertSettings->addr, SSLCertContext(ctx, sslMultCertSettings->opt, keyblock)) >= 0) {
         inserted            = true;
         lookup->ssl_default = ctx;
-        ssl_set_handshake_callbacks(ctx);
+        if (reuse == nullptr) {
+          ssl_set_handshake_callbacks(ctx);
+        }
       }
     } else {
       IpEndpoint ep;
@@ -2080,39 +2299,13 @@ ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, cons
 #if HAVE_OPENSSL_SESSION_TICKETS
     if (keyblock != nullptr) {
       ticket_block_free(keyblock);
+      keyblock = nullptr;
     }
 #endif
   }
 
-#if defined(SSL_OP_NO_TICKET)
-  // Session tickets are enabled by default. Disable if explicitly requested.
-  if (sslMultCertSettings->session_ticket_enabled == 0) {
-    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
-    Debug("ssl", "ssl session ticket is disabled");
-  }
-#endif
-
-#ifdef TS_USE_TLS_OCSP
-  if (SSLConfigParams::ssl_ocsp_enabled) {
-    Debug("ssl", "SSL OCSP Stapling is enabled");
-    SSL_CTX_set_tlsext_status_cb(ctx, ssl_callback_ocsp_stapling);
-    for (auto cert : cert_list) {
-      if (!ssl_stapling_init_cert(ctx, cert, certname)) {
-        Warning("failed to configure SSL_CTX for OCSP Stapling info for certificate at %s", (const char *)certname);
-      }
-    }
-  } else {
-    Debug("ssl", "SSL OCSP Stapling is disabled");
-  }
-#else
-  if (SSLConfigParams::ssl_ocsp_enabled) {
-    Warning("failed to enable SSL OCSP Stapling; this version of OpenSSL does not support it");
-  }
-#endif /* TS_USE_TLS_OCSP */
-
-  // Insert additional mappings. Note that this maps multiple keys to the same value, so when
-  // this code is updated to reconfigure the SSL certificates, it will need some sort of
-  // refcounting or alternate way of avoiding double frees.
+  // Insert additional mappings. Note that this maps multiple keys to the same value, the storage
+  // releases each context only once.
   Debug("ssl", "importing SNI names from %s", (const char *)certname);
   for (auto cert : cert_list) {
     if (ssl_index_certificate(lookup, SSLCertContext(ctx, sslMultCertSettings->opt), cert, certname)) {
@@ -2121,8 +2314,16 @@ ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, cons
   }
 
   if (inserted) {
-    if (SSLConfigParams::init_ssl_ctx_cb) {
-      SSLConfigParams::init_ssl_ctx_cb(ctx, true);
+    if (reuse) {
+      ++lookup->contexts_reused;
+    } else {
+      ++lookup->contexts_built;
+      if (SSLConfigParams::init_ssl_ctx_cb) {
+        SSLConfigParams::init_ssl_ctx_cb(ctx, true);
+      }
+    }
+    if (!fingerprint.empty()) {
+      lookup->keep_reusable(fingerprint, ctx, cert_list, keyblock);
     }
   }
 
@@ -2138,6 +2339,52 @@ ssl_store_ssl_context(const SSLConfigParams *params, SSLCertLookup *lookup, cons
   return ctx;
 }
 
+// Lines that can be loaded on demand are those only selected by SNI and that need no interaction to load.
+static bool
+ssl_lazy_loadable(const ssl_user_config *sslMultCertSettings)
+{
+  return sslMultCertSettings->cert && !sslMultCertSettings->addr && !sslMultCertSettings->dialog &&
+         sslMultCertSettings->opt == SSLCertContext::OPT_NONE;
+}
+
+// Index the certificate names of an ssl_multicert.config line, leaving its context to be built when it is
+// first requested. Only the first certificate of each file is read.
+static bool
+ssl_store_lazy_context(const SSLConfigParams *params, SSLCertLookup *lookup, const ssl_user_config *sslMultCertSettings,
+                       const char *line)
+{
+  SSLCertContext cc(nullptr, sslMultCertSettings->opt);
+  bool inserted = false;
+
+  cc.lazy = std::make_shared<SSLLazyContext>(line);
+
+  SimpleTokenizer cert_tok((const char *)sslMultCertSettings->cert, SSL_CERT_SEPARATE_DELIM);
+  for (const char *certname = cert_tok.getNext(); certname; certname = cert_tok.getNext()) {
+    std::string completeServerCertPath = Layout::relative_to(params->serverCertPathOnly, certname);
+    scoped_BIO bio(BIO_new_file(completeServerCertPath.c_str(), "r"));
+    X509 *cert = nullptr;
+    if (bio) {
+      cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr);
+    }
+    if (!cert) {
+      SSLError("failed to load certificate from %s", completeServerCertPath.c_str());
+      lookup->is_valid = false;
+      return false;
+    }
+
+    if (0 > SSLCheckServerCertNow(cert, certname)) {
+      Debug("ssl", "Marking certificate as NOT VALID: %s", certname);
+      lookup->is_valid = false;
+    }
+    if (ssl_index_certificate(lookup, cc, cert, certname)) {
+      inserted = true;
+    }
+    X509_free(cert);
+  }
+
+  return inserted;
+}
+
 static bool
 ssl_extract_certificate(const matcher_line *line_info, ssl_user_config &sslMultCertSettings)
 {
@@ -2202,7 +2449,7 @@ ssl_extract_certificate(const matcher_line *line_info, ssl_user_config &sslMultC
 }
 
 bool
-SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *lookup)
+SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *lookup, const SSLCertLookup *previous)
 {
   char *tok_state = nullptr;
   char *line      = nullptr;
@@ -2241,7 +2488,9 @@ SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *l
     if (*line != '\0' && *line != '#') {
       ssl_user_config sslMultiCertSettings;
       const char *errPtr;
+      std::string config_line;
 
+      config_line = line; // parsing modifies the line
       errPtr = parseConfigLine(line, &line_info, &sslCertTags);
       Debug("ssl", "currently parsing %s", line);
       if (errPtr != nullptr) {
@@ -2250,8 +2499,10 @@ SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *l
       } else {
         if (ssl_extract_certificate(&line_info, sslMultiCertSettings)) {
           // There must be a certificate specified unless the tunnel action is set
-          if (sslMultiCertSettings.cert || sslMultiCertSettings.opt != SSLCertContext::OPT_TUNNEL) {
-            ssl_store_ssl_context(params, lookup, &sslMultiCertSettings);
+          if (params->configLazyLoad && ssl_lazy_loadable(&sslMultiCertSettings)) {
+            ssl_store_lazy_context(params, lookup, &sslMultiCertSettings, config_line.c_str());
+          } else if (sslMultiCertSettings.cert || sslMultiCertSettings.opt != SSLCertContext::OPT_TUNNEL) {
+            ssl_store_ssl_context(params, lookup, &sslMultiCertSettings, config_line.c_str(), previous);
           } else {
             Warning("No ssl_cert_name specified and no tunnel action set");
           }
@@ -2262,6 +2513,8 @@ SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *l
     line = tokLine(nullptr, &tok_state);
   }
 
+  lookup->lazy_max_contexts = params->configLazyMaxContexts;
+
   // We *must* have a default context even if it can't possibly work. The default context is used to
   // bootstrap the SSL handshake so that we can subsequently do the SNI lookup to switch to the real
   // context.
@@ -2277,6 +2530,43 @@ SSLParseCertificateConfiguration(const SSLConfigParams *params, SSLCertLookup *l
   return true;
 }
 
+SSL_CTX *
+SSLCreateLazyContext(const char *config_line)
+{
+  SSLConfig::scoped_config params;
+  matcher_line line_info;
+  ssl_user_config sslMultiCertSettings;
+  ats_scoped_str line(ats_strdup(config_line));
+
+  const matcher_tags sslCertTags = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, false};
+
+  if (parseConfigLine(line, &line_info, &sslCertTags) != nullptr || !ssl_extract_certificate(&line_info, sslMultiCertSettings)) {
+    return nullptr;
+  }
+
+  uint32_t elevate_setting = 0;
+  REC_ReadConfigInteger(elevate_setting, "proxy.config.ssl.cert.load_elevated");
+  ElevateAccess elevate_access(elevate_setting ? ElevateAccess::FILE_PRIVILEGE : 0);
+
+  std::vector<X509 *> cert_list;
+  SSL_CTX *ctx = SSLInitServerContext(params, &sslMultiCertSettings, cert_list);
+  if (ctx) {
+    Debug("ssl", "built SSL_CTX %p on demand for %s", ctx, (const char *)sslMultiCertSettings.cert);
+    // Only address mapped contexts keep their own ticket keys, so this one uses the default keys.
+    ticket_block_free(ssl_context_enable_multicert_options(ctx, &sslMultiCertSettings, cert_list));
+    if (SSLConfigParams::init_ssl_ctx_cb) {
+      SSLConfigParams::init_ssl_ctx_cb(ctx, true);
+    }
+  } else {
+    Error("failed to build the SSL context for %s on demand", (const char *)sslMultiCertSettings.cert);
+  }
+
+  for (auto &i : cert_list) {
+    X509_free(i);
+  }
+  return ctx;
+}
+
 #if HAVE_OPENSSL_SESSION_TICKETS
 
 static void
@@ -2438,6 +2728,66 @@ SSLReadBuffer(SSL *ssl, void *buf, int64_t nbytes, int64_t &nread)
   return ssl_error;
 }
 
+ssl_error_t
+SSLReadEarlyData(SSL *ssl, void *buf, int64_t nbytes, int64_t &nread, bool &finished)
+{
+  nread    = 0;
+  finished = true;
+#if TS_USE_TLS_EARLY_DATA
+  size_t read_bytes = 0;
+
+  ERR_clear_error();
+  int ret = SSL_read_early_data(ssl, buf, nbytes, &read_bytes);
+  if (ret != SSL_READ_EARLY_DATA_ERROR) {
+    nread    = read_bytes;
+    finished = ret == SSL_READ_EARLY_DATA_FINISH;
+    return SSL_ERROR_NONE;
+  }
+  finished      = false;
+  int ssl_error = SSL_get_error(ssl, ret);
+  if (ssl_error == SSL_ERROR_SSL && is_debug_tag_set("ssl.error.accept")) {
+    char buf[512];
+    unsigned long e = ERR_peek_last_error();
+    ERR_error_string_n(e, buf, sizeof(buf));
+    Debug("ssl.error.accept", "SSL read early data returned %d, ssl_error=%d, ERR_get_error=%ld (%s)", ret, ssl_error, e, buf);
+  }
+
+  return ssl_error;
+#else
+  return SSL_ERROR_NONE;
+#endif
+}
+
+// Write to a client that has sent early data and not yet finished the handshake.
+ssl_error_t
+SSLWriteEarlyData(SSL *ssl, const void *buf, int64_t nbytes, int64_t &nwritten)
+{
+  nwritten = 0;
+#if TS_USE_TLS_EARLY_DATA
+  size_t written_bytes = 0;
+
+  if (unlikely(nbytes == 0)) {
+    return SSL_ERROR_NONE;
+  }
+  ERR_clear_error();
+  int ret = SSL_write_early_data(ssl, buf, nbytes, &written_bytes);
+  if (ret > 0) {
+    nwritten = written_bytes;
+    return SSL_ERROR_NONE;
+  }
+  int ssl_error = SSL_get_error(ssl, ret);
+  if (ssl_error == SSL_ERROR_SSL && is_debug_tag_set("ssl.error.write")) {
+    char buf[512];
+    unsigned long e = ERR_peek_last_error();
+    ERR_error_string_n(e, buf, sizeof(buf));
+    Debug("ssl.error.write", "SSL write early data returned %d, ssl_error=%d, ERR_get_error=%ld (%s)", ret, ssl_error, e, buf);
+  }
+  return ssl_error;
+#else
+  return SSLWriteBuffer(ssl, buf, nbytes, nwritten);
+#endif
+}
+
 ssl_error_t
 SSLAccept(SSL *ssl)
 {
@@ -23,6 +23,58 @@
 #include "HostStatus.h"
 #include "ParentConsistentHash.h"
 
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+// Per parent counters, registered as parents are loaded and kept across reloads.
+constexpr int MAX_PARENT_STATS = 4096;
+RecRawStatBlock *parent_stat_rsb;
+std::mutex parent_stat_mutex;
+std::unordered_map<std::string, int> parent_stat_ids;
+
+// Find or register the counter @a name. Returns its id, or -1 if there is no room for it.
+int
+parent_stat(std::string const &name)
+{
+  std::lock_guard<std::mutex> lock(parent_stat_mutex);
+
+  if (auto spot = parent_stat_ids.find(name); spot != parent_stat_ids.end()) {
+    return spot->second;
+  }
+  if (parent_stat_rsb == nullptr) {
+    parent_stat_rsb = RecAllocateRawStatBlock(MAX_PARENT_STATS);
+  }
+  int id = parent_stat_ids.size();
+  if (parent_stat_rsb == nullptr || id >= MAX_PARENT_STATS) {
+    return -1;
+  }
+  RecRegisterRawStat(parent_stat_rsb, RECT_PROCESS, name.c_str(), RECD_COUNTER, RECP_NON_PERSISTENT, id, RecRawStatSyncCount);
+  parent_stat_ids.emplace(name, id);
+  return id;
+}
+
+void
+register_parent_stats(pRecord *pRec)
+{
+  std::string prefix = "proxy.process.parent_select." + std::string(pRec->hostname) + ":" + std::to_string(pRec->port);
+
+  pRec->selected_stat = parent_stat(prefix + ".selected");
+  pRec->spilled_stat  = parent_stat(prefix + ".spilled");
+}
+
+void
+increment_parent_stat(int id)
+{
+  if (id >= 0) {
+    RecIncrGlobalRawStat(parent_stat_rsb, id, 1);
+  }
+}
+} // namespace
+
 ParentConsistentHash::ParentConsistentHash(ParentRecord *parent_record)
 {
   int i;
@@ -32,21 +84,25 @@ ParentConsistentHash::ParentConsistentHash(ParentRecord *parent_record)
   parents[SECONDARY] = parent_record->secondary_parents;
   ignore_query       = parent_record->ignore_query;
   secondary_mode     = parent_record->secondary_mode;
+  load_factor        = parent_record->hash_load_factor;
   ink_zero(foundParents);
+  ink_zero(in_flight);
 
-  chash[PRIMARY] = new ATSConsistentHash();
+  chash[PRIMARY] = new ATSConsistentHash(1024, nullptr, parent_record->hash_ring);
 
   for (i = 0; i < parent_record->num_parents; i++) {
     chash[PRIMARY]->insert(&(parent_record->parents[i]), parent_record->parents[i].weight, (ATSHash64 *)&hash[PRIMARY]);
+    register_parent_stats(&parent_record->parents[i]);
   }
 
   if (parent_record->num_secondary_parents > 0) {
     Debug("parent_select", "ParentConsistentHash(): initializing the secondary parents hash.");
-    chash[SECONDARY] = new ATSConsistentHash();
+    chash[SECONDARY] = new ATSConsistentHash(1024, nullptr, parent_record->hash_ring);
 
     for (i = 0; i < parent_record->num_secondary_parents; i++) {
       chash[SECONDARY]->insert(&(parent_record->secondary_parents[i]), parent_record->secondary_parents[i].weight,
                                (ATSHash64 *)&hash[SECONDARY]);
+      register_parent_stats(&parent_record->secondary_parents[i]);
     }
   } else {
     chash[SECONDARY] = nullptr;
@@ -141,6 +197,9 @@ ParentConsistentHash::selectParent(bool first_call, ParentResult *result, Reques
   Debug("parent_select", "ParentConsistentHash::%s(): Using a consistent hash parent selection strategy.", __func__);
   ink_assert(numParents(result) > 0 || result->rec->go_direct == true);
 
+  // Whatever happens, this transaction is done with any parent it had.
+  releaseParent(result);
+
   // Should only get into this state if we are supposed to go direct.
   if (parents[PRIMARY] == nullptr && parents[SECONDARY] == nullptr) {
     if (result->rec->go_direct == true && result->rec->parent_is_proxy == true) {
@@ -296,6 +355,9 @@ ParentConsistentHash::selectParent(bool first_call, ParentResult *result, Reques
 
   // use the available or marked for retry parent.
   host_stat = (pRec) ? pStatus.getHostStatus(pRec->hostname) : HostStatus_t::HOST_STATUS_INIT;
+  if (load_factor > 0 && pRec && host_stat == HOST_STATUS_UP && pRec->available && !parentRetry) {
+    pRec = boundLoad(pRec, result, last_lookup);
+  }
   if (pRec && host_stat == HOST_STATUS_UP && (pRec->available || result->retry)) {
     result->result      = PARENT_SPECIFIED;
     result->hostname    = pRec->hostname;
@@ -305,6 +367,13 @@ ParentConsistentHash::selectParent(bool first_call, ParentResult *result, Reques
     result->retry       = parentRetry;
     ink_assert(result->hostname != nullptr);
     ink_assert(result->port != 0);
+    increment_parent_stat(pRec->selected_stat);
+    if (load_factor > 0) {
+      ink_atomic_increment(&pRec->in_flight, 1);
+      ink_atomic_increment(&in_flight[last_lookup], 1);
+      result->in_flight_parent = pRec;
+      result->in_flight_lookup = last_lookup;
+    }
     Debug("parent_select", "Chosen parent: %s.%d", result->hostname, result->port);
   } else {
     if (result->rec->go_direct == true && result->rec->parent_is_proxy == true) {
@@ -337,6 +406,61 @@ ParentConsistentHash::numParents(ParentResult *result) const
   return n;
 }
 
+// Consistent hashing with bounded loads. Starting from the parent the hash chose, walk on around the
+// ring to the first usable parent with fewer than its share of the transactions in flight, times the
+// load factor. Because the load factor is greater than one, there is always such a parent when they
+// are all usable, and a URL keeps going to the same parent unless that parent is overloaded.
+pRecord *
+ParentConsistentHash::boundLoad(pRecord *pRec, ParentResult *result, uint32_t last_lookup)
+{
+  HostStatus &pStatus        = HostStatus::instance();
+  uint32_t n                 = (last_lookup == PRIMARY) ? result->rec->num_parents : result->rec->num_secondary_parents;
+  int32_t capacity           = static_cast<int32_t>(std::ceil(load_factor * (in_flight[last_lookup] + 1) / n));
+  ATSConsistentHashIter iter = result->chashIter[last_lookup];
+  bool wrapped               = false;
+  bool seen[MAX_PARENTS]     = {false};
+  uint32_t n_seen            = 0;
+  pRecord *choice            = pRec;
+
+  while (true) {
+    if (!seen[choice->idx]) {
+      seen[choice->idx] = true;
+      ++n_seen;
+      if (choice->available && pStatus.getHostStatus(choice->hostname) == HOST_STATUS_UP) {
+        if (choice->in_flight < capacity) {
+          if (choice != pRec) {
+            Debug("parent_select", "Parent %s is over its bound of %d in flight, spilled to %s.", pRec->hostname, capacity,
+                  choice->hostname);
+          }
+          return choice;
+        }
+        increment_parent_stat(choice->spilled_stat);
+      }
+      if (n_seen >= n) {
+        break;
+      }
+    }
+    pRecord *prtmp = (pRecord *)chash[last_lookup]->lookup(nullptr, &iter, &wrapped, &hash[last_lookup]);
+    if (prtmp == nullptr) {
+      break;
+    }
+    choice = parents[last_lookup] + prtmp->idx;
+  }
+
+  // Every usable parent is at its bound, which only happens while the counts are changing under us.
+  return pRec;
+}
+
+void
+ParentConsistentHash::releaseParent(ParentResult *result)
+{
+  if (result->in_flight_parent != nullptr) {
+    ink_atomic_increment(&result->in_flight_parent->in_flight, -1);
+    ink_atomic_increment(&in_flight[result->in_flight_lookup], -1);
+    result->in_flight_parent = nullptr;
+  }
+}
+
 void
 ParentConsistentHash::markParentUp(ParentResult *result)
 {
@@ -46,6 +46,11 @@ class ParentConsistentHash : public ParentSelectionStrategy
   bool foundParents[2][MAX_PARENTS];
   bool ignore_query;
   int secondary_mode;
+  // bounded loads: no parent takes more than this times its share of the transactions in flight.
+  float load_factor;
+  int32_t in_flight[2];
+
+  pRecord *boundLoad(pRecord *pRec, ParentResult *result, uint32_t last_lookup);
 
 public:
   static const int PRIMARY   = 0;
@@ -63,4 +68,5 @@ public:
   void markParentDown(ParentResult *result, unsigned int fail_threshold, unsigned int retry_time);
   uint32_t numParents(ParentResult *result) const override;
   void markParentUp(ParentResult *result);
+  void releaseParent(ParentResult *result) override;
 };
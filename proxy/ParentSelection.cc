@@ -123,6 +123,7 @@ ParentConfigParams::findParent(HttpRequestData *rdata, ParentResult *result, uns
     return;
   }
   // Initialize the result structure
+  releaseParent(result);
   result->reset();
 
   // Check to see if the parent was set through the
@@ -509,6 +510,9 @@ ParentRecord::ProcessParents(char *val, bool isPrimary)
       this->parents[i].name                    = this->parents[i].hostname;
       this->parents[i].available               = true;
       this->parents[i].weight                  = weight;
+      this->parents[i].in_flight               = 0;
+      this->parents[i].selected_stat           = -1;
+      this->parents[i].spilled_stat            = -1;
       if (tmp3) {
         memcpy(this->parents[i].hash_string, tmp3 + 1, strlen(tmp3));
         this->parents[i].name = this->parents[i].hash_string;
@@ -525,6 +529,9 @@ ParentRecord::ProcessParents(char *val, bool isPrimary)
       this->secondary_parents[i].name                    = this->secondary_parents[i].hostname;
       this->secondary_parents[i].available               = true;
       this->secondary_parents[i].weight                  = weight;
+      this->secondary_parents[i].in_flight               = 0;
+      this->secondary_parents[i].selected_stat           = -1;
+      this->secondary_parents[i].spilled_stat            = -1;
       if (tmp3) {
         memcpy(this->secondary_parents[i].hash_string, tmp3 + 1, strlen(tmp3));
         this->secondary_parents[i].name = this->secondary_parents[i].hash_string;
@@ -717,6 +724,23 @@ ParentRecord::Init(matcher_line *line_info)
       int v          = atoi(val);
       secondary_mode = v;
       used           = true;
+    } else if (strcasecmp(label, "hash_load_factor") == 0) {
+      float v = atof(val);
+      if (v == 0 || v > 1) {
+        hash_load_factor = v;
+        used             = true;
+      } else {
+        errPtr = "invalid argument to hash_load_factor.  Argument must be greater than 1, or 0 to disable.";
+      }
+    } else if (strcasecmp(label, "hash_ring") == 0) {
+      if (strcasecmp(val, "map") == 0) {
+        hash_ring = ATSConsistentHashRing::MAP;
+      } else if (strcasecmp(val, "array") == 0) {
+        hash_ring = ATSConsistentHashRing::SORTED_ARRAY;
+      } else {
+        errPtr = "invalid argument to hash_ring directive";
+      }
+      used = true;
     }
     // Report errors generated by ProcessParents();
     if (errPtr != nullptr) {
@@ -1772,6 +1796,32 @@ EXCLUSIVE_REGRESSION_TEST(PARENTSELECTION)(RegressionTest * /* t ATS_UNUSED */,
   FP;
   RE(verify(result, PARENT_SPECIFIED, "carol", 80), 211);
 
+  // Test 212
+  // With bounded loads, a url spills past its parent while the parent has more than its share in flight.
+  tbl[0] = '\0';
+  ST(212);
+  T("dest_domain=stooges.net parent=curly:80,joe:80,larry:80 "
+    "round_robin=consistent_hash hash_load_factor=1.5 go_direct=false\n");
+  REBUILD;
+  REINIT;
+  _st.setHostStatus("curly", HOST_STATUS_UP, 0, Reasons::MANUAL);
+  br(request, "i.am.stooges.net");
+  {
+    ParentResult first, second, third, again;
+    params->findParent(request, &first, fail_threshold, retry_time);
+    params->findParent(request, &second, fail_threshold, retry_time);
+    params->findParent(request, &third, fail_threshold, retry_time);
+    params->releaseParent(&first);
+    params->releaseParent(&second);
+    params->releaseParent(&third);
+    params->findParent(request, &again, fail_threshold, retry_time);
+    params->releaseParent(&again);
+    RE(first.result == PARENT_SPECIFIED && second.result == PARENT_SPECIFIED && third.result == PARENT_SPECIFIED &&
+         strcmp(first.hostname, second.hostname) != 0 && strcmp(first.hostname, third.hostname) == 0 &&
+         verify(&again, PARENT_SPECIFIED, first.hostname, 80),
+       212);
+  }
+
   delete request;
   delete result;
   delete params;
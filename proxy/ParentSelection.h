@@ -103,6 +103,9 @@ struct pRecord : ATSConsistentHashNode {
   int idx;
   float weight;
   char hash_string[MAXDNAME + 1];
+  int32_t in_flight; // transactions sent to this parent, when loads are bounded
+  int selected_stat; // stat ids for the consistent hash counters, or -1
+  int spilled_stat;
 };
 
 typedef ControlMatcher<ParentRecord, ParentResult> P_table;
@@ -146,6 +149,8 @@ public:
   int max_simple_retries                                             = 1;
   int max_unavailable_server_retries                                 = 1;
   int secondary_mode                                                 = 1;
+  ATSConsistentHashRing hash_ring                                    = ATSConsistentHashRing::MAP;
+  float hash_load_factor                                             = 0;
 };
 
 // If the parent was set by the external customer api,
@@ -258,6 +263,9 @@ private:
   // state for consistent hash.
   int last_lookup;
   ATSConsistentHashIter chashIter[2];
+  // parent counted as having this transaction in flight, and the list it came from.
+  pRecord *in_flight_parent;
+  int in_flight_lookup;
 
   friend class ParentConsistentHash;
   friend class ParentRoundRobin;
@@ -297,6 +305,15 @@ public:
   void markParentDown(ParentResult *result, unsigned int fail_threshold, unsigned int retry_time);
   void markParentUp(ParentResult *result);
 
+  // void releaseParent(ParentResult *result);
+  //
+  // The transaction is done with the parent in the result.
+  //
+  virtual void
+  releaseParent(ParentResult *result)
+  {
+  }
+
   // virtual destructor.
   virtual ~ParentSelectionStrategy(){};
 };
@@ -340,6 +357,14 @@ public:
     }
   }
 
+  void
+  releaseParent(ParentResult *result)
+  {
+    if (result->in_flight_parent != nullptr) {
+      result->rec->selection_strategy->releaseParent(result);
+    }
+  }
+
   uint32_t
   numParents(ParentResult *result)
   {
@@ -428,6 +428,16 @@ HdrHeap::evacuate_from_str_heaps(HdrStrHeap *new_heap)
   }
 }
 
+size_t
+HdrHeap::total_used_size() const
+{
+  size_t size = 0;
+  for (const HdrHeap *h = this; h; h = h->m_next) {
+    size += h->m_free_start - h->m_data_start;
+  }
+  return size;
+}
+
 size_t
 HdrHeap::required_space_for_evacuation()
 {
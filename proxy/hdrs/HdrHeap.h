@@ -197,6 +197,8 @@ public:
   /// Callers should round up to HDR_PTR_SIZE to get the actual footprint.
   int unmarshal_size() const; // TBD - change this name, it's confusing.
   // One option - overload marshal_length to return this value if @a magic is HDR_BUF_MAGIC_MARSHALED.
+  /// Bytes of header objects in use across this heap and its overflow heaps.
+  size_t total_used_size() const;
 
   void inherit_string_heaps(const HdrHeap *inherit_from);
   int attach_block(IOBufferBlock *b, const char *use_start);
@@ -22,10 +22,10 @@
  */
 
 #include "tscore/ink_platform.h"
-#include "tscore/HashFNV.h"
 #include "tscore/Diags.h"
 #include "tscore/ink_memory.h"
 #include <cstdio>
+#include <algorithm>
 #include "tscore/Allocator.h"
 #include "HTTP.h"
 #include "HdrToken.h"
@@ -261,33 +261,70 @@ DFA *hdrtoken_strs_dfa = nullptr;
  *                                                                     *
  ***********************************************************************/
 
-#define HDRTOKEN_HASH_TABLE_SIZE 65536
+// The hash table is a perfect hash over _hdrtoken_commonly_tokenized_strs, built by
+// hdrtoken_hash_init(). A multiplier is searched for that maps every string to its own slot,
+// so a lookup is one hash, one table probe and one compare against a single candidate.
+#define HDRTOKEN_HASH_TABLE_BITS 11
+#define HDRTOKEN_HASH_TABLE_SIZE (1 << HDRTOKEN_HASH_TABLE_BITS)
+#define HDRTOKEN_HASH_SEED_TRIES (1 << 20)
 
-struct HdrTokenHashBucket {
+// Strings up to this many 8 byte words are compared a word at a time.
+#define HDRTOKEN_CMP_WORDS 4
+
+struct HdrTokenHashEntry {
   const char *wks;
-  uint32_t hash;
+  int length;
+  uint64_t case_mask[HDRTOKEN_CMP_WORDS]; // 0x20 in each byte that is a letter
+  uint64_t folded[HDRTOKEN_CMP_WORDS];    // the string with case_mask applied, zero padded
 };
 
-HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
+static HdrTokenHashEntry hdrtoken_hash_entries[UINT8_MAX];
+static uint8_t hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE]; // slot -> entry index + 1, 0 if empty
+static uint32_t hdrtoken_hash_seed;
 
 /**
-  basic FNV hash
+  FNV-1a hash with the ASCII case bit forced on. This folds letter case, and the few non-letter
+  bytes that are folded together as well are caught by the compare.
 **/
-#define TINY_MASK(x) (((uint32_t)1 << (x)) - 1)
-
 inline uint32_t
-hash_to_slot(uint32_t hash)
+hdrtoken_hash(const unsigned char *string, unsigned int length)
 {
-  return ((hash >> 15) ^ hash) & TINY_MASK(15);
+  uint32_t hval = 0x811c9dc5;
+
+  for (unsigned int i = 0; i < length; ++i) {
+    hval ^= string[i] | 0x20;
+    hval *= 0x01000193;
+  }
+  return hval;
 }
 
 inline uint32_t
-hdrtoken_hash(const unsigned char *string, unsigned int length)
+hash_to_slot(uint32_t hash, uint32_t seed = hdrtoken_hash_seed)
+{
+  return (hash * seed) >> (32 - HDRTOKEN_HASH_TABLE_BITS);
+}
+
+/**
+  Case insensitive compare of @a string against @a entry, a word at a time. Letters are compared
+  with the case bit forced on, every other byte must match exactly.
+**/
+static inline bool
+hdrtoken_hash_entry_match(const HdrTokenHashEntry *entry, const char *string, int length)
 {
-  ATSHash32FNV1a fnv;
-  fnv.update(string, length, ATSHash::nocase());
-  fnv.final();
-  return fnv.get();
+  if (entry->length != length) {
+    return false;
+  }
+  if (length > HDRTOKEN_CMP_WORDS * 8) {
+    return strncasecmp(entry->wks, string, length) == 0;
+  }
+  for (int i = 0; length > 0; ++i, string += 8, length -= 8) {
+    uint64_t word = 0;
+    memcpy(&word, string, std::min(length, 8));
+    if ((word | entry->case_mask[i]) != entry->folded[i]) {
+      return false;
+    }
+  }
+  return true;
 }
 
 /*-------------------------------------------------------------------------
@@ -368,33 +405,52 @@ void
 hdrtoken_hash_init()
 {
   uint32_t i;
-  int num_collisions;
+  uint32_t hashes[SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+
+  static_assert(SIZEOF(_hdrtoken_commonly_tokenized_strs) < SIZEOF(hdrtoken_hash_entries),
+                "too many commonly tokenized strings for the hash table");
 
-  memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
-  num_collisions = 0;
+  memset(hdrtoken_hash_entries, 0, sizeof(hdrtoken_hash_entries));
 
-  for (i = 0; i < (int)SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
+  for (i = 0; i < SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
     // convert the common string to the well-known token
-    unsigned const char *wks;
+    const char *wks;
     int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i], (int)strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **)&wks);
+                                        &wks);
     ink_release_assert(wks_idx >= 0);
 
-    uint32_t hash = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    uint32_t slot = hash_to_slot(hash);
-
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n", slot, (const char *)wks,
-             hdrtoken_hash_table[slot].wks);
-      ++num_collisions;
+    HdrTokenHashEntry *entry = &hdrtoken_hash_entries[i];
+    entry->wks               = wks;
+    entry->length            = hdrtoken_str_lengths[wks_idx];
+    for (int j = 0; j < entry->length && j < HDRTOKEN_CMP_WORDS * 8; ++j) {
+      unsigned char bit                                      = ParseRules::is_alpha(wks[j]) ? 0x20 : 0;
+      reinterpret_cast<unsigned char *>(entry->case_mask)[j] = bit;
+      reinterpret_cast<unsigned char *>(entry->folded)[j]    = wks[j] | bit;
     }
-    hdrtoken_hash_table[slot].wks  = (const char *)wks;
-    hdrtoken_hash_table[slot].hash = hash;
+    hashes[i] = hdrtoken_hash(reinterpret_cast<const unsigned char *>(wks), entry->length);
   }
 
-  if (num_collisions > 0) {
-    abort();
+  // Search for a multiplier that puts every string in a slot of its own. This is deterministic,
+  // so the same seed is found on every start up.
+  uint32_t seed = 0x9e3779b1;
+  for (int tries = 0;; ++tries, seed += 2) {
+    if (tries >= HDRTOKEN_HASH_SEED_TRIES) {
+      printf("ERROR: no perfect hash for hdrtoken_hash_table\n");
+      abort();
+    }
+    memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
+    for (i = 0; i < SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
+      uint32_t slot = hash_to_slot(hashes[i], seed);
+      if (hdrtoken_hash_table[slot]) {
+        break;
+      }
+      hdrtoken_hash_table[slot] = i + 1;
+    }
+    if (i == SIZEOF(_hdrtoken_commonly_tokenized_strs)) {
+      break;
+    }
   }
+  hdrtoken_hash_seed = seed;
 }
 
 /***********************************************************************
@@ -546,7 +602,7 @@ int
 hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_out)
 {
   int wks_idx;
-  HdrTokenHashBucket *bucket;
+  HdrTokenHashEntry *entry;
 
   ink_assert(string != nullptr);
 
@@ -561,13 +617,15 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
   uint32_t hash = hdrtoken_hash((const unsigned char *)string, (unsigned int)string_len);
   uint32_t slot = hash_to_slot(hash);
 
-  bucket = &(hdrtoken_hash_table[slot]);
-  if ((bucket->wks != nullptr) && (bucket->hash == hash) && (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
-    wks_idx = hdrtoken_wks_to_index(bucket->wks);
-    if (wks_string_out) {
-      *wks_string_out = bucket->wks;
+  if (hdrtoken_hash_table[slot]) {
+    entry = &hdrtoken_hash_entries[hdrtoken_hash_table[slot] - 1];
+    if (hdrtoken_hash_entry_match(entry, string, string_len)) {
+      wks_idx = hdrtoken_wks_to_index(entry->wks);
+      if (wks_string_out) {
+        *wks_string_out = entry->wks;
+      }
+      return wks_idx;
     }
-    return wks_idx;
   }
 
   Debug("hdr_token", "Did not find a WKS for '%.*s'", string_len, string);
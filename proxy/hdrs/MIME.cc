@@ -34,6 +34,10 @@
 #include "HdrUtils.h"
 #include "HttpCompat.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /***********************************************************************
  *                                                                     *
  *                    C O M P I L E    O P T I O N S                   *
@@ -2361,6 +2365,36 @@ mime_scanner_append(MIMEScanner *scanner, const char *data, int data_size)
   scanner->m_line_length += data_size;
 }
 
+/** Find the first LF or NUL byte in [ @a s, @a e ).
+
+    A field line is scanned for its terminating LF, and the scanned input must not contain any NUL
+    bytes. Checking both in a single pass avoids walking the (possibly very large, e.g. Cookie)
+    field a second time. With SSE2 available this compares 16 bytes per step.
+
+    @return A pointer to the first LF or NUL, or @a e if there is neither.
+*/
+static inline const char *
+mime_scan_lf_or_nul(const char *s, const char *e)
+{
+#if defined(__SSE2__)
+  const __m128i lf  = _mm_set1_epi8(ParseRules::CHAR_LF);
+  const __m128i nul = _mm_setzero_si128();
+
+  while (e - s >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    int mask      = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, nul)));
+    if (mask) {
+      return s + __builtin_ctz(mask);
+    }
+    s += 16;
+  }
+#endif
+  while (s < e && *s != ParseRules::CHAR_LF && *s != '\0') {
+    ++s;
+  }
+  return s;
+}
+
 ParseResult
 mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input_e, const char **output_s, const char **output_e,
                  bool *output_shares_raw_input,
@@ -2369,6 +2403,7 @@ mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input
 {
   const char *raw_input_c, *lf_ptr;
   ParseResult zret = PARSE_RESULT_CONT;
+  bool saw_nul     = false; // NUL found in the scanned input.
   // Need this for handling dangling CR.
   static const char RAW_CR = ParseRules::CHAR_CR;
 
@@ -2414,8 +2449,14 @@ mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input
       }
       break;
     case MIME_PARSE_INSIDE:
-      lf_ptr = static_cast<const char *>(memchr(raw_input_c, ParseRules::CHAR_LF, runway));
-      if (lf_ptr) {
+      // Every byte that can be a NUL is consumed in this state, so the check for embedded NUL
+      // is folded in to the search for the LF.
+      lf_ptr = mime_scan_lf_or_nul(raw_input_c, raw_input_e);
+      while (lf_ptr < raw_input_e && '\0' == *lf_ptr) {
+        saw_nul = true;
+        lf_ptr  = mime_scan_lf_or_nul(lf_ptr + 1, raw_input_e);
+      }
+      if (lf_ptr < raw_input_e) {
         raw_input_c = lf_ptr + 1;
         if (MIME_SCANNER_TYPE_LINE == raw_input_scan_type) {
           zret       = PARSE_RESULT_OK;
@@ -2506,7 +2547,7 @@ mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input
   }
 
   // Make sure there are no '\0' in the input scanned so far
-  if (zret != PARSE_RESULT_ERROR && memchr(*raw_input_s, '\0', raw_input_c - *raw_input_s) != nullptr) {
+  if (zret != PARSE_RESULT_ERROR && saw_nul) {
     zret = PARSE_RESULT_ERROR;
   }
 
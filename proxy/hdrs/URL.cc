@@ -98,6 +98,8 @@ int URL_LEN_MMST;
 // url_CryptoHash_get_fast() does NOT produce the same result as url_CryptoHash_get_general().
 static int url_hash_method = 0;
 
+URLHashContext::HashType URLHashContext::Setting = CryptoContext::UNSPECIFIED;
+
 // test to see if a character is a valid character for a host in a URI according to
 // RFC 3986 and RFC 1034
 inline static int
@@ -1780,7 +1782,7 @@ url_CryptoHash_get(const URLImpl *url, CryptoHash *hash, cache_generation_t gene
 void
 url_host_CryptoHash_get(URLImpl *url, CryptoHash *hash)
 {
-  CryptoContext ctx;
+  URLHashContext ctx;
 
   if (url->m_ptr_scheme) {
     ctx.update(url->m_ptr_scheme, url->m_len_scheme);
@@ -86,7 +86,18 @@ struct URLImpl : public HdrHeapObjImpl {
   void check_strings(HeapCheck *heaps, int num_heaps);
 };
 
-using URLHashContext = CryptoContext;
+/** Hash context for cache keys.
+
+    This has its own hash type setting, separate from @c CryptoContext::Setting, because the hash
+    used for cache keys is dictated by the cache stripes on disk.
+*/
+class URLHashContext : public CryptoContext
+{
+public:
+  URLHashContext() : CryptoContext(Setting) {}
+  /// Hash type for cache keys.
+  static HashType Setting;
+};
 
 extern const char *URL_SCHEME_FILE;
 extern const char *URL_SCHEME_FTP;
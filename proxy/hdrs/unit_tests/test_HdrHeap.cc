@@ -0,0 +1,151 @@
+/** @file
+
+   Catch-based tests for copying headers out of a marshalled HdrHeap.
+
+   @section license License
+
+   Licensed to the Apache Software Foundation (ASF) under one or more contributor license agreements.
+   See the NOTICE file distributed with this work for additional information regarding copyright
+   ownership.  The ASF licenses this file to you under the Apache License, Version 2.0 (the
+   "License"); you may not use this file except in compliance with the License.  You may obtain a
+   copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software distributed under the License
+   is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+   or implied. See the License for the specific language governing permissions and limitations under
+   the License.
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "catch.hpp"
+
+#include "HdrHeap.h"
+#include "HTTP.h"
+
+using namespace std::literals;
+
+namespace
+{
+// A response with enough fields that its objects overflow a default sized heap.
+std::string
+response_text()
+{
+  std::string text{"HTTP/1.1 200 OK\r\n"
+                   "Date: Fri, 15 Feb 2019 20:18:01 GMT\r\n"
+                   "Server: ATS/9.0.0\r\n"
+                   "Content-Type: text/html; charset=utf-8\r\n"
+                   "Content-Length: 35621\r\n"
+                   "Cache-Control: public, max-age=3600\r\n"};
+  for (int i = 0; i < 96; ++i) {
+    text += "X-Cache-Tag-";
+    text += std::to_string(i);
+    text += ": tag-value-";
+    text += std::to_string(i);
+    text += "\r\n";
+  }
+  text += "\r\n";
+  return text;
+}
+
+/// The header as it comes back from the cache, unmarshalled in place in @a buf.
+struct CachedResponse {
+  explicit CachedResponse(std::string_view text)
+  {
+    HTTPHdr hdr;
+    HTTPParser parser;
+    char const *start = text.data();
+
+    hdr.create(HTTP_TYPE_RESPONSE);
+    http_parser_init(&parser);
+    REQUIRE(PARSE_RESULT_DONE == hdr.parse_resp(&parser, &start, text.data() + text.size(), true));
+    http_parser_clear(&parser);
+
+    buf.resize(hdr.m_heap->marshal_length());
+    int len = hdr.m_heap->marshal(buf.data(), buf.size());
+    REQUIRE(len > 0);
+    hdr.destroy();
+
+    REQUIRE(response.unmarshal(buf.data(), len, ref.get()) > 0);
+  }
+
+  ~CachedResponse() { response.clear(); }
+
+  Ptr<RefCountObj> ref{new RefCountObj};
+  std::vector<char> buf;
+  HTTPHdr response;
+};
+
+// Copy @a src into the empty @a dst the way HTTPHdr::copy did before sizing the heap, for comparison.
+void
+copy_default_heap(HTTPHdr &dst, HTTPHdr const *src)
+{
+  dst.m_heap = new_HdrHeap();
+  dst.m_http = http_hdr_clone(src->m_http, src->m_heap, dst.m_heap);
+  dst.m_mime = dst.m_http->m_fields_impl;
+}
+
+} // namespace
+
+TEST_CASE("HdrHeap copy from cache", "[proxy][hdrheap]")
+{
+  http_init();
+
+  auto text = response_text();
+  CachedResponse cached(text);
+  REQUIRE(cached.response.m_heap->total_used_size() > HDR_MAX_ALLOC_SIZE);
+
+  HTTPHdr copy;
+  copy.copy(&cached.response);
+
+  // All the objects fit in the first heap and the strings are still those of the cache buffer.
+  REQUIRE(copy.m_heap->m_next == nullptr);
+  REQUIRE(copy.fields_count() == cached.response.fields_count());
+  REQUIRE(copy.status_get() == HTTP_STATUS_OK);
+
+  int len           = 0;
+  char const *value = copy.value_get("X-Cache-Tag-95", 14, &len);
+  REQUIRE(std::string_view(value, len) == "tag-value-95"sv);
+  REQUIRE(value >= cached.buf.data());
+  REQUIRE(value < cached.buf.data() + cached.buf.size());
+
+  // The copy is writable and independent of the cached header.
+  copy.field_delete("X-Cache-Tag-0", 13);
+  REQUIRE(copy.fields_count() + 1 == cached.response.fields_count());
+  REQUIRE(cached.response.value_get("X-Cache-Tag-0", 13, &len) != nullptr);
+
+  copy.destroy();
+}
+
+// Performance test, hidden by default. Run with `test_proxy_hdrs "[performance]"`.
+// Compares HTTPHdr::copy against copying into a default sized heap, as it used to.
+TEST_CASE("HdrHeap copy from cache performance", "[proxy][hdrheap][performance][.]")
+{
+  constexpr int N_LOOPS = 100000;
+
+  http_init();
+
+  auto text = response_text();
+  CachedResponse cached(text);
+
+  auto run = [&](char const *name, auto const &copy_fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_LOOPS; ++i) {
+      HTTPHdr copy;
+      copy_fn(copy);
+      copy.destroy();
+    }
+    auto delta = std::chrono::high_resolution_clock::now() - start;
+    std::cout << name << " " << cached.response.m_heap->total_used_size() << " object bytes: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / N_LOOPS << "ns per copy" << std::endl;
+  };
+
+  run("default sized heap", [&](HTTPHdr &copy) { copy_default_heap(copy, &cached.response); });
+  run("HTTPHdr::copy", [&](HTTPHdr &copy) { copy.copy(&cached.response); });
+}
@@ -0,0 +1,113 @@
+/** @file
+
+   Catch-based tests for HdrToken.cc
+
+   @section license License
+
+   Licensed to the Apache Software Foundation (ASF) under one or more contributor license agreements.
+   See the NOTICE file distributed with this work for additional information regarding copyright
+   ownership.  The ASF licenses this file to you under the Apache License, Version 2.0 (the
+   "License"); you may not use this file except in compliance with the License.  You may obtain a
+   copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software distributed under the License
+   is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+   or implied. See the License for the specific language governing permissions and limitations under
+   the License.
+ */
+
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <iostream>
+
+#include "catch.hpp"
+
+#include "HdrToken.h"
+
+using namespace std::literals;
+
+namespace
+{
+// Field names as they appear in a typical request and response.
+constexpr std::string_view FIELD_NAMES[] = {
+  "Host"sv,          "User-Agent"sv,       "Accept"sv,        "Accept-Language"sv, "Accept-Encoding"sv,
+  "Referer"sv,       "Connection"sv,       "Cookie"sv,        "Cache-Control"sv,   "If-Modified-Since"sv,
+  "If-None-Match"sv, "Date"sv,             "Server"sv,        "Content-Type"sv,    "Content-Length"sv,
+  "Last-Modified"sv, "ETag"sv,             "Vary"sv,          "Set-Cookie"sv,      "Age"sv,
+  "Via"sv,           "X-Forwarded-For"sv,  "X-Request-Id"sv,  "Strict-Transport-Security"sv,
+  "Upgrade-Insecure-Requests"sv,
+};
+
+int
+tokenize(std::string_view name, const char **wks = nullptr)
+{
+  return hdrtoken_tokenize(name.data(), static_cast<int>(name.size()), wks);
+}
+} // namespace
+
+TEST_CASE("HdrToken", "[proxy][hdrtoken]")
+{
+  hdrtoken_init();
+
+  const char *wks = nullptr;
+  int idx         = tokenize("Content-Length"sv, &wks);
+  REQUIRE(idx >= 0);
+  REQUIRE(std::string_view(wks, hdrtoken_wks_to_length(wks)) == "Content-Length"sv);
+  REQUIRE(idx == tokenize("content-length"sv));
+  REQUIRE(idx == tokenize("CONTENT-LENGTH"sv));
+  REQUIRE(idx == tokenize("cOnTeNt-LeNgTh"sv));
+
+  // Longer than the word-at-a-time compare.
+  REQUIRE(tokenize("strict-transport-security"sv) == tokenize("Strict-Transport-Security"sv));
+  REQUIRE(tokenize("strict-transport-security"sv) >= 0);
+
+  // Near misses must not match, including bytes that only differ in the case bit.
+  REQUIRE(tokenize("Content-Lengt"sv) < 0);
+  REQUIRE(tokenize("Content-Lengthh"sv) < 0);
+  REQUIRE(tokenize("Content\rLength"sv) < 0);
+  REQUIRE(tokenize("X-Request-Id"sv) < 0);
+  REQUIRE(tokenize(""sv) < 0);
+
+  // Every field name the DFA knows is found the same way by the hash.
+  for (auto name : FIELD_NAMES) {
+    const char *dfa_wks = nullptr;
+    int dfa_idx         = hdrtoken_tokenize_dfa(name.data(), static_cast<int>(name.size()), &dfa_wks);
+    if (dfa_idx >= 0 && static_cast<size_t>(hdrtoken_wks_to_length(dfa_wks)) == name.size()) {
+      REQUIRE(tokenize(name, &wks) == dfa_idx);
+      REQUIRE(wks == dfa_wks);
+    }
+  }
+}
+
+// Performance test, hidden by default. Run with `test_proxy_hdrs "[performance]"`.
+TEST_CASE("HdrToken performance", "[proxy][hdrtoken][performance][.]")
+{
+  constexpr int N_LOOPS = 1000000;
+  int found             = 0;
+
+  hdrtoken_init();
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < N_LOOPS; ++i) {
+    for (auto name : FIELD_NAMES) {
+      found += tokenize(name) >= 0;
+    }
+  }
+  auto delta = std::chrono::high_resolution_clock::now() - start;
+  std::cout << "hdrtoken_tokenize " << std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / (N_LOOPS * std::size(FIELD_NAMES))
+            << "ns per name" << std::endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < N_LOOPS; ++i) {
+    for (auto name : FIELD_NAMES) {
+      found += hdrtoken_tokenize_dfa(name.data(), static_cast<int>(name.size())) >= 0;
+    }
+  }
+  delta = std::chrono::high_resolution_clock::now() - start;
+  std::cout << "hdrtoken_tokenize_dfa " << std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / (N_LOOPS * std::size(FIELD_NAMES))
+            << "ns per name" << std::endl;
+  REQUIRE(found > 0);
+}
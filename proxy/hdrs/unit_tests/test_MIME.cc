@@ -0,0 +1,133 @@
+/** @file
+
+   Catch-based tests for the MIME scanner and parser.
+
+   @section license License
+
+   Licensed to the Apache Software Foundation (ASF) under one or more contributor license agreements.
+   See the NOTICE file distributed with this work for additional information regarding copyright
+   ownership.  The ASF licenses this file to you under the Apache License, Version 2.0 (the
+   "License"); you may not use this file except in compliance with the License.  You may obtain a
+   copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software distributed under the License
+   is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+   or implied. See the License for the specific language governing permissions and limitations under
+   the License.
+ */
+
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <iostream>
+
+#include "catch.hpp"
+
+#include "HdrHeap.h"
+#include "MIME.h"
+
+using namespace std::literals;
+
+namespace
+{
+ParseResult
+parse(std::string_view text, bool eof = true)
+{
+  HdrHeap *heap = new_HdrHeap(HdrHeap::DEFAULT_SIZE + 64);
+  MIMEParser parser;
+  MIMEHdr mime;
+  char const *real_s = text.data();
+  char const *real_e = text.data() + text.size();
+
+  mime.create(heap);
+  mime_parser_init(&parser);
+  auto result = mime_parser_parse(&parser, heap, mime.m_mime, &real_s, real_e, false, eof);
+  mime_parser_clear(&parser);
+  heap->destroy();
+  return result;
+}
+
+// A request header set with a large cookie, roughly what a browser sends to a busy site.
+std::string
+request_corpus()
+{
+  std::string text{"Host: www.example.com\r\n"
+                   "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:65.0) Gecko/20100101 Firefox/65.0\r\n"
+                   "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+                   "Accept-Language: en-US,en;q=0.5\r\n"
+                   "Accept-Encoding: gzip, deflate, br\r\n"
+                   "Referer: https://www.example.com/some/long/path/to/a/page.html?query=value&other=thing\r\n"
+                   "Connection: keep-alive\r\n"
+                   "Upgrade-Insecure-Requests: 1\r\n"
+                   "Cookie: "};
+  for (int i = 0; i < 64; ++i) {
+    text += "session_key_";
+    text += std::to_string(i);
+    text += "=0123456789abcdef0123456789abcdef0123456789abcdef; ";
+  }
+  text += "last=1\r\n\r\n";
+  return text;
+}
+
+std::string
+response_corpus()
+{
+  return {"Date: Fri, 15 Feb 2019 20:18:01 GMT\r\n"
+          "Server: ATS/9.0.0\r\n"
+          "Content-Type: text/html; charset=utf-8\r\n"
+          "Content-Length: 35621\r\n"
+          "Cache-Control: public, max-age=3600\r\n"
+          "Last-Modified: Fri, 15 Feb 2019 19:00:00 GMT\r\n"
+          "ETag: \"5c670bd0-8b25\"\r\n"
+          "Vary: Accept-Encoding\r\n"
+          "Set-Cookie: tracking=0123456789abcdef0123456789abcdef; Path=/; Domain=.example.com; Secure; HttpOnly\r\n"
+          "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+          "Age: 12\r\n"
+          "\r\n"};
+}
+
+} // namespace
+
+TEST_CASE("MIMEScanner", "[proxy][mime]")
+{
+  // Embedded NUL anywhere in a field is an error, including past the first 16 bytes.
+  REQUIRE(PARSE_RESULT_DONE == parse("Host: www.example.com\r\n\r\n"sv));
+  REQUIRE(PARSE_RESULT_ERROR == parse("Host: www.exa\0mple.com\r\n\r\n"sv));
+  REQUIRE(PARSE_RESULT_ERROR == parse("X-Long-Field-Name: 0123456789abcdef0123456789\0abcdef\r\n\r\n"sv));
+  REQUIRE(PARSE_RESULT_ERROR == parse("A: b\r\nX-Long-Field-Name: 0123456789abcdef0123456789abcdef\0\r\n\r\n"sv));
+
+  // Folded lines and bare LF terminators.
+  REQUIRE(PARSE_RESULT_DONE == parse("X-Folded: alpha\r\n bravo\r\n\tcharlie\r\n\r\n"sv));
+  REQUIRE(PARSE_RESULT_DONE == parse("One: alpha\nTwo: bravo\n\n"sv));
+
+  // Incomplete input.
+  REQUIRE(PARSE_RESULT_CONT == parse("X-Long-Field-Name: 0123456789abcdef0123456789abcdef"sv, false));
+  REQUIRE(PARSE_RESULT_ERROR == parse("X-Long-Field-Name: 0123456789abcdef0123456789abcdef"sv, true));
+
+  auto text = request_corpus();
+  REQUIRE(PARSE_RESULT_DONE == parse(text));
+  text[text.size() - 10] = '\0'; // inside the cookie value.
+  REQUIRE(PARSE_RESULT_ERROR == parse(text));
+  REQUIRE(PARSE_RESULT_DONE == parse(response_corpus()));
+}
+
+// Performance test, hidden by default. Run with `test_proxy_hdrs "[performance]"`.
+TEST_CASE("MIMEScanner performance", "[proxy][mime][performance][.]")
+{
+  constexpr int N_LOOPS = 100000;
+  std::string const corpus[] = {request_corpus(), response_corpus()};
+
+  for (auto const &text : corpus) {
+    int done   = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_LOOPS; ++i) {
+      done += PARSE_RESULT_DONE == parse(text);
+    }
+    auto delta = std::chrono::high_resolution_clock::now() - start;
+    REQUIRE(done == N_LOOPS);
+    std::cout << "mime_parser_parse " << text.size() << " bytes: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / N_LOOPS << "ns per header" << std::endl;
+  }
+}
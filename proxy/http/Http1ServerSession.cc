@@ -35,6 +35,7 @@
 #include "Http1ServerSession.h"
 #include "HttpSessionManager.h"
 #include "HttpSM.h"
+#include "http2/Http2ServerSession.h"
 
 static int64_t next_ss_id = (int64_t)0;
 ClassAllocator<Http1ServerSession> http1ServerSessionAllocator("http1ServerSessionAllocator");
@@ -51,6 +52,10 @@ Http1ServerSession::destroy()
     read_buffer = nullptr;
   }
 
+  if (prewarm_dest) {
+    PreWarmManager::note_closed(this);
+  }
+
   mutex.clear();
   if (TS_SERVER_SESSION_SHARING_POOL_THREAD == sharing_pool) {
     THREAD_FREE(this, http1ServerSessionAllocator, this_thread());
@@ -86,11 +91,43 @@ Http1ServerSession::new_connection(NetVConnection *new_vc)
   new_vc->set_tcp_congestion_control(SERVER_SIDE);
 }
 
+void
+Http1ServerSession::new_stream(Http2ServerStream *stream, NetVConnection *netvc)
+{
+  ink_assert(stream != nullptr && netvc != nullptr);
+  server_vc = netvc;
+  h2_stream = stream;
+  mutex     = stream->mutex;
+
+  con_id = ink_atomic_increment((int64_t *)(&next_ss_id), 1);
+
+  magic = HTTP_SS_MAGIC_ALIVE;
+#ifdef LAZY_BUF_ALLOC
+  read_buffer = new_empty_MIOBuffer(HTTP_SERVER_RESP_HDR_BUFFER_INDEX);
+#else
+  read_buffer = new_MIOBuffer(HTTP_SERVER_RESP_HDR_BUFFER_INDEX);
+#endif
+  buf_reader = read_buffer->alloc_reader();
+  Debug("http_ss", "[%" PRId64 "] session born on stream %u, netvc %p", con_id, stream->get_id(), netvc);
+  state = HSS_INIT;
+}
+
+void
+Http1ServerSession::attach_stream(Http2ServerStream *stream)
+{
+  ink_assert(h2_stream == nullptr);
+  h2_stream        = stream;
+  conn_track_group = nullptr;
+  to_parent_proxy  = false;
+  Debug("http_ss", "[%" PRId64 "] session moved to stream %u", con_id, stream->get_id());
+}
+
 void
 Http1ServerSession::enable_outbound_connection_tracking(OutboundConnTrack::Group *group)
 {
   ink_assert(nullptr == conn_track_group);
   conn_track_group = group;
+  ++group->_opened;
   if (is_debug_tag_set("http_ss")) {
     ts::LocalBufferWriter<256> w;
     w.print("[{}] new connection, ip: {}, group ({}), count: {}\0", con_id, get_server_ip(), *group, group->_count);
@@ -101,19 +138,49 @@ Http1ServerSession::enable_outbound_connection_tracking(OutboundConnTrack::Group
 VIO *
 Http1ServerSession::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
 {
+  if (h2_stream) {
+    return h2_stream->do_io_read(c, nbytes, buf);
+  }
   return server_vc ? server_vc->do_io_read(c, nbytes, buf) : nullptr;
 }
 
 VIO *
 Http1ServerSession::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *buf, bool owner)
 {
+  if (h2_stream) {
+    return h2_stream->do_io_write(c, nbytes, buf, owner);
+  }
   return server_vc ? server_vc->do_io_write(c, nbytes, buf, owner) : nullptr;
 }
 
 void
 Http1ServerSession::do_io_shutdown(ShutdownHowTo_t howto)
 {
-  server_vc->do_io_shutdown(howto);
+  if (h2_stream) {
+    h2_stream->do_io_shutdown(howto);
+  } else {
+    server_vc->do_io_shutdown(howto);
+  }
+}
+
+void
+Http1ServerSession::set_active_timeout(ink_hrtime timeout_in)
+{
+  if (h2_stream) {
+    h2_stream->set_active_timeout(timeout_in);
+  } else {
+    server_vc->set_active_timeout(timeout_in);
+  }
+}
+
+void
+Http1ServerSession::set_inactivity_timeout(ink_hrtime timeout_in)
+{
+  if (h2_stream) {
+    h2_stream->set_inactivity_timeout(timeout_in);
+  } else {
+    server_vc->set_inactivity_timeout(timeout_in);
+  }
 }
 
 void
@@ -130,6 +197,18 @@ Http1ServerSession::do_io_close(int alerrno)
   if (debug_p)
     w.print("[{}] session close: nevtc {:x}", con_id, server_vc);
 
+  if (h2_stream) {
+    // The connection belongs to the HTTP/2 session, only the stream is closed.
+    if (debug_p) {
+      Debug("http_ss", "%.*s stream %u", static_cast<int>(w.size()), w.data(), h2_stream->get_id());
+    }
+    h2_stream->do_io_close(alerrno);
+    h2_stream = nullptr;
+    server_vc = nullptr;
+    destroy();
+    return;
+  }
+
   HTTP_SUM_GLOBAL_DYN_STAT(http_current_server_connections_stat, -1); // Make sure to work on the global stat
   HTTP_SUM_DYN_STAT(http_transactions_per_server_con, transact_count);
 
@@ -164,7 +243,11 @@ Http1ServerSession::do_io_close(int alerrno)
 void
 Http1ServerSession::reenable(VIO *vio)
 {
-  server_vc->reenable(vio);
+  if (h2_stream) {
+    h2_stream->reenable(vio);
+  } else {
+    server_vc->reenable(vio);
+  }
 }
 
 // void Http1ServerSession::release()
@@ -178,6 +261,12 @@ Http1ServerSession::release()
   // Set our state to KA for stat issues
   state = HSS_KA_SHARED;
 
+  // A stream is done with its transaction, the HTTP/2 session keeps the connection.
+  if (h2_stream) {
+    this->do_io_close();
+    return;
+  }
+
   server_vc->control_flags.set_flags(0);
 
   // Private sessions are never released back to the shared pool
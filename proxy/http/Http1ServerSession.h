@@ -46,11 +46,13 @@
 #include "P_Net.h"
 
 #include "HttpConnectionCount.h"
+#include "HttpPreWarm.h"
 #include "HttpProxyAPIEnums.h"
 
 class HttpSM;
 class MIOBuffer;
 class IOBufferReader;
+class Http2ServerStream;
 
 enum HSS_State {
   HSS_INIT,
@@ -79,6 +81,31 @@ public:
   void destroy();
   void new_connection(NetVConnection *new_vc);
 
+  /** Start a session for @a stream on the HTTP/2 connection @a netvc.
+   *
+   * The session reads and writes through the stream. The connection itself, and its stats and
+   * connection tracking, belong to the HTTP/2 session.
+   */
+  void new_stream(Http2ServerStream *stream, NetVConnection *netvc);
+
+  /** Switch to @a stream on the connection this session opened, now taken over by an HTTP/2 session.
+   *
+   * The connection tracking group and the parent proxy count are dropped here, the HTTP/2 session
+   * must have taken them.
+   */
+  void attach_stream(Http2ServerStream *stream);
+
+  /// Is this a stream on an HTTP/2 connection?
+  bool
+  is_multiplexed() const
+  {
+    return h2_stream != nullptr;
+  }
+
+  /// Set the timeouts for the transaction, on the stream if there is one or else on the connection.
+  void set_active_timeout(ink_hrtime timeout_in);
+  void set_inactivity_timeout(ink_hrtime timeout_in);
+
   /** Enable tracking the number of outbound session.
    *
    * @param group The connection tracking group.
@@ -159,6 +186,9 @@ public:
   // Copy of the owning SM's server session sharing settings
   TSServerSessionSharingMatchType sharing_match = TS_SERVER_SESSION_SHARING_MATCH_BOTH;
   TSServerSessionSharingPoolType sharing_pool   = TS_SERVER_SESSION_SHARING_POOL_GLOBAL;
+
+  // Set while a pre-warmed session waits in a pool for its first transaction
+  PreWarmManager::Dest *prewarm_dest = nullptr;
   //  int share_session;
 
   /// Hash map descriptor class for IP map.
@@ -204,20 +234,32 @@ public:
   virtual int
   populate_protocol(std::string_view *result, int size) const
   {
-    auto vc = this->get_netvc();
-    return vc ? vc->populate_protocol(result, size) : 0;
+    int retval = 0;
+    auto vc    = this->get_netvc();
+    if (this->is_multiplexed() && size > retval) {
+      result[retval++] = IP_PROTO_TAG_HTTP_2_0;
+    }
+    if (vc && size > retval) {
+      retval += vc->populate_protocol(result + retval, size - retval);
+    }
+    return retval;
   }
 
   virtual const char *
   protocol_contains(std::string_view tag_prefix) const
   {
     auto vc = this->get_netvc();
+    if (this->is_multiplexed() && tag_prefix.size() <= IP_PROTO_TAG_HTTP_2_0.size() &&
+        strncmp(IP_PROTO_TAG_HTTP_2_0.data(), tag_prefix.data(), tag_prefix.size()) == 0) {
+      return IP_PROTO_TAG_HTTP_2_0.data();
+    }
     return vc ? vc->protocol_contains(tag_prefix) : nullptr;
   }
 
 private:
-  NetVConnection *server_vc = nullptr;
-  int magic                 = HTTP_SS_MAGIC_DEAD;
+  NetVConnection *server_vc    = nullptr;
+  Http2ServerStream *h2_stream = nullptr;
+  int magic                    = HTTP_SS_MAGIC_DEAD;
 
   IOBufferReader *buf_reader = nullptr;
 };
@@ -115,7 +115,8 @@ static const ConfigEnumPair<TSServerSessionSharingMatchType> SessionSharingMatch
 
 static const ConfigEnumPair<TSServerSessionSharingPoolType> SessionSharingPoolStrings[] = {
   {TS_SERVER_SESSION_SHARING_POOL_GLOBAL, "global"},
-  {TS_SERVER_SESSION_SHARING_POOL_THREAD, "thread"}};
+  {TS_SERVER_SESSION_SHARING_POOL_THREAD, "thread"},
+  {TS_SERVER_SESSION_SHARING_POOL_HYBRID, "hybrid"}};
 
 int HttpConfig::m_id = 0;
 HttpConfigParams HttpConfig::m_master;
@@ -249,6 +250,32 @@ register_stat_callbacks()
 
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.total_server_connections", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_total_server_connections_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.server_session_reuse", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_server_session_reuse_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.server_session_migrations", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_server_session_migrations_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.prewarm.connections_opened", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_prewarm_connections_opened_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.prewarm.connect_failures", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_prewarm_connect_failures_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.prewarm.hits", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_prewarm_hits_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.prewarm.closed_idle", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_prewarm_closed_idle_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.races", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_happy_eyeballs_races_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.attempts", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_happy_eyeballs_attempts_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.cancelled_attempts", RECD_COUNTER,
+                     RECP_PERSISTENT, (int)http_happy_eyeballs_cancelled_attempts_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.ipv4_wins", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_happy_eyeballs_ipv4_wins_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.ipv6_wins", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_happy_eyeballs_ipv6_wins_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.ipv4_connect_time", RECD_FLOAT,
+                     RECP_NON_PERSISTENT, (int)http_happy_eyeballs_ipv4_connect_time_stat, RecRawStatSyncHrTimeAvg);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.happy_eyeballs.ipv6_connect_time", RECD_FLOAT,
+                     RECP_NON_PERSISTENT, (int)http_happy_eyeballs_ipv6_connect_time_stat, RecRawStatSyncHrTimeAvg);
 
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.total_parent_proxy_connections", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_total_parent_proxy_connections_stat, RecRawStatSyncCount);
@@ -860,6 +887,8 @@ register_stat_callbacks()
                      (int)http_origin_connections_throttled_stat, RecRawStatSyncCount);
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.post_body_too_large", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_post_body_too_large, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.early_data_rejected", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_early_data_rejected_stat, RecRawStatSyncCount);
   // milestones
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.milestone.ua_begin", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_ua_begin_time_stat, RecRawStatSyncSum);
@@ -1208,6 +1237,15 @@ HttpConfig::startup()
 
   HttpEstablishStaticConfigLongLong(c.max_post_size, "proxy.config.http.max_post_size");
 
+  HttpEstablishStaticConfigLongLong(c.oride.server_prewarm_min, "proxy.config.http.per_server.connection.prewarm");
+  HttpEstablishStaticConfigLongLong(c.oride.http2_max_concurrent_streams_out, "proxy.config.http2.max_concurrent_streams_out");
+  HttpEstablishStaticConfigLongLong(c.prewarm_expire, "proxy.config.http.per_server.prewarm.expire");
+  HttpEstablishStaticConfigByte(c.happy_eyeballs_enabled, "proxy.config.http.happy_eyeballs.enabled");
+  HttpEstablishStaticConfigLongLong(c.happy_eyeballs_attempt_delay, "proxy.config.http.happy_eyeballs.attempt_delay");
+
+  HttpEstablishStaticConfigByte(c.oride.allow_early_data, "proxy.config.http.allow_early_data");
+  HttpEstablishStaticConfigStringAlloc(c.early_data_methods, "proxy.config.http.early_data_methods");
+
   //##############################################################################
   //#
   //# Redirection
@@ -1444,6 +1482,14 @@ HttpConfig::reconfigure()
 
   params->oride.cache_when_to_revalidate = m_master.oride.cache_when_to_revalidate;
   params->max_post_size                  = m_master.max_post_size;
+  params->oride.server_prewarm_min       = m_master.oride.server_prewarm_min;
+  params->prewarm_expire                 = m_master.prewarm_expire;
+  params->happy_eyeballs_enabled         = m_master.happy_eyeballs_enabled;
+  params->happy_eyeballs_attempt_delay   = m_master.happy_eyeballs_attempt_delay;
+  params->oride.allow_early_data         = m_master.oride.allow_early_data;
+  params->early_data_methods             = ats_strdup(m_master.early_data_methods);
+
+  params->oride.http2_max_concurrent_streams_out = m_master.oride.http2_max_concurrent_streams_out;
 
   params->oride.cache_required_headers = m_master.oride.cache_required_headers;
   params->oride.cache_range_lookup     = INT_TO_BOOL(m_master.oride.cache_range_lookup);
@@ -81,6 +81,19 @@ enum {
   http_total_client_connections_ipv4_stat,
   http_total_client_connections_ipv6_stat,
   http_total_server_connections_stat,
+  http_server_session_reuse_stat,
+  http_server_session_migrations_stat,
+  http_prewarm_connections_opened_stat,
+  http_prewarm_connect_failures_stat,
+  http_prewarm_hits_stat,
+  http_prewarm_closed_idle_stat,
+  http_happy_eyeballs_races_stat,
+  http_happy_eyeballs_attempts_stat,
+  http_happy_eyeballs_cancelled_attempts_stat,
+  http_happy_eyeballs_ipv4_wins_stat,
+  http_happy_eyeballs_ipv6_wins_stat,
+  http_happy_eyeballs_ipv4_connect_time_stat,
+  http_happy_eyeballs_ipv6_connect_time_stat,
   http_total_parent_proxy_connections_stat,
   http_total_parent_retries_stat,
   http_total_parent_switches_stat,
@@ -243,6 +256,7 @@ enum {
 
   disallowed_post_100_continue,
   http_post_body_too_large,
+  http_early_data_rejected_stat,
 
   http_total_x_redirect_stat,
 
@@ -491,6 +505,7 @@ struct OverridableHttpConfigParams {
       post_check_content_length_enabled(1),
       request_buffer_enabled(0),
       allow_half_open(1),
+      allow_early_data(1),
       ssl_client_verify_server(0),
       ssl_client_verify_server_policy(nullptr),
       ssl_client_verify_server_properties(nullptr),
@@ -521,6 +536,8 @@ struct OverridableHttpConfigParams {
       transaction_active_timeout_in(900),
       websocket_active_timeout(3600),
       websocket_inactive_timeout(600),
+      server_prewarm_min(0),
+      http2_max_concurrent_streams_out(100),
       connect_attempts_max_retries(0),
       connect_attempts_max_retries_dead_server(3),
       connect_attempts_rr_retries(3),
@@ -677,6 +694,11 @@ struct OverridableHttpConfigParams {
   /////////////////////////////////////////////////
   MgmtByte allow_half_open;
 
+  //////////////////////////////////////////
+  // Serve requests sent as TLS early data //
+  //////////////////////////////////////////
+  MgmtByte allow_early_data;
+
   /////////////////////////////
   // server verification mode//
   /////////////////////////////
@@ -740,6 +762,16 @@ struct OverridableHttpConfigParams {
   MgmtInt websocket_active_timeout;
   MgmtInt websocket_inactive_timeout;
 
+  ///////////////////////////////////////////////
+  // pre-warmed idle connections to the server //
+  ///////////////////////////////////////////////
+  MgmtInt server_prewarm_min;
+
+  ///////////////////////////////////////////
+  // streams on an HTTP/2 server connection //
+  ///////////////////////////////////////////
+  MgmtInt http2_max_concurrent_streams_out;
+
   ////////////////////////////////////
   // origin server connect attempts //
   ////////////////////////////////////
@@ -869,6 +901,13 @@ public:
   MgmtInt post_copy_size = 2048;
   MgmtInt max_post_size  = 0;
 
+  MgmtInt prewarm_expire = 600;
+
+  MgmtByte happy_eyeballs_enabled      = 0;
+  MgmtInt happy_eyeballs_attempt_delay = 250;
+
+  char *early_data_methods = nullptr;
+
   char *redirect_actions_string                        = nullptr;
   IpMap *redirect_actions_map                          = nullptr;
   RedirectEnabled::Action redirect_actions_self_action = RedirectEnabled::Action::INVALID;
@@ -981,6 +1020,7 @@ inline HttpConfigParams::~HttpConfigParams()
   ats_free(reverse_proxy_no_host_redirect);
   ats_free(redirect_actions_string);
   ats_free(oride.ssl_client_sni_policy);
+  ats_free(early_data_methods);
 
   delete connect_ports;
   delete redirect_actions_map;
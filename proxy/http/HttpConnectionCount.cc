@@ -175,13 +175,21 @@ OutboundConnTrack::obtain(TxnConfig const &txn_cnf, std::string_view fqdn, IpEnd
   CryptoHash hash;
   CryptoContext().hash_immediate(hash, fqdn.data(), fqdn.size());
   Group::Key key{addr, hash, txn_cnf.match};
-  std::lock_guard<std::mutex> lock(_imp._mutex); // Table lock
-  auto loc = _imp._table.find(key);
-  if (loc != _imp._table.end()) {
-    zret._g = loc;
-  } else {
-    zret._g = new Group(key, fqdn);
-    _imp._table.insert(zret._g);
+  auto &bucket = _imp.bucket(key);
+
+  zret._g = Imp::find(bucket.load(std::memory_order_acquire), key);
+  if (zret._g == nullptr) {
+    std::lock_guard<std::mutex> lock(_imp._mutex); // Insert lock
+    // Look again, another thread may have added the group since the first look.
+    Group *head = bucket.load(std::memory_order_relaxed);
+    zret._g     = Imp::find(head, key);
+    if (zret._g == nullptr) {
+      zret._g        = new Group(key, fqdn);
+      zret._g->_next = head;
+      // Publish the fully constructed group to lookups.
+      bucket.store(zret._g, std::memory_order_release);
+      ++_imp._count;
+    }
   }
   return zret;
 }
@@ -242,14 +250,23 @@ OutboundConnTrack::Group::get_last_alert_epoch_time() const
   return Clock::to_time_t(TimePoint{TimePoint::duration{Ticker{_last_alert}}});
 }
 
+double
+OutboundConnTrack::Group::reuse_ratio() const
+{
+  int reused = _reused;
+  int total  = reused + _opened;
+  return total ? static_cast<double>(reused) / total : 0.0;
+}
+
 void
 OutboundConnTrack::get(std::vector<Group const *> &groups)
 {
-  std::lock_guard<std::mutex> lock(_imp._mutex); // TABLE LOCK
   groups.resize(0);
-  groups.reserve(_imp._table.count());
-  for (Group const &g : _imp._table) {
-    groups.push_back(&g);
+  groups.reserve(_imp._count);
+  for (auto const &bucket : _imp._buckets) {
+    for (Group const *g = bucket.load(std::memory_order_acquire); g != nullptr; g = g->_next) {
+      groups.push_back(g);
+    }
   }
 }
 
@@ -261,13 +278,15 @@ OutboundConnTrack::to_json_string()
   static const ts::BWFormat header_fmt{R"({{"count": {}, "list": [
 )"};
   static const ts::BWFormat item_fmt{
-    R"(  {{"type": "{}", "ip": "{}", "fqdn": "{}", "current": {}, "max": {}, "blocked": {}, "queued": {}, "alert": {}}},
+    R"(  {{"type": "{}", "ip": "{}", "fqdn": "{}", "current": {}, "max": {}, "blocked": {}, "queued": {}, "alert": {}, )"
+    R"("opened": {}, "reused": {}, "migrated": {}, "reuse_ratio": {}}},
 )"};
   static const std::string_view trailer{" \n]}"};
 
   static const auto printer = [](ts::BufferWriter &w, Group const *g) -> ts::BufferWriter & {
     w.print(item_fmt, g->_match_type, g->_addr, g->_fqdn, g->_count.load(), g->_count_max.load(), g->_blocked.load(),
-            g->_rescheduled.load(), g->get_last_alert_epoch_time());
+            g->_rescheduled.load(), g->get_last_alert_epoch_time(), g->_opened.load(), g->_reused.load(), g->_migrated.load(),
+            g->reuse_ratio());
     return w;
   };
 
@@ -25,6 +25,7 @@
 
 #include <string_view>
 #include <chrono>
+#include <array>
 #include <atomic>
 #include <sstream>
 #include <tuple>
@@ -33,7 +34,6 @@
 #include "tscore/ink_config.h"
 #include "tscore/ink_mutex.h"
 #include "tscore/ink_inet.h"
-#include "tscore/IntrusiveHashMap.h"
 #include "tscore/Diags.h"
 #include "tscore/CryptoHash.h"
 #include "tscore/BufferWriterForward.h"
@@ -122,10 +122,12 @@ public:
     std::atomic<int> _rescheduled{0};   ///< # of connection reschedules.
     std::atomic<int> _in_queue{0};      ///< # of connections queued, waiting for a connection.
     std::atomic<Ticker> _last_alert{0}; ///< Absolute time of the last alert.
+    std::atomic<int> _opened{0};        ///< # of connections opened.
+    std::atomic<int> _reused{0};        ///< # of times a pooled connection was reused.
+    std::atomic<int> _migrated{0};      ///< # of pooled connections moved from another thread to be reused.
 
-    // Links for intrusive container.
+    /// Next group in the same table bucket. This does not change once the group is in the table.
     Group *_next{nullptr};
-    Group *_prev{nullptr};
 
     /** Constructor.
      * Construct from @c Key because the use cases do a table lookup first so the @c Key is already constructed.
@@ -137,6 +139,8 @@ public:
     static bool equal(Key const &lhs, Key const &rhs);
     /// Hashing function.
     static uint64_t hash(Key const &);
+    /// Fraction of connection requests satisfied by reusing a pooled connection.
+    double reuse_ratio() const;
     /// Check and clear alert enable.
     /// This is a modifying call - internal state will be updated to prevent too frequent alerts.
     /// @param lat The last alert time, in epoch seconds, if the method returns @c true.
@@ -253,25 +257,27 @@ public:
 protected:
   static GlobalConfig *_global_config; ///< Global configuration data.
 
-  /// Types and methods for the hash table.
-  struct Linkage {
-    using key_type   = Group::Key const &;
-    using value_type = Group;
+  /** Internal implementation class instance.
 
-    static value_type *&next_ptr(value_type *value);
-    static value_type *&prev_ptr(value_type *value);
-
-    static uint64_t hash_of(key_type key);
-
-    static key_type key_of(value_type *v);
-
-    static bool equal(key_type lhs, key_type rhs);
-  };
-
-  /// Internal implementation class instance.
+      Every transaction to an upstream looks up its group, so finding a group must not take a lock.
+      Groups are never removed, which makes the table insert only: a bucket is a chain of groups
+      that is only ever added to at the head. Lookups walk the chain from an atomic load of the
+      head. The mutex only serializes inserts, so that two transactions can't both add the same
+      group.
+  */
   struct Imp {
-    IntrusiveHashMap<Linkage> _table; ///< Hash table of upstream groups.
-    std::mutex _mutex;                ///< Lock for insert & find.
+    /// Number of buckets. This is fixed so the chains are long only with a great many upstreams.
+    static constexpr size_t N_BUCKETS = 1 << 14;
+
+    /// Bucket chain heads. The instance is static so these start out zero.
+    std::array<std::atomic<Group *>, N_BUCKETS> _buckets;
+    std::atomic<size_t> _count{0}; ///< Number of groups.
+    std::mutex _mutex;             ///< Lock for insert.
+
+    /// Get the bucket for @a key.
+    std::atomic<Group *> &bucket(Group::Key const &key);
+    /// Find the group for @a key in the chain starting at @a head.
+    static Group *find(Group *head, Group::Key const &key);
   };
   static Imp _imp;
 
@@ -394,35 +400,22 @@ OutboundConnTrack::TxnState::rescheduled()
   ++_g->_rescheduled;
 }
 
-/* === Linkage === */
-inline auto
-OutboundConnTrack::Linkage::next_ptr(value_type *value) -> value_type *&
-{
-  return value->_next;
-}
-
-inline auto
-OutboundConnTrack::Linkage::prev_ptr(value_type *value) -> value_type *&
-{
-  return value->_prev;
-}
-
-inline uint64_t
-OutboundConnTrack::Linkage::hash_of(key_type key)
+/* === Imp === */
+inline std::atomic<OutboundConnTrack::Group *> &
+OutboundConnTrack::Imp::bucket(Group::Key const &key)
 {
-  return Group::hash(key);
+  return _buckets[Group::hash(key) % N_BUCKETS];
 }
 
-inline auto
-OutboundConnTrack::Linkage::key_of(value_type *value) -> key_type
-{
-  return value->_key;
-}
-
-inline bool
-OutboundConnTrack::Linkage::equal(key_type lhs, key_type rhs)
+inline OutboundConnTrack::Group *
+OutboundConnTrack::Imp::find(Group *head, Group::Key const &key)
 {
-  return Group::equal(lhs, rhs);
+  for (Group *g = head; g != nullptr; g = g->_next) {
+    if (Group::equal(g->_key, key)) {
+      return g;
+    }
+  }
+  return nullptr;
 }
 /* === */
 
@@ -0,0 +1,372 @@
+/** @file
+
+  Race connections to the addresses of an origin, as in Happy Eyeballs (RFC 8305).
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "HttpHappyEyeballs.h"
+#include "HttpConfig.h"
+#include "P_Net.h"
+
+int
+HappyEyeballs::Attempt::mainEvent(int event, void *data)
+{
+  HappyEyeballs *he = race;
+  ++he->_depth;
+
+  switch (event) {
+  case NET_EVENT_OPEN:
+    action = nullptr;
+    vc     = static_cast<NetVConnection *>(data);
+    he->opened(this);
+    break;
+  case NET_EVENT_OPEN_FAILED:
+    action = nullptr;
+    he->failed(this, reinterpret_cast<intptr_t>(data));
+    break;
+  case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE: {
+    // A connect that fails after it is started also makes the socket writable, check that it is connected.
+    int error      = 0;
+    int error_size = sizeof(error);
+    if (safe_getsockopt(vc->get_socket(), SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &error_size) < 0) {
+      error = errno;
+    }
+    if (error != 0) {
+      he->failed(this, -error);
+    } else {
+      he->won(this);
+    }
+    break;
+  }
+  case VC_EVENT_EOS:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+  case VC_EVENT_ACTIVE_TIMEOUT:
+    he->failed(this, -ECONNABORTED);
+    break;
+  default:
+    ink_assert(!"unexpected event");
+    break;
+  }
+
+  he->leave();
+  return EVENT_DONE;
+}
+
+void
+HappyEyeballs::Attempt::abort()
+{
+  if (action) {
+    action->cancel();
+    action = nullptr;
+  }
+  if (vc) {
+    vc->do_io_close();
+    vc = nullptr;
+  }
+  if (buffer) {
+    free_MIOBuffer(buffer);
+    buffer = nullptr;
+    reader = nullptr;
+  }
+  state = DONE;
+}
+
+void
+HappyEyeballs::Attempt::release()
+{
+  vc->do_io_write(nullptr, 0, nullptr);
+  vc = nullptr;
+  free_MIOBuffer(buffer);
+  buffer = nullptr;
+  reader = nullptr;
+  state  = DONE;
+}
+
+HappyEyeballs::HappyEyeballs(Continuation *cont, IpEndpoint *addr, const char *hostname, int down_server_timeout, bool tls,
+                             NetVCOptions const &opt, ink_hrtime connect_timeout, ink_hrtime attempt_delay)
+  : Continuation(cont->mutex),
+    _result_addr(addr),
+    _hostname(ats_strdup(hostname)),
+    _down_server_timeout(down_server_timeout),
+    _tls(tls),
+    _connect_timeout(connect_timeout),
+    _attempt_delay(attempt_delay)
+{
+  SET_HANDLER(&HappyEyeballs::mainEvent);
+  _action = cont;
+  _opt    = opt;
+  ats_ip_copy(&_addrs[0][0], addr);
+  _n_addrs[0] = 1;
+}
+
+Action *
+HappyEyeballs::connect(Continuation *cont, IpEndpoint *addr, HostDBInfo *hostdb_entry, const char *hostname,
+                       HostResStyle host_res_style, int down_server_timeout, bool tls, NetVCOptions const &opt,
+                       ink_hrtime connect_timeout, ink_hrtime attempt_delay)
+{
+  HappyEyeballs *he = new HappyEyeballs(cont, addr, hostname, down_server_timeout, tls, opt, connect_timeout, attempt_delay);
+  HTTP_INCREMENT_DYN_STAT(http_happy_eyeballs_races_stat);
+  ++he->_depth;
+
+  he->add_addrs(0, hostdb_entry);
+  // A zero period would schedule a one shot event, which is freed after it runs while _timer still points at it.
+  he->_timer = this_ethread()->schedule_every(he, std::max(attempt_delay, MIN_ATTEMPT_DELAY));
+  // Look up the other family while the first attempts are made, HostDB has the first family already.
+  if (hostname && HOST_RES_IPV4_ONLY != host_res_style && HOST_RES_IPV6_ONLY != host_res_style) {
+    HostDBProcessor::Options hopt;
+    hopt.port           = addr->host_order_port();
+    hopt.host_res_style = AF_INET6 == addr->family() ? HOST_RES_IPV4_ONLY : HOST_RES_IPV6_ONLY;
+    Action *lookup      = hostDBProcessor.getbyname_re(he, hostname, 0, hopt);
+    if (lookup != ACTION_RESULT_DONE) {
+      he->_lookup = lookup;
+    }
+  }
+  he->start_or_finish();
+
+  --he->_depth;
+  if (he->_done) {
+    delete he;
+    return ACTION_RESULT_DONE;
+  }
+  return &he->_action;
+}
+
+int
+HappyEyeballs::mainEvent(int event, void *data)
+{
+  ++_depth;
+
+  if (!this->is_over()) {
+    switch (event) {
+    case EVENT_INTERVAL:
+      // Don't wait any longer for the attempts in progress.
+      this->start_next();
+      this->start_or_finish();
+      break;
+    case EVENT_HOST_DB_LOOKUP:
+      _lookup = nullptr;
+      this->add_addrs(1, static_cast<HostDBInfo *>(data));
+      this->start_or_finish();
+      break;
+    default:
+      ink_assert(!"unexpected event");
+      break;
+    }
+  }
+
+  this->leave();
+  return EVENT_DONE;
+}
+
+void
+HappyEyeballs::add_addrs(int idx, HostDBInfo *r)
+{
+  if (r == nullptr || r->is_failed()) {
+    return;
+  }
+
+  IpEndpoint const &first = _addrs[0][0];
+  int family              = (0 == idx) == (AF_INET6 == first.family()) ? AF_INET6 : AF_INET;
+  ink_time_t now          = ink_time();
+
+  auto add = [&](HostDBInfo &info) {
+    if (_n_addrs[idx] < MAX_ADDRS && info.ip()->sa_family == family && !ats_ip_addr_eq(info.ip(), &first.sa) &&
+        info.is_alive(now, _down_server_timeout)) {
+      IpEndpoint &addr = _addrs[idx][_n_addrs[idx]++];
+      ats_ip_copy(&addr, info.ip());
+      addr.port() = first.port();
+    }
+  };
+
+  if (r->round_robin) {
+    HostDBRoundRobin *rr = r->rr();
+    for (int i = 0; rr && i < rr->rrcount; ++i) {
+      add(rr->info(i));
+    }
+  } else {
+    add(*r);
+  }
+  auto fam_name = ats_ip_family_name(family);
+  Debug(DEBUG_TAG, "%d %.*s addresses for %s", _n_addrs[idx], static_cast<int>(fam_name.size()), fam_name.data(),
+        _hostname.get());
+}
+
+int
+HappyEyeballs::in_progress() const
+{
+  int n = 0;
+  for (int i = 0; i < _n_attempts; ++i) {
+    if (_attempts[i].state != Attempt::DONE) {
+      ++n;
+    }
+  }
+  return n;
+}
+
+bool
+HappyEyeballs::start_next()
+{
+  // Alternate families, for as long as the other family has addresses left.
+  int idx = 1 - _last_family;
+  if (_next_addr[idx] >= _n_addrs[idx]) {
+    idx = _last_family;
+  }
+  if (_done || _next_addr[idx] >= _n_addrs[idx] || _n_attempts >= static_cast<int>(countof(_attempts))) {
+    return false;
+  }
+
+  Attempt *a = &_attempts[_n_attempts++];
+  ats_ip_copy(&a->addr, &_addrs[idx][_next_addr[idx]++]);
+  _last_family   = idx;
+  a->race        = this;
+  a->mutex       = mutex;
+  a->state       = Attempt::CONNECTING;
+  a->start       = Thread::get_hrtime();
+  _opt.ip_family = a->addr.family();
+  HTTP_INCREMENT_DYN_STAT(http_happy_eyeballs_attempts_stat);
+
+  ip_port_text_buffer addrbuf;
+  Debug(DEBUG_TAG, "attempt %d for %s to %s", _n_attempts, _hostname.get(), ats_ip_nptop(&a->addr.sa, addrbuf, sizeof(addrbuf)));
+
+  // The result can be delivered before connect_re returns, and the attempt be over.
+  Action *action = _tls ? sslNetProcessor.connect_re(a, &a->addr.sa, &_opt) : netProcessor.connect_re(a, &a->addr.sa, &_opt);
+  if (action != ACTION_RESULT_DONE && a->state == Attempt::CONNECTING && a->vc == nullptr) {
+    a->action = action;
+  }
+  return true;
+}
+
+void
+HappyEyeballs::start_or_finish()
+{
+  while (!_done && this->in_progress() == 0 && this->start_next()) {
+    ;
+  }
+  // Wait for the other family if its addresses might still come.
+  if (!_done && this->in_progress() == 0 && _lookup == nullptr) {
+    this->finish(NET_EVENT_OPEN_FAILED, reinterpret_cast<void *>(_first_error));
+  }
+}
+
+void
+HappyEyeballs::opened(Attempt *a)
+{
+  if (this->is_over()) {
+    a->abort();
+    return;
+  }
+  a->state  = Attempt::HANDSHAKE;
+  a->buffer = new_empty_MIOBuffer(BUFFER_SIZE_INDEX_128);
+  a->reader = a->buffer->alloc_reader();
+  a->vc->set_inactivity_timeout(_connect_timeout);
+  // Nothing is written, the write is ready once the handshake is done.
+  a->vc->do_io_write(a, 1, a->reader);
+}
+
+void
+HappyEyeballs::failed(Attempt *a, intptr_t error)
+{
+  if (this->is_over()) {
+    return;
+  }
+  ip_port_text_buffer addrbuf;
+  Debug(DEBUG_TAG, "connection for %s to %s failed: %" PRIdPTR, _hostname.get(),
+        ats_ip_nptop(&a->addr.sa, addrbuf, sizeof(addrbuf)), error);
+  a->abort();
+  if (a == &_attempts[0]) {
+    _first_error = error;
+  }
+  // The next attempt starts right away rather than after the delay.
+  this->start_next();
+  this->start_or_finish();
+}
+
+void
+HappyEyeballs::won(Attempt *a)
+{
+  if (this->is_over()) {
+    return;
+  }
+  bool v6 = AF_INET6 == a->addr.family();
+  HTTP_INCREMENT_DYN_STAT(v6 ? http_happy_eyeballs_ipv6_wins_stat : http_happy_eyeballs_ipv4_wins_stat);
+  HTTP_SUM_DYN_STAT(v6 ? http_happy_eyeballs_ipv6_connect_time_stat : http_happy_eyeballs_ipv4_connect_time_stat,
+                    Thread::get_hrtime() - a->start);
+
+  ip_port_text_buffer addrbuf;
+  Debug(DEBUG_TAG, "connection for %s to %s won after %d attempts", _hostname.get(),
+        ats_ip_nptop(&a->addr.sa, addrbuf, sizeof(addrbuf)), _n_attempts);
+
+  NetVConnection *vc = a->vc;
+  a->release();
+  ats_ip_copy(_result_addr, &a->addr);
+  this->finish(NET_EVENT_OPEN, vc);
+}
+
+bool
+HappyEyeballs::is_over()
+{
+  if (!_done && _action.cancelled) {
+    Debug(DEBUG_TAG, "connect for %s cancelled", _hostname.get());
+    _done = true;
+    this->stop();
+  }
+  return _done;
+}
+
+void
+HappyEyeballs::stop()
+{
+  for (int i = 0; i < _n_attempts; ++i) {
+    if (_attempts[i].state != Attempt::DONE) {
+      HTTP_INCREMENT_DYN_STAT(http_happy_eyeballs_cancelled_attempts_stat);
+      _attempts[i].abort();
+    }
+  }
+  if (_lookup) {
+    _lookup->cancel();
+    _lookup = nullptr;
+  }
+  if (_timer) {
+    _timer->cancel();
+    _timer = nullptr;
+  }
+}
+
+void
+HappyEyeballs::finish(int event, void *data)
+{
+  _done = true;
+  this->stop();
+  _action.continuation->handleEvent(event, data);
+}
+
+bool
+HappyEyeballs::leave()
+{
+  if (--_depth == 0 && _done) {
+    delete this;
+    return true;
+  }
+  return false;
+}
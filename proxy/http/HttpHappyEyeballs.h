@@ -0,0 +1,144 @@
+/** @file
+
+  Race connections to the addresses of an origin, as in Happy Eyeballs (RFC 8305).
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_inet.h"
+#include "tscore/ink_resolver.h"
+#include "P_EventSystem.h"
+#include "I_NetVConnection.h"
+#include "I_HostDB.h"
+
+/** Connect to an origin over whichever of its addresses answers first.
+
+    The first attempt goes to the address already chosen for the transaction. The other addresses
+    of its HostDB record, and the addresses of the other family looked up alongside, are tried in
+    turn, alternating families, one every attempt delay or as soon as an attempt fails. The first
+    connection to finish its TCP, and TLS if any, handshake is delivered to the caller as
+    @c NET_EVENT_OPEN with the address it went to, and the others are closed. If every attempt fails
+    the caller gets @c NET_EVENT_OPEN_FAILED with the error of the first attempt, as from a single
+    connect.
+
+    The caller's continuation and mutex are used for all the attempts, and the action returned can
+    be cancelled as for @c NetProcessor::connect_re.
+
+    The race as a whole counts as the one connection the caller reserved with @c OutboundConnTrack,
+    the attempts are not counted separately. Up to 2 * @c MAX_ADDRS sockets can be open at once.
+*/
+class HappyEyeballs : public Continuation
+{
+public:
+  /// Most addresses tried from each family.
+  static constexpr int MAX_ADDRS = 8;
+  /// Shortest time between attempts (RFC 8305 section 5).
+  static constexpr ink_hrtime MIN_ATTEMPT_DELAY = HRTIME_MSECONDS(10);
+
+  /** Start connecting for @a cont.
+
+      @a addr is the first address to try and is updated to the address of the connection
+      delivered. The remaining addresses come from @a hostdb_entry and, unless @a host_res_style
+      limits the origin to one family, a HostDB lookup of @a hostname for the other family.
+
+      @return The action for the connect, or @c ACTION_RESULT_DONE if @a cont was already called.
+  */
+  static Action *connect(Continuation *cont, IpEndpoint *addr, HostDBInfo *hostdb_entry, const char *hostname,
+                         HostResStyle host_res_style, int down_server_timeout, bool tls, NetVCOptions const &opt,
+                         ink_hrtime connect_timeout, ink_hrtime attempt_delay);
+
+  /// Tag used for debugging output.
+  static constexpr char const *const DEBUG_TAG{"http_happy_eyeballs"};
+
+private:
+  /// A connection attempt to one address.
+  struct Attempt : public Continuation {
+    enum State { CONNECTING, HANDSHAKE, DONE };
+
+    HappyEyeballs *race = nullptr;
+    IpEndpoint addr;
+    State state            = DONE;
+    Action *action         = nullptr; ///< Pending connect.
+    NetVConnection *vc     = nullptr;
+    MIOBuffer *buffer      = nullptr; ///< Empty, written to learn when the handshake is done.
+    IOBufferReader *reader = nullptr;
+    ink_hrtime start       = 0;
+
+    Attempt() : Continuation(nullptr)
+    {
+      SET_HANDLER(&Attempt::mainEvent);
+    }
+    int mainEvent(int event, void *data);
+    /// Stop the attempt, closing the connection if any.
+    void abort();
+    /// Stop watching the handshake, keeping the connection.
+    void release();
+  };
+
+  HappyEyeballs(Continuation *cont, IpEndpoint *addr, const char *hostname, int down_server_timeout, bool tls,
+                NetVCOptions const &opt, ink_hrtime connect_timeout, ink_hrtime attempt_delay);
+
+  int mainEvent(int event, void *data);
+
+  /// Add the live addresses of @a r, other than the first address, to the candidates of family index @a idx.
+  void add_addrs(int idx, HostDBInfo *r);
+  /// Number of attempts started and not yet over.
+  int in_progress() const;
+  /// Check for the race being over, stopping it if the caller cancelled it.
+  bool is_over();
+  /// Stop every attempt and the lookup.
+  void stop();
+  /// Start an attempt to the next candidate address, return @c false if there is none.
+  bool start_next();
+  /// Start attempts until one is in progress or there are no candidates left, then see if the race is over.
+  void start_or_finish();
+
+  void opened(Attempt *a);
+  void failed(Attempt *a, intptr_t error);
+  void won(Attempt *a);
+  /// Deliver @a event with @a data to the caller and end the race.
+  void finish(int event, void *data);
+  /// Delete this if done and no longer on the stack.
+  bool leave();
+
+  Action _action;                  ///< Caller.
+  IpEndpoint *_result_addr;        ///< Where to put the address of the connection delivered.
+  ats_scoped_str _hostname;        ///< Name to look up the other family for.
+  int _down_server_timeout;        ///< Seconds an address is skipped after it fails.
+  bool _tls;                       ///< Connect with TLS.
+  NetVCOptions _opt;               ///< Connection options, the family is set per attempt.
+  ink_hrtime _connect_timeout;     ///< Time allowed for each attempt.
+  ink_hrtime _attempt_delay;       ///< Time between starting attempts.
+  Action *_lookup       = nullptr; ///< Pending HostDB lookup of the other family.
+  Event *_timer         = nullptr; ///< Starts the next attempt.
+  intptr_t _first_error = 0;       ///< Error of the first failed attempt.
+  int _depth            = 0;       ///< Number of calls into this on the stack.
+  bool _done            = false;   ///< Result delivered or race cancelled.
+
+  /// Candidate addresses, the family of the first address, then the other family.
+  IpEndpoint _addrs[2][MAX_ADDRS];
+  int _n_addrs[2]   = {0, 0};
+  int _next_addr[2] = {0, 0};
+  int _last_family  = 1; ///< Family index of the last attempt, so the first is the first family.
+
+  Attempt _attempts[2 * MAX_ADDRS];
+  int _n_attempts = 0;
+};
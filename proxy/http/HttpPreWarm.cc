@@ -0,0 +1,275 @@
+/** @file
+
+  Keep idle connections open to origins ahead of the transactions that need them.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "HttpPreWarm.h"
+#include "Http1ServerSession.h"
+#include "HttpConfig.h"
+#include "P_Net.h"
+#include "P_Freer.h"
+
+PreWarmManager prewarmManager;
+
+namespace
+{
+/// How often destinations are topped up.
+constexpr ink_hrtime PREWARM_INTERVAL = HRTIME_SECONDS(1);
+/// How long a destination removed from the table is kept for lookups that may still be using it.
+constexpr ink_hrtime PREWARM_FREE_DELAY = HRTIME_MINUTES(1);
+
+/// Open one connection for a destination and release it to the session pools.
+class PreWarmConnector : public Continuation
+{
+public:
+  explicit PreWarmConnector(PreWarmManager::Dest *dest) : Continuation(new_ProxyMutex()), _dest(dest)
+  {
+    SET_HANDLER(&PreWarmConnector::mainEvent);
+  }
+
+  int
+  mainEvent(int event, void *data)
+  {
+    switch (event) {
+    case EVENT_IMMEDIATE: {
+      // Running on the thread the connection will belong to, which spreads connections over the threads.
+      // The result is delivered to this continuation, possibly before connect_re returns.
+      NetVCOptions opt;
+      opt = _dest->_opt;
+      if (_dest->_tls) {
+        sslNetProcessor.connect_re(this, &_dest->_addr.sa, &opt);
+      } else {
+        netProcessor.connect_re(this, &_dest->_addr.sa, &opt);
+      }
+      return EVENT_DONE;
+    }
+    case NET_EVENT_OPEN:
+      this->opened(static_cast<NetVConnection *>(data));
+      break;
+    case NET_EVENT_OPEN_FAILED:
+      Debug(PreWarmManager::DEBUG_TAG, "connection to %s failed", _dest->_hostname.get());
+      HTTP_INCREMENT_DYN_STAT(http_prewarm_connect_failures_stat);
+      --_dest->_opening;
+      --_dest->_refs;
+      break;
+    default:
+      ink_assert(!"unexpected event");
+      break;
+    }
+    delete this;
+    return EVENT_DONE;
+  }
+
+private:
+  void
+  opened(NetVConnection *vc)
+  {
+    Http1ServerSession *ss = (TS_SERVER_SESSION_SHARING_POOL_THREAD == _dest->_sharing_pool) ?
+                               THREAD_ALLOC_INIT(http1ServerSessionAllocator, this_ethread()) :
+                               http1ServerSessionAllocator.alloc();
+    ss->sharing_pool  = _dest->_sharing_pool;
+    ss->sharing_match = _dest->_sharing_match;
+    ss->attach_hostname(_dest->_hostname);
+    ss->new_connection(vc);
+    // The session takes over the reference held for the connection.
+    ss->prewarm_dest = _dest;
+    ++_dest->_idle;
+    --_dest->_opening;
+    HTTP_INCREMENT_DYN_STAT(http_prewarm_connections_opened_stat);
+    Debug(PreWarmManager::DEBUG_TAG, "[%" PRId64 "] pre-warmed connection to %s", ss->con_id, _dest->_hostname.get());
+
+    vc->set_inactivity_timeout(_dest->_keep_alive_timeout);
+    vc->cancel_active_timeout();
+    // The pool reads from the session to detect the origin closing it. For TLS that also completes the handshake.
+    ss->release();
+  }
+
+  PreWarmManager::Dest *_dest;
+};
+} // namespace
+
+bool
+PreWarmManager::Dest::is_wanted(ink_hrtime now, ink_hrtime expire) const
+{
+  return _min_idle > 0 && _last_used + expire > now;
+}
+
+std::atomic<PreWarmManager::Dest *> &
+PreWarmManager::bucket(CryptoHash const &key)
+{
+  return _buckets[key.fold() % N_BUCKETS];
+}
+
+PreWarmManager::Dest *
+PreWarmManager::find(Dest *head, CryptoHash const &key)
+{
+  for (Dest *dest = head; dest != nullptr; dest = dest->_next.load(std::memory_order_acquire)) {
+    if (dest->_key == key) {
+      return dest;
+    }
+  }
+  return nullptr;
+}
+
+PreWarmManager::PreWarmManager() : Continuation(nullptr)
+{
+  SET_HANDLER(&PreWarmManager::mainEvent);
+}
+
+void
+PreWarmManager::start()
+{
+  mutex = new_ProxyMutex();
+  eventProcessor.schedule_every(this, PREWARM_INTERVAL, ET_NET);
+}
+
+CryptoHash
+PreWarmManager::make_key(sockaddr const *addr, CryptoHash const &hostname_hash)
+{
+  CryptoHash key;
+  CryptoContext ctx;
+  ctx.update(ats_ip_addr8_cast(addr), ats_ip_addr_size(addr));
+  in_port_t port = ats_ip_port_cast(addr);
+  ctx.update(&port, sizeof(port));
+  ctx.update(&hostname_hash, sizeof(hostname_hash));
+  ctx.finalize(key);
+  return key;
+}
+
+void
+PreWarmManager::touch(sockaddr const *addr, CryptoHash const &hostname_hash, int min_idle)
+{
+  CryptoHash key = make_key(addr, hostname_hash);
+
+  if (Dest *dest = find(bucket(key).load(std::memory_order_acquire), key); dest) {
+    dest->_min_idle  = min_idle;
+    dest->_last_used = Thread::get_hrtime();
+  }
+}
+
+void
+PreWarmManager::add(sockaddr const *addr, const char *hostname, bool tls, NetVCOptions const &opt, int min_idle,
+                    TSServerSessionSharingMatchType match, TSServerSessionSharingPoolType pool, ink_hrtime keep_alive_timeout)
+{
+  CryptoHash hostname_hash;
+  CryptoContext().hash_immediate(hostname_hash, reinterpret_cast<const unsigned char *>(hostname), strlen(hostname));
+  CryptoHash key            = make_key(addr, hostname_hash);
+  std::atomic<Dest *> &head = bucket(key);
+  Dest *dest                = find(head.load(std::memory_order_acquire), key);
+  std::unique_lock<std::mutex> lock;
+
+  if (dest == nullptr) {
+    // Search again under the lock, another transaction may have just added it.
+    lock = std::unique_lock<std::mutex>(_mutex);
+    dest = find(head.load(std::memory_order_relaxed), key);
+  }
+  if (dest) {
+    dest->_min_idle  = min_idle;
+    dest->_last_used = Thread::get_hrtime();
+    return;
+  }
+
+  dest = new Dest;
+  ats_ip_copy(&dest->_addr, addr);
+  dest->_hostname_hash = hostname_hash;
+  dest->_key           = key;
+  dest->_hostname      = ats_strdup(hostname);
+  dest->_tls           = tls;
+  dest->_opt           = opt;
+  // Pre-warmed sessions are only ever HTTP/1.1, and must not depend on the transaction that added them.
+  dest->_opt.alpn_protos                 = {};
+  dest->_client_cert_name                = ats_strdup(opt.ssl_client_cert_name);
+  dest->_client_private_key_name         = ats_strdup(opt.ssl_client_private_key_name);
+  dest->_client_ca_cert_name             = ats_strdup(opt.ssl_client_ca_cert_name);
+  dest->_opt.ssl_client_cert_name        = dest->_client_cert_name;
+  dest->_opt.ssl_client_private_key_name = dest->_client_private_key_name;
+  dest->_opt.ssl_client_ca_cert_name     = dest->_client_ca_cert_name;
+  // Keep idle connections checked by the kernel as well as by the pool.
+  dest->_opt.sockopt_flags |= NetVCOptions::SOCK_OPT_KEEP_ALIVE;
+  dest->_sharing_match      = match;
+  dest->_sharing_pool       = pool;
+  dest->_keep_alive_timeout = keep_alive_timeout;
+  dest->_min_idle           = min_idle;
+  dest->_last_used          = Thread::get_hrtime();
+  dest->_next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  head.store(dest, std::memory_order_release);
+  Debug(DEBUG_TAG, "added destination %s, %d idle connections", hostname, min_idle);
+}
+
+void
+PreWarmManager::note_used(Http1ServerSession *ss)
+{
+  Dest *dest       = ss->prewarm_dest;
+  ss->prewarm_dest = nullptr;
+  --dest->_idle;
+  dest->_last_used = Thread::get_hrtime();
+  --dest->_refs;
+  HTTP_INCREMENT_DYN_STAT(http_prewarm_hits_stat);
+}
+
+void
+PreWarmManager::note_closed(Http1ServerSession *ss)
+{
+  Dest *dest       = ss->prewarm_dest;
+  ss->prewarm_dest = nullptr;
+  --dest->_idle;
+  --dest->_refs;
+  HTTP_INCREMENT_DYN_STAT(http_prewarm_closed_idle_stat);
+}
+
+void
+PreWarmManager::open_connection(Dest *dest)
+{
+  ++dest->_refs;
+  ++dest->_opening;
+  eventProcessor.schedule_imm(new PreWarmConnector(dest), ET_NET);
+}
+
+int
+PreWarmManager::mainEvent(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  HttpConfigParams *params = HttpConfig::acquire();
+  ink_hrtime expire        = HRTIME_SECONDS(params->prewarm_expire);
+  HttpConfig::release(params);
+
+  ink_hrtime now = Thread::get_hrtime();
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  for (auto &head : _buckets) {
+    std::atomic<Dest *> *link = &head;
+    while (Dest *dest = link->load(std::memory_order_relaxed)) {
+      if (dest->is_wanted(now, expire)) {
+        // Connections that are still opening count, otherwise a slow origin gets a new batch every interval.
+        for (int n = dest->_min_idle - dest->_idle - dest->_opening; n > 0; --n) {
+          this->open_connection(dest);
+        }
+      } else if (dest->_refs == 1) {
+        // Only connections are opened here, so with none left nothing else can take a reference.
+        Debug(DEBUG_TAG, "removed destination %s", dest->_hostname.get());
+        link->store(dest->_next.load(std::memory_order_relaxed), std::memory_order_release);
+        new_Deleter(dest, PREWARM_FREE_DELAY);
+        continue;
+      }
+      link = &dest->_next;
+    }
+  }
+  return EVENT_CONT;
+}
@@ -0,0 +1,135 @@
+/** @file
+
+  Keep idle connections open to origins ahead of the transactions that need them.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include "tscore/ink_inet.h"
+#include "tscore/CryptoHash.h"
+#include "P_EventSystem.h"
+#include "I_NetVConnection.h"
+#include "HttpProxyAPIEnums.h"
+
+class Http1ServerSession;
+
+/** Open connections to origins ahead of need.
+
+    A transaction whose @c proxy.config.http.per_server.connection.prewarm is set registers the
+    origin it connects to as a destination. Periodically the number of pre-warmed sessions idle in
+    the session pools for each destination is topped up to that minimum by opening new connections
+    and releasing them directly to the pools, where they wait for a transaction like any other
+    shared session.
+
+    Destinations no transaction has used for @c proxy.config.http.per_server.prewarm.expire seconds
+    are no longer topped up, and are removed once none of their connections are left.
+*/
+class PreWarmManager : public Continuation
+{
+public:
+  /// An origin to keep connections open to.
+  struct Dest {
+    IpEndpoint _addr;          ///< Origin address and port.
+    CryptoHash _hostname_hash; ///< Hash of the origin host name, for session pool matching.
+    CryptoHash _key;           ///< Table key, from @a _addr and @a _hostname_hash.
+    ats_scoped_str _hostname;  ///< Origin host name.
+    bool _tls = false;         ///< Connect with TLS.
+    NetVCOptions _opt;         ///< Options for new connections, copied from the first transaction.
+    // Storage for the client certificate names in @a _opt, which are not owned by it.
+    ats_scoped_str _client_cert_name;
+    ats_scoped_str _client_private_key_name;
+    ats_scoped_str _client_ca_cert_name;
+
+    TSServerSessionSharingMatchType _sharing_match = TS_SERVER_SESSION_SHARING_MATCH_BOTH;
+    TSServerSessionSharingPoolType _sharing_pool   = TS_SERVER_SESSION_SHARING_POOL_THREAD;
+    ink_hrtime _keep_alive_timeout                 = 0; ///< Inactivity timeout for idle sessions.
+
+    std::atomic<int> _min_idle{0};         ///< Target number of idle pre-warmed sessions.
+    std::atomic<int> _idle{0};             ///< Pre-warmed sessions waiting in a pool.
+    std::atomic<int> _opening{0};          ///< Connections being opened.
+    std::atomic<ink_hrtime> _last_used{0}; ///< Last time a transaction went to this destination.
+
+    /** References from the table, connections being opened and pre-warmed sessions.
+
+        Only the manager removes a destination, when the table holds the last reference, so
+        dropping a reference must be the last use of the destination.
+    */
+    std::atomic<int> _refs{1};
+
+    /// Next destination in the same table bucket.
+    std::atomic<Dest *> _next{nullptr};
+
+    /// Still wanted, i.e. used by a transaction within @a expire.
+    bool is_wanted(ink_hrtime now, ink_hrtime expire) const;
+  };
+
+  PreWarmManager();
+
+  /// Start topping up destinations.
+  void start();
+
+  /// Note a transaction going to the origin at @a addr named by @a hostname_hash, if it is a destination.
+  void touch(sockaddr const *addr, CryptoHash const &hostname_hash, int min_idle);
+
+  /** Add the origin at @a addr as a destination, new connections are opened with options @a opt.
+
+      If it is already a destination this is the same as @c touch.
+  */
+  void add(sockaddr const *addr, const char *hostname, bool tls, NetVCOptions const &opt, int min_idle,
+           TSServerSessionSharingMatchType match, TSServerSessionSharingPoolType pool, ink_hrtime keep_alive_timeout);
+
+  /// Note @a ss, a pre-warmed session, was taken from a pool for a transaction.
+  static void note_used(Http1ServerSession *ss);
+  /// Note @a ss, a pre-warmed session, was closed without being used.
+  static void note_closed(Http1ServerSession *ss);
+
+  /// Tag used for debugging output.
+  static constexpr char const *const DEBUG_TAG{"http_prewarm"};
+
+private:
+  int mainEvent(int event, void *data);
+  void open_connection(Dest *dest);
+
+  static CryptoHash make_key(sockaddr const *addr, CryptoHash const &hostname_hash);
+
+  /** Destination table.
+
+      Every transaction with pre-warming enabled looks up its destination, so that must not take a
+      lock. A bucket is a chain of destinations that is added to at the head and read from an atomic
+      load of the head. The mutex serializes changes to the chains, and a destination removed from
+      a chain is deleted only after a delay so that a lookup still walking over it can finish.
+  */
+  static constexpr size_t N_BUCKETS = 1 << 10;
+  /// Bucket chain heads. The instance is static so these start out zero.
+  std::array<std::atomic<Dest *>, N_BUCKETS> _buckets;
+  std::mutex _mutex; ///< Lock for changing the chains.
+
+  /// Get the bucket for @a key.
+  std::atomic<Dest *> &bucket(CryptoHash const &key);
+  /// Find the destination for @a key in the chain starting at @a head.
+  static Dest *find(Dest *head, CryptoHash const &key);
+};
+
+extern PreWarmManager prewarmManager;
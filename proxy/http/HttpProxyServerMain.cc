@@ -38,6 +38,7 @@
 #include "ProtocolProbeSessionAccept.h"
 #include "http2/Http2SessionAccept.h"
 #include "HttpConnectionCount.h"
+#include "HttpPreWarm.h"
 #include "HttpProxyServerMain.h"
 
 #include <vector>
@@ -271,6 +272,7 @@ init_accept_HttpProxyServer(int n_accept_threads)
 
   init_reverse_proxy();
   http_pages_init();
+  prewarmManager.start();
 
 #ifdef USE_HTTP_DEBUG_LISTS
   ink_mutex_init(&debug_sm_list_mutex);
@@ -30,6 +30,7 @@
 #include "Http1ServerSession.h"
 #include "HttpDebugNames.h"
 #include "HttpSessionManager.h"
+#include "HttpHappyEyeballs.h"
 #include "P_Cache.h"
 #include "P_Net.h"
 #include "StatPages.h"
@@ -480,6 +481,7 @@ HttpSM::attach_client_session(ProxyTransaction *client_vc, IOBufferReader *buffe
       milestones[TS_MILESTONE_TLS_HANDSHAKE_START] = ssl_vc->sslHandshakeBeginTime;
       milestones[TS_MILESTONE_TLS_HANDSHAKE_END]   = ssl_vc->sslHandshakeEndTime;
     }
+    t_state.client_info.early_data = ssl_vc->takeEarlyData();
   }
   const char *protocol_str = client_vc->get_protocol_string();
   client_protocol          = protocol_str ? protocol_str : "-";
@@ -1645,8 +1647,8 @@ HttpSM::handle_api_return()
           SMDebug("http_websocket",
                   "(server session) Setting websocket active timeout=%" PRId64 "s and inactive timeout=%" PRId64 "s",
                   t_state.txn_conf->websocket_active_timeout, t_state.txn_conf->websocket_inactive_timeout);
-          server_session->get_netvc()->set_active_timeout(HRTIME_SECONDS(t_state.txn_conf->websocket_active_timeout));
-          server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->websocket_inactive_timeout));
+          server_session->set_active_timeout(HRTIME_SECONDS(t_state.txn_conf->websocket_active_timeout));
+          server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->websocket_inactive_timeout));
         }
       }
 
@@ -1728,8 +1730,9 @@ HttpSM::state_http_server_open(int event, void *data)
     netvc = static_cast<NetVConnection *>(data);
     session->attach_hostname(t_state.current.server->name);
     UnixNetVConnection *vc = static_cast<UnixNetVConnection *>(data);
-    ink_release_assert(pending_action == nullptr || pending_action == vc->get_action());
-    pending_action = nullptr;
+    ink_release_assert(pending_action == nullptr || pending_action == vc->get_action() || server_connect_raced);
+    pending_action       = nullptr;
+    server_connect_raced = false;
 
     session->new_connection(vc);
 
@@ -1771,11 +1774,21 @@ HttpSM::state_http_server_open(int event, void *data)
     SMDebug("http_ss", "[%" PRId64 "] TCP Handshake complete", sm_id);
     server_entry->vc_handler = &HttpSM::state_send_server_request_header;
 
+    // If the server chose HTTP/2, the connection goes to an HTTP/2 session and this transaction
+    // becomes its first stream. Its stream limit stays with the connection.
+    if (auto ssl_vc = dynamic_cast<SSLNetVConnection *>(server_session->get_netvc());
+        ssl_vc && ssl_vc->get_alpn_selected() == IP_PROTO_TAG_HTTP_2_0) {
+      httpSessionManager.start_http2_session(server_session,
+                                             std::clamp<MgmtInt>(t_state.txn_conf->http2_max_concurrent_streams_out, 1, INT32_MAX));
+      server_entry->read_vio  = server_session->do_io_read(this, 0, server_session->read_buffer);
+      server_entry->write_vio = server_session->do_io_write(this, 0, nullptr);
+    }
+
     // Reset the timeout to the non-connect timeout
     if (t_state.api_txn_no_activity_timeout_value != -1) {
-      server_session->get_netvc()->set_inactivity_timeout(HRTIME_MSECONDS(t_state.api_txn_no_activity_timeout_value));
+      server_session->set_inactivity_timeout(HRTIME_MSECONDS(t_state.api_txn_no_activity_timeout_value));
     } else {
-      server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
+      server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
     }
     handle_http_server_open();
     return 0;
@@ -1866,9 +1879,9 @@ HttpSM::state_read_server_response_header(int event, void *data)
     milestones[TS_MILESTONE_SERVER_FIRST_READ] = Thread::get_hrtime();
 
     if (t_state.api_txn_no_activity_timeout_value != -1) {
-      server_session->get_netvc()->set_inactivity_timeout(HRTIME_MSECONDS(t_state.api_txn_no_activity_timeout_value));
+      server_session->set_inactivity_timeout(HRTIME_MSECONDS(t_state.api_txn_no_activity_timeout_value));
     } else {
-      server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
+      server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
     }
 
     // For requests that contain a body, we can cancel the ua inactivity timeout.
@@ -3061,12 +3074,13 @@ HttpSM::tunnel_handler_server(int event, HttpTunnelProducer *p)
     // server session to so the next ka request can use it.  Server sessions will
     // be placed into the shared pool if the next incoming request is for a different
     // origin server
-    if (t_state.txn_conf->attach_server_session_to_client == 1 && ua_txn && t_state.client_info.keep_alive == HTTP_KEEPALIVE) {
+    if (t_state.txn_conf->attach_server_session_to_client == 1 && ua_txn && t_state.client_info.keep_alive == HTTP_KEEPALIVE &&
+        !server_session->is_multiplexed()) {
       Debug("http", "attaching server session to the client");
       ua_txn->attach_server_session(server_session);
     } else {
       // Release the session back into the shared session pool
-      server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
+      server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
       server_session->release();
     }
   }
@@ -3196,7 +3210,7 @@ HttpSM::tunnel_handler_ua(int event, HttpTunnelConsumer *c)
         HTTP_INCREMENT_DYN_STAT(http_background_fill_current_count_stat);
         ink_assert(server_entry->vc == server_session);
         ink_assert(c->is_downstream_from(server_session));
-        server_session->get_netvc()->set_active_timeout(HRTIME_SECONDS(t_state.txn_conf->background_fill_active_timeout));
+        server_session->set_active_timeout(HRTIME_SECONDS(t_state.txn_conf->background_fill_active_timeout));
       }
 
     } else {
@@ -4901,7 +4915,7 @@ HttpSM::do_http_server_open(bool raw)
       } else {
         // As this is in the non-sharing configuration, we want to close
         // the existing connection and call connect_re to get a new one
-        existing_ss->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
+        existing_ss->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
         existing_ss->release();
         ua_txn->attach_server_session(nullptr);
       }
@@ -4913,7 +4927,7 @@ HttpSM::do_http_server_open(bool raw)
   else if (ua_txn != nullptr) {
     Http1ServerSession *existing_ss = ua_txn->get_server_session();
     if (existing_ss) {
-      existing_ss->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
+      existing_ss->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
       existing_ss->release();
       ua_txn->attach_server_session(nullptr);
     }
@@ -4993,6 +5007,7 @@ HttpSM::do_http_server_open(bool raw)
 
   // We did not manage to get an existing session and need to open a new connection
   Action *connect_action_handle;
+  server_connect_raced = false;
 
   NetVCOptions opt;
   opt.f_blocking_connect = false;
@@ -5066,15 +5081,28 @@ HttpSM::do_http_server_open(bool raw)
     if (t_state.server_info.name) {
       opt.set_ssl_servername(t_state.server_info.name);
     }
+    if (server_http2_allowed()) {
+      opt.alpn_protos = HTTP2_OUTBOUND_ALPN_PROTOCOLS;
+    }
+    prewarm_server(opt, true);
 
-    connect_action_handle = sslNetProcessor.connect_re(this,                                 // state machine
-                                                       &t_state.current.server->dst_addr.sa, // addr + port
-                                                       &opt);
+    if (happy_eyeballs_allowed(opt)) {
+      connect_action_handle = happy_eyeballs_connect(opt, true);
+    } else {
+      connect_action_handle = sslNetProcessor.connect_re(this,                                 // state machine
+                                                         &t_state.current.server->dst_addr.sa, // addr + port
+                                                         &opt);
+    }
   } else {
     SMDebug("http", "calling netProcessor.connect_re");
-    connect_action_handle = netProcessor.connect_re(this,                                 // state machine
-                                                    &t_state.current.server->dst_addr.sa, // addr + port
-                                                    &opt);
+    prewarm_server(opt, false);
+    if (happy_eyeballs_allowed(opt)) {
+      connect_action_handle = happy_eyeballs_connect(opt, false);
+    } else {
+      connect_action_handle = netProcessor.connect_re(this,                                 // state machine
+                                                      &t_state.current.server->dst_addr.sa, // addr + port
+                                                      &opt);
+    }
   }
 
   if (connect_action_handle != ACTION_RESULT_DONE) {
@@ -5315,9 +5343,10 @@ HttpSM::release_server_session(bool serve_from_cache)
     HTTP_DECREMENT_DYN_STAT(http_current_server_transactions_stat);
     server_session->server_trans_stat--;
     server_session->attach_hostname(t_state.current.server->name);
-    if (t_state.www_auth_content == HttpTransact::CACHE_AUTH_NONE || serve_from_cache == false) {
+    if (t_state.www_auth_content == HttpTransact::CACHE_AUTH_NONE || serve_from_cache == false ||
+        server_session->is_multiplexed()) {
       // Must explicitly set the keep_alive_no_activity time before doing the release
-      server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
+      server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
       server_session->release();
     } else {
       // an authenticated server connection - attach to the local client
@@ -5717,7 +5746,7 @@ HttpSM::do_setup_post_tunnel(HttpVC_t to_vc_type)
   }
 
   ua_txn->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_in));
-  server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
+  server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
 
   tunnel.tunnel_run(p);
 
@@ -5949,26 +5978,12 @@ HttpSM::attach_server_session(Http1ServerSession *s)
   // Set the inactivity timeout to the connect timeout so that we
   //   we fail this server if it doesn't start sending the response
   //   header
-  MgmtInt connect_timeout;
-
-  if (t_state.method == HTTP_WKSIDX_POST || t_state.method == HTTP_WKSIDX_PUT) {
-    connect_timeout = t_state.txn_conf->post_connect_attempts_timeout;
-  } else if (t_state.current.server == &t_state.parent_info) {
-    connect_timeout = t_state.txn_conf->parent_connect_timeout;
-  } else {
-    connect_timeout = t_state.txn_conf->connect_attempts_timeout;
-  }
-
-  if (t_state.api_txn_connect_timeout_value != -1) {
-    server_session->get_netvc()->set_inactivity_timeout(HRTIME_MSECONDS(t_state.api_txn_connect_timeout_value));
-  } else {
-    server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(connect_timeout));
-  }
+  server_session->set_inactivity_timeout(get_server_connect_timeout());
 
   if (t_state.api_txn_active_timeout_value != -1) {
-    server_session->get_netvc()->set_active_timeout(HRTIME_MSECONDS(t_state.api_txn_active_timeout_value));
+    server_session->set_active_timeout(HRTIME_MSECONDS(t_state.api_txn_active_timeout_value));
   } else {
-    server_session->get_netvc()->set_active_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_active_timeout_out));
+    server_session->set_active_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_active_timeout_out));
   }
 
   if (plugin_tunnel_type != HTTP_NO_PLUGIN_TUNNEL || will_be_private_ss) {
@@ -5981,7 +5996,7 @@ void
 HttpSM::setup_server_send_request_api()
 {
   // Make sure the VC is on the correct timeout
-  server_session->get_netvc()->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
+  server_session->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->transaction_no_activity_timeout_out));
   t_state.api_next_action = HttpTransact::SM_ACTION_API_SEND_REQUEST_HDR;
   do_api_callout();
 }
@@ -7784,6 +7799,7 @@ HttpSM::redirect_request(const char *arg_redirect_url, const int arg_redirect_le
   // we want to close the server session
   // will do that in handle_api_return under the
   // HttpTransact::SM_ACTION_REDIRECT_READ state
+  t_state.parent_params->releaseParent(&t_state.parent_result);
   t_state.parent_result.reset();
   t_state.request_sent_time           = 0;
   t_state.response_received_time      = 0;
@@ -7963,6 +7979,75 @@ HttpSM::is_private()
   return res;
 }
 
+// HTTP/2 streams carry requests whose end is known from their header, and are shared by transactions.
+bool
+HttpSM::server_http2_allowed()
+{
+  return Http2::enabled_out && plugin_tunnel_type == HTTP_NO_PLUGIN_TUNNEL && !t_state.is_websocket &&
+         t_state.method != HTTP_WKSIDX_CONNECT && t_state.client_info.transfer_encoding != HttpTransact::CHUNKED_ENCODING &&
+         !will_be_private_ss && !is_private();
+}
+
+// Make the origin being connected to a pre-warm destination if the transaction asks for it. Connections made on behalf
+// of a particular client address can't be shared, so transparent connections are left out.
+void
+HttpSM::prewarm_server(NetVCOptions const &opt, bool tls)
+{
+  if (t_state.txn_conf->server_prewarm_min > 0 && opt.addr_binding != NetVCOptions::FOREIGN_ADDR &&
+      t_state.txn_conf->server_session_sharing_match != TS_SERVER_SESSION_SHARING_MATCH_NONE && t_state.current.server->name &&
+      !will_be_private_ss) {
+    prewarmManager.add(&t_state.current.server->dst_addr.sa, t_state.current.server->name, tls, opt,
+                       t_state.txn_conf->server_prewarm_min,
+                       static_cast<TSServerSessionSharingMatchType>(t_state.txn_conf->server_session_sharing_match),
+                       static_cast<TSServerSessionSharingPoolType>(t_state.http_config_param->server_session_sharing_pool),
+                       HRTIME_SECONDS(t_state.txn_conf->keep_alive_no_activity_timeout_out));
+  }
+}
+
+ink_hrtime
+HttpSM::get_server_connect_timeout() const
+{
+  MgmtInt connect_timeout;
+
+  if (t_state.method == HTTP_WKSIDX_POST || t_state.method == HTTP_WKSIDX_PUT) {
+    connect_timeout = t_state.txn_conf->post_connect_attempts_timeout;
+  } else if (t_state.current.server == &t_state.parent_info) {
+    connect_timeout = t_state.txn_conf->parent_connect_timeout;
+  } else {
+    connect_timeout = t_state.txn_conf->connect_attempts_timeout;
+  }
+
+  if (t_state.api_txn_connect_timeout_value != -1) {
+    return HRTIME_MSECONDS(t_state.api_txn_connect_timeout_value);
+  }
+  return HRTIME_SECONDS(connect_timeout);
+}
+
+// Race connections only to addresses that came from HostDB, and only when nothing ties the connection to one local
+// address or port, as those can't be shared between the attempts.
+bool
+HttpSM::happy_eyeballs_allowed(NetVCOptions const &opt) const
+{
+  return t_state.http_config_param->happy_eyeballs_enabled && ua_txn != nullptr && plugin_tunnel_type == HTTP_NO_PLUGIN_TUNNEL &&
+         !t_state.api_server_addr_set && !t_state.dns_info.srv_lookup_success && t_state.dns_info.lookup_name &&
+         t_state.dns_info.os_addr_style != HttpTransact::DNSLookupInfo::OS_Addr::OS_ADDR_TRY_CLIENT &&
+         t_state.dns_info.os_addr_style != HttpTransact::DNSLookupInfo::OS_Addr::OS_ADDR_USE_CLIENT &&
+         opt.addr_binding == NetVCOptions::ANY_ADDR && opt.local_port == 0;
+}
+
+Action *
+HttpSM::happy_eyeballs_connect(NetVCOptions const &opt, bool tls)
+{
+  SMDebug("http", "[%" PRId64 "] racing connections to %s", sm_id, t_state.dns_info.lookup_name);
+  Action *action = HappyEyeballs::connect(this, &t_state.current.server->dst_addr, t_state.hostdb_entry.get(),
+                                          t_state.dns_info.lookup_name, ua_txn->get_host_res_style(),
+                                          static_cast<int>(t_state.txn_conf->down_server_timeout), tls, opt,
+                                          get_server_connect_timeout(),
+                                          HRTIME_MSECONDS(t_state.http_config_param->happy_eyeballs_attempt_delay));
+  server_connect_raced = action != ACTION_RESULT_DONE;
+  return action;
+}
+
 // check to see if redirection is enabled and less than max redirections tries or if a plugin enabled redirection
 inline bool
 HttpSM::is_redirect_required()
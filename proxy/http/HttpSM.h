@@ -310,6 +310,16 @@ public:
 
   bool is_private();
   bool is_redirect_required();
+  /// Can the request to the server be sent on a stream of an HTTP/2 connection?
+  bool server_http2_allowed();
+  /// Keep connections open to the server being connected to with @a opt, if configured to.
+  void prewarm_server(NetVCOptions const &opt, bool tls);
+  /// Can the connection to the server be raced over several of its addresses?
+  bool happy_eyeballs_allowed(NetVCOptions const &opt) const;
+  /// Race connections to the addresses of the server, see @c HappyEyeballs.
+  Action *happy_eyeballs_connect(NetVCOptions const &opt, bool tls);
+  /// Inactivity timeout for a new connection to the server.
+  ink_hrtime get_server_connect_timeout() const;
 
   /// Get the protocol stack for the inbound (client, user agent) connection.
   /// @arg result [out] Array to store the results
@@ -384,6 +394,7 @@ protected:
    * we should create a new connection and then once we attach the session we'll mark it as private.
    */
   bool will_be_private_ss              = false;
+  bool server_connect_raced            = false; ///< The pending server connect is a Happy Eyeballs race.
   int shared_session_retries           = 0;
   IOBufferReader *server_buffer_reader = nullptr;
   void remove_server_entry();
@@ -45,11 +45,14 @@ initialize_thread_for_http_sessions(EThread *thread)
 
 HttpSessionManager httpSessionManager;
 
-ServerSessionPool::ServerSessionPool() : Continuation(new_ProxyMutex()), m_ip_pool(1023), m_fqdn_pool(1023)
+ServerSessionPool::ServerSessionPool()
+  : Continuation(new_ProxyMutex()), m_ip_pool(1023), m_fqdn_pool(1023), m_h2_ip_pool(127), m_h2_fqdn_pool(127)
 {
   SET_HANDLER(&ServerSessionPool::eventHandler);
   m_ip_pool.set_expansion_policy(IPTable::MANUAL);
   m_fqdn_pool.set_expansion_policy(FQDNTable::MANUAL);
+  m_h2_ip_pool.set_expansion_policy(Http2IPTable::MANUAL);
+  m_h2_fqdn_pool.set_expansion_policy(Http2FQDNTable::MANUAL);
 }
 
 void
@@ -143,6 +146,52 @@ ServerSessionPool::acquireSession(sockaddr const *addr, CryptoHash const &hostna
   return zret;
 }
 
+Http2ServerSession *
+ServerSessionPool::acquireHttp2Session(sockaddr const *addr, CryptoHash const &hostname_hash,
+                                       TSServerSessionSharingMatchType match_style, HttpSM *sm)
+{
+  if (TS_SERVER_SESSION_SHARING_MATCH_HOST == match_style) {
+    in_port_t port = ats_ip_port_cast(addr);
+    Http2FQDNTable::iterator first, last;
+    std::tie(first, last) =
+      static_cast<const decltype(m_h2_fqdn_pool)::range::super_type &>(m_h2_fqdn_pool.equal_range(hostname_hash));
+    for (; first != last; ++first) {
+      if (port == ats_ip_port_cast(first->get_server_ip()) && first->is_available() && validate_sni(sm, first->get_netvc())) {
+        return first;
+      }
+    }
+  } else if (TS_SERVER_SESSION_SHARING_MATCH_NONE != match_style) {
+    Http2IPTable::iterator first, last;
+    std::tie(first, last) = static_cast<const decltype(m_h2_ip_pool)::range::super_type &>(m_h2_ip_pool.equal_range(addr));
+    for (; first != last; ++first) {
+      if ((TS_SERVER_SESSION_SHARING_MATCH_IP == match_style || first->hostname_hash == hostname_hash) && first->is_available() &&
+          validate_sni(sm, first->get_netvc())) {
+        return first;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void
+ServerSessionPool::addHttp2Session(Http2ServerSession *ssn)
+{
+  ink_assert(ssn->pool == nullptr);
+  ssn->pool = this;
+  m_h2_ip_pool.insert(ssn);
+  m_h2_fqdn_pool.insert(ssn);
+  Debug("http_ss", "[%" PRId64 "] [release session] HTTP/2 session placed into thread pool", ssn->con_id);
+}
+
+void
+ServerSessionPool::removeHttp2Session(Http2ServerSession *ssn)
+{
+  ink_assert(ssn->pool == this);
+  m_h2_ip_pool.erase(ssn);
+  m_h2_fqdn_pool.erase(ssn);
+  ssn->pool = nullptr;
+}
+
 void
 ServerSessionPool::releaseSession(Http1ServerSession *ss)
 {
@@ -221,6 +270,18 @@ ServerSessionPool::eventHandler(int event, void *data)
         }
       }
 
+      // A pre-warmed session is kept open for as long as its destination is in use and the
+      // origin does not close it.
+      if ((event == VC_EVENT_INACTIVITY_TIMEOUT || event == VC_EVENT_ACTIVE_TIMEOUT) && s->state == HSS_KA_SHARED &&
+          s->prewarm_dest &&
+          s->prewarm_dest->is_wanted(Thread::get_hrtime(), HRTIME_SECONDS(http_config_params->prewarm_expire))) {
+        Debug("http_ss", "[%" PRId64 "] [session_bucket] pre-warmed session received io notice [%s], resetting timeout",
+              s->con_id, HttpDebugNames::get_event_name(event));
+        s->get_netvc()->set_inactivity_timeout(s->get_netvc()->get_inactivity_timeout());
+        found = true;
+        break;
+      }
+
       // We've found our server session. Remove it from
       //   our lists and close it down
       Debug("http_ss", "[%" PRId64 "] [session_pool] session %p received io notice [%s]", s->con_id, s,
@@ -273,6 +334,68 @@ HttpSessionManager::purge_keepalives()
   } // should we do something clever if we don't get the lock?
 }
 
+bool
+HttpSessionManager::migrate_session(ServerSessionPool *pool, Http1ServerSession *ss, HttpSM *sm)
+{
+  EThread *ethread              = this_ethread();
+  UnixNetVConnection *server_vc = dynamic_cast<UnixNetVConnection *>(ss->get_netvc());
+
+  if (server_vc) {
+    bool moved                 = server_vc->thread != ethread;
+    UnixNetVConnection *new_vc = server_vc->migrateToCurrentThread(sm, ethread);
+    if (new_vc->thread != ethread) {
+      // Failed to migrate, put it back in the pool it came from
+      pool->releaseSession(ss);
+      return false;
+    } else if (new_vc != server_vc) {
+      // The VC migrated, keep things from timing out on us
+      new_vc->set_inactivity_timeout(new_vc->get_inactivity_timeout());
+      ss->set_netvc(new_vc);
+    } else {
+      // The VC moved, keep things from timing out on us
+      server_vc->set_inactivity_timeout(server_vc->get_inactivity_timeout());
+    }
+    if (moved) {
+      HTTP_INCREMENT_DYN_STAT(http_server_session_migrations_stat);
+      if (ss->conn_track_group) {
+        ++ss->conn_track_group->_migrated;
+      }
+    }
+  }
+  return true;
+}
+
+HSMresult_t
+HttpSessionManager::acquire_sibling_session(sockaddr const *ip, CryptoHash const &hostname_hash,
+                                            TSServerSessionSharingMatchType match_style, HttpSM *sm, Http1ServerSession *&to_return)
+{
+  EThread *ethread = this_ethread();
+  auto threads     = eventProcessor.active_group_threads(ET_NET);
+  int n            = threads.end() - threads.begin();
+
+  // Start each search at a different sibling so one thread's pool isn't drained first every time.
+  static std::atomic<unsigned> next_start{0};
+  int start = next_start++ % std::max(n, 1);
+
+  for (int i = 0; i < n; ++i) {
+    EThread *t              = threads.begin()[(start + i) % n];
+    ServerSessionPool *pool = t->server_session_pool;
+    if (t == ethread || pool == nullptr) {
+      continue;
+    }
+    // Never wait on a sibling, it is busy with its own sessions. Move on to the next one instead.
+    MUTEX_TRY_LOCK(lock, pool->mutex, ethread);
+    if (lock.is_locked() && pool->acquireSession(ip, hostname_hash, match_style, sm, to_return) == HSM_DONE) {
+      Debug("http_ss", "[%" PRId64 "] [acquire session] taken from the pool of thread %p", to_return->con_id, t);
+      if (migrate_session(pool, to_return, sm)) {
+        return HSM_DONE;
+      }
+      to_return = nullptr;
+    }
+  }
+  return HSM_NOT_FOUND;
+}
+
 HSMresult_t
 HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockaddr const *ip, const char *hostname,
                                     ProxyTransaction *ua_txn, HttpSM *sm)
@@ -284,6 +407,9 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
   HSMresult_t retval = HSM_NOT_FOUND;
 
   CryptoContext().hash_immediate(hostname_hash, (unsigned char *)hostname, strlen(hostname));
+  if (sm->t_state.txn_conf->server_prewarm_min > 0) {
+    prewarmManager.touch(ip, hostname_hash, sm->t_state.txn_conf->server_prewarm_min);
+  }
 
   // First check to see if there is a server session bound
   //   to the user agent session
@@ -298,6 +424,10 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
     if (ServerSessionPool::match(to_return, ip, hostname_hash, match_style) &&
         ServerSessionPool::validate_sni(sm, to_return->get_netvc())) {
       Debug("http_ss", "[%" PRId64 "] [acquire session] returning attached session ", to_return->con_id);
+      HTTP_INCREMENT_DYN_STAT(http_server_session_reuse_stat);
+      if (to_return->conn_track_group) {
+        ++to_return->conn_track_group->_reused;
+      }
       to_return->state = HSS_ACTIVE;
       sm->attach_server_session(to_return);
       return HSM_DONE;
@@ -312,6 +442,29 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
     to_return = nullptr;
   }
 
+  // An HTTP/2 session on this thread with room for another stream is preferred to a connection of
+  // its own. These are always in the thread pool, as their streams call back on the thread.
+  if (sm->server_http2_allowed() && this_ethread()->server_session_pool) {
+    EThread *ethread        = this_ethread();
+    ServerSessionPool *pool = ethread->server_session_pool;
+    MUTEX_TRY_LOCK(lock, pool->mutex, ethread);
+    if (lock.is_locked()) {
+      if (Http2ServerSession *h2_session = pool->acquireHttp2Session(ip, hostname_hash, match_style, sm); h2_session) {
+        SCOPED_MUTEX_LOCK(h2_lock, h2_session->mutex, ethread);
+        to_return                = THREAD_ALLOC_INIT(http1ServerSessionAllocator, ethread);
+        to_return->sharing_pool  = TS_SERVER_SESSION_SHARING_POOL_THREAD;
+        to_return->sharing_match = match_style;
+        to_return->hostname_hash = hostname_hash;
+        to_return->new_stream(h2_session->create_stream(), h2_session->get_netvc());
+        Debug("http_ss", "[%" PRId64 "] [acquire session] new stream on HTTP/2 session %" PRId64, to_return->con_id,
+              h2_session->con_id);
+        to_return->state = HSS_ACTIVE;
+        sm->attach_server_session(to_return);
+        return HSM_DONE;
+      }
+    }
+  }
+
   // TS-3797 Adding another scope so the pool lock is dropped after it is removed from the pool and
   // potentially moved to the current thread.  At the end of this scope, either the original
   // pool selected VC is on the current thread or its content has been moved to a new VC on the
@@ -320,14 +473,14 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
   // client session
   {
     // Now check to see if we have a connection in our shared connection pool
-    EThread *ethread = this_ethread();
+    EThread *ethread                      = this_ethread();
+    TSServerSessionSharingPoolType pool_t =
+      static_cast<TSServerSessionSharingPoolType>(sm->t_state.http_config_param->server_session_sharing_pool);
     Ptr<ProxyMutex> pool_mutex =
-      (TS_SERVER_SESSION_SHARING_POOL_THREAD == sm->t_state.http_config_param->server_session_sharing_pool) ?
-        ethread->server_session_pool->mutex :
-        m_g_pool->mutex;
+      (TS_SERVER_SESSION_SHARING_POOL_GLOBAL == pool_t) ? m_g_pool->mutex : ethread->server_session_pool->mutex;
     MUTEX_TRY_LOCK(lock, pool_mutex, ethread);
     if (lock.is_locked()) {
-      if (TS_SERVER_SESSION_SHARING_POOL_THREAD == sm->t_state.http_config_param->server_session_sharing_pool) {
+      if (TS_SERVER_SESSION_SHARING_POOL_GLOBAL != pool_t) {
         retval = ethread->server_session_pool->acquireSession(ip, hostname_hash, match_style, sm, to_return);
         Debug("http_ss", "[acquire session] thread pool search %s", to_return ? "successful" : "failed");
       } else {
@@ -335,33 +488,31 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
         Debug("http_ss", "[acquire session] global pool search %s", to_return ? "successful" : "failed");
         // At this point to_return has been removed from the pool. Do we need to move it
         // to the same thread?
-        if (to_return) {
-          UnixNetVConnection *server_vc = dynamic_cast<UnixNetVConnection *>(to_return->get_netvc());
-          if (server_vc) {
-            UnixNetVConnection *new_vc = server_vc->migrateToCurrentThread(sm, ethread);
-            if (new_vc->thread != ethread) {
-              // Failed to migrate, put it back to global session pool
-              m_g_pool->releaseSession(to_return);
-              to_return = nullptr;
-              retval    = HSM_NOT_FOUND;
-            } else if (new_vc != server_vc) {
-              // The VC migrated, keep things from timing out on us
-              new_vc->set_inactivity_timeout(new_vc->get_inactivity_timeout());
-              to_return->set_netvc(new_vc);
-            } else {
-              // The VC moved, keep things from timing out on us
-              server_vc->set_inactivity_timeout(server_vc->get_inactivity_timeout());
-            }
-          }
+        if (to_return && !migrate_session(m_g_pool, to_return, sm)) {
+          to_return = nullptr;
+          retval    = HSM_NOT_FOUND;
         }
       }
-    } else { // Didn't get the lock.  to_return is still NULL
+    } else if (TS_SERVER_SESSION_SHARING_POOL_HYBRID != pool_t) { // Didn't get the lock.  to_return is still NULL
       retval = HSM_RETRY;
     }
+
+    // In the hybrid pool a miss on this thread looks in the other threads' pools before a new
+    // connection is opened.
+    if (!to_return && TS_SERVER_SESSION_SHARING_POOL_HYBRID == pool_t) {
+      retval = acquire_sibling_session(ip, hostname_hash, match_style, sm, to_return);
+    }
   }
 
   if (to_return) {
     Debug("http_ss", "[%" PRId64 "] [acquire session] return session from shared pool", to_return->con_id);
+    HTTP_INCREMENT_DYN_STAT(http_server_session_reuse_stat);
+    if (to_return->conn_track_group) {
+      ++to_return->conn_track_group->_reused;
+    }
+    if (to_return->prewarm_dest) {
+      PreWarmManager::note_used(to_return);
+    }
     to_return->state = HSS_ACTIVE;
     // the attach_server_session will issue the do_io_read under the sm lock
     sm->attach_server_session(to_return);
@@ -370,12 +521,43 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
   return retval;
 }
 
+void
+HttpSessionManager::start_http2_session(Http1ServerSession *ss, uint32_t max_streams)
+{
+  EThread *ethread               = this_ethread();
+  Http2ServerSession *h2_session = THREAD_ALLOC_INIT(http2ServerSessionAllocator, ethread);
+
+  // The HTTP/2 session takes over the connection along with what is counted against it.
+  h2_session->con_id           = ss->con_id;
+  h2_session->hostname_hash    = ss->hostname_hash;
+  h2_session->conn_track_group = ss->conn_track_group;
+  h2_session->to_parent_proxy  = ss->to_parent_proxy;
+
+  ink_hrtime active_timeout   = ss->get_netvc()->get_active_timeout();
+  ink_hrtime inactive_timeout = ss->get_netvc()->get_inactivity_timeout();
+
+  SCOPED_MUTEX_LOCK(lock, ss->get_netvc()->mutex, ethread);
+  h2_session->new_connection(ss->get_netvc(), max_streams);
+
+  SCOPED_MUTEX_LOCK(h2_lock, h2_session->mutex, ethread);
+  if (!ss->private_session && TS_SERVER_SESSION_SHARING_MATCH_NONE != ss->sharing_match && ethread->server_session_pool) {
+    SCOPED_MUTEX_LOCK(pool_lock, ethread->server_session_pool->mutex, ethread);
+    ethread->server_session_pool->addHttp2Session(h2_session);
+  }
+
+  Http2ServerStream *stream = h2_session->create_stream();
+  ss->attach_stream(stream);
+  stream->set_active_timeout(active_timeout);
+  stream->set_inactivity_timeout(inactive_timeout);
+  Debug("http_ss", "[%" PRId64 "] [start session] server selected HTTP/2", ss->con_id);
+}
+
 HSMresult_t
 HttpSessionManager::release_session(Http1ServerSession *to_release)
 {
   EThread *ethread = this_ethread();
   ServerSessionPool *pool =
-    TS_SERVER_SESSION_SHARING_POOL_THREAD == to_release->sharing_pool ? ethread->server_session_pool : m_g_pool;
+    TS_SERVER_SESSION_SHARING_POOL_GLOBAL == to_release->sharing_pool ? m_g_pool : ethread->server_session_pool;
   bool released_p = true;
 
   // The per thread lock looks like it should not be needed but if it's not locked the close checking I/O op will crash.
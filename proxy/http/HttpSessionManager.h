@@ -34,6 +34,7 @@
 
 #include "P_EventSystem.h"
 #include "Http1ServerSession.h"
+#include "http2/Http2ServerSession.h"
 #include "tscore/IntrusiveHashMap.h"
 
 class ProxyTransaction;
@@ -67,8 +68,10 @@ public:
   static bool validate_sni(HttpSM *sm, NetVConnection *netvc);
 
 protected:
-  using IPTable   = IntrusiveHashMap<Http1ServerSession::IPLinkage>;
-  using FQDNTable = IntrusiveHashMap<Http1ServerSession::FQDNLinkage>;
+  using IPTable        = IntrusiveHashMap<Http1ServerSession::IPLinkage>;
+  using FQDNTable      = IntrusiveHashMap<Http1ServerSession::FQDNLinkage>;
+  using Http2IPTable   = IntrusiveHashMap<Http2ServerSession::IPLinkage>;
+  using Http2FQDNTable = IntrusiveHashMap<Http2ServerSession::FQDNLinkage>;
 
 public:
   /** Check if a session matches address and host name.
@@ -92,10 +95,28 @@ public:
   /// Close all sessions and then clear the table.
   void purge();
 
+  /** Find an HTTP/2 session that can take a stream for the request of @a sm.
+
+      The session is selected like @a acquireSession selects one, but it stays in the pool to be
+      shared with other transactions.
+
+      @return The session, or @c nullptr if none matches or all matching ones are full.
+  */
+  Http2ServerSession *acquireHttp2Session(sockaddr const *addr, CryptoHash const &host_hash,
+                                          TSServerSessionSharingMatchType match_style, HttpSM *sm);
+  /// Share @a ssn with the transactions on this thread.
+  void addHttp2Session(Http2ServerSession *ssn);
+  /// Stop sharing @a ssn, because it is closing or draining.
+  void removeHttp2Session(Http2ServerSession *ssn);
+
   // Pools of server sessions.
   // Note that each server session is stored in both pools.
   IPTable m_ip_pool;
   FQDNTable m_fqdn_pool;
+
+  // Pools of HTTP/2 server sessions, only ever used by the thread that owns the pool.
+  Http2IPTable m_h2_ip_pool;
+  Http2FQDNTable m_h2_fqdn_pool;
 };
 
 class HttpSessionManager
@@ -105,11 +126,26 @@ public:
   ~HttpSessionManager() {}
   HSMresult_t acquire_session(Continuation *cont, sockaddr const *addr, const char *hostname, ProxyTransaction *ua_txn, HttpSM *sm);
   HSMresult_t release_session(Http1ServerSession *to_release);
+  /** Hand the connection of @a ss, on which the server selected HTTP/2, to a new HTTP/2 session.
+
+      @a ss becomes the session for the first stream on it. The connection carries at most
+      @a max_streams streams at once, for as long as it is open.
+  */
+  void start_http2_session(Http1ServerSession *ss, uint32_t max_streams);
   void purge_keepalives();
   void init();
   int main_handler(int event, void *data);
 
 private:
+  /** Move @a ss, just taken from @a pool, to the current thread.
+
+      @return @c true if @a ss is now on this thread, @c false if it could not be moved and was released back to @a pool.
+  */
+  bool migrate_session(ServerSessionPool *pool, Http1ServerSession *ss, HttpSM *sm);
+  /// Look for a matching session in the per thread pools of the other threads, moving it to this thread if found.
+  HSMresult_t acquire_sibling_session(sockaddr const *ip, CryptoHash const &hostname_hash,
+                                      TSServerSessionSharingMatchType match_style, HttpSM *sm, Http1ServerSession *&to_return);
+
   /// Global pool, used if not per thread pools.
   /// @internal We delay creating this because the session manager is created during global statics init.
   ServerSessionPool *m_g_pool;
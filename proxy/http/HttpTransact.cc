@@ -33,6 +33,7 @@
 #include "HttpDebugNames.h"
 #include <ctime>
 #include "tscore/ParseRules.h"
+#include "tscpp/util/TextView.h"
 #include "HTTP.h"
 #include "HdrUtils.h"
 #include "logging/Log.h"
@@ -132,6 +133,26 @@ is_request_conditional(HTTPHdr *header)
           (header->method_get_wksidx() == HTTP_WKSIDX_GET || header->method_get_wksidx() == HTTP_WKSIDX_HEAD));
 }
 
+// Early data can be replayed by an attacker, so only methods listed as safe to replay are served from it (RFC 8470).
+inline static bool
+is_early_data_method_allowed(HttpTransact::State *s, HTTPHdr *header)
+{
+  int method_len;
+  const char *method = header->method_get(&method_len);
+  const char *list   = s->http_config_param->early_data_methods;
+  ts::TextView methods{list, list ? strlen(list) : 0};
+
+  if (method == nullptr || methods.empty()) {
+    return false;
+  }
+  while (methods.ltrim_if(&ParseRules::is_ws)) {
+    if (0 == strcasecmp(methods.take_prefix_if(&ParseRules::is_ws), std::string_view(method, method_len))) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static inline bool
 is_port_in_range(int port, HttpConfigPortRange *pr)
 {
@@ -708,6 +729,22 @@ HttpTransact::EndRemapRequest(State *s)
     goto done;
   }
 
+  /////////////////////////////////////////////////////////////////////
+  // Requests sent as TLS early data are checked once the remap has  //
+  // had a chance to override whether early data is allowed.         //
+  /////////////////////////////////////////////////////////////////////
+  if (s->client_info.early_data) {
+    if (!s->txn_conf->allow_early_data || !is_early_data_method_allowed(s, incoming_request)) {
+      TxnDebug("http_trans", "Request sent as early data is not allowed, asking the client to retry after the handshake.");
+      HTTP_INCREMENT_DYN_STAT(http_early_data_rejected_stat);
+      build_error_response(s, HTTP_STATUS_TOO_EARLY, "Too Early", nullptr);
+      s->reverse_proxy = false;
+      goto done;
+    }
+    // Tell the origin the request can be replayed, so it can answer 425 itself.
+    incoming_request->value_set("Early-Data", 10, "1", 1);
+  }
+
   ///////////////////////////////////////////////////////////////
   // if no mapping was found, handle the cases where:          //
   //                                                           //
@@ -564,6 +564,8 @@ public:
 
     /// @c true if the connection is transparent.
     bool is_transparent = false;
+    /// @c true if the request arrived as TLS early data, before the handshake completed.
+    bool early_data = false;
     ProxyError rx_error_code;
     ProxyError tx_error_code;
 
@@ -866,6 +868,9 @@ public:
       free_internal_msg_buffer();
       ats_free(internal_msg_buffer_type);
 
+      if (parent_params) {
+        parent_params->releaseParent(&parent_result);
+      }
       ParentConfig::release(parent_params);
       parent_params = nullptr;
 
@@ -0,0 +1,206 @@
+/** @file
+
+    Index of regex_map host patterns by required domain suffix.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include "RegexMappingIndex.h"
+
+#include <cctype>
+#include <cstring>
+
+int
+RegexMappingIndex::Candidates::next()
+{
+  if (_all >= 0) {
+    return _all < _count ? _all++ : -1;
+  }
+
+  // Merge the lists, they are short and few so a linear pick is fine.
+  int best      = -1;
+  int best_list = -1;
+  for (int i = 0; i < _n_lists; ++i) {
+    if (_pos[i] < _lists[i]->size()) {
+      int n = (*_lists[i])[_pos[i]];
+      if (best < 0 || n < best) {
+        best      = n;
+        best_list = i;
+      }
+    }
+  }
+  if (best_list >= 0) {
+    ++_pos[best_list];
+  }
+  return best;
+}
+
+int
+RegexMappingIndex::insert(std::string_view pattern)
+{
+  int n    = _count++;
+  auto key = suffix_key(pattern);
+
+  if (key.empty()) {
+    _unindexed.push_back(n);
+  } else if (auto spot = _by_suffix.find(key); spot != _by_suffix.end()) {
+    spot->second.push_back(n);
+  } else {
+    _by_suffix[_keys.emplace_back(std::move(key))].push_back(n);
+  }
+  return n;
+}
+
+void
+RegexMappingIndex::lookup(std::string_view host, Candidates &candidates) const
+{
+  candidates._n_lists = 0;
+  candidates._all     = -1;
+
+  auto add = [&](const std::vector<int> &list) -> bool {
+    if (candidates._n_lists >= Candidates::MAX_LISTS) {
+      candidates._all   = 0;
+      candidates._count = _count;
+      return false;
+    }
+    candidates._lists[candidates._n_lists] = &list;
+    candidates._pos[candidates._n_lists]   = 0;
+    ++candidates._n_lists;
+    return true;
+  };
+
+  if (!_unindexed.empty()) {
+    add(_unindexed);
+  }
+  if (_by_suffix.empty()) {
+    return;
+  }
+  for (size_t dot = host.find('.'); dot != std::string_view::npos; dot = host.find('.', dot + 1)) {
+    if (auto spot = _by_suffix.find(host.substr(dot + 1)); spot != _by_suffix.end()) {
+      if (!add(spot->second)) {
+        return;
+      }
+    }
+  }
+}
+
+void
+RegexMappingIndex::clear()
+{
+  _by_suffix.clear();
+  _keys.clear();
+  _unindexed.clear();
+  _count = 0;
+}
+
+/* Walk the pattern keeping the run of literal characters at the end. Anything that is not plainly a
+   literal character clears the run, which only ever makes the key shorter and so is always safe. The
+   run is used only if the pattern ends with a '$' outside any group and has no top level alternation.
+   Constructs whose extent is hard to know (inline options, escapes taking arguments) disable indexing.
+*/
+std::string
+RegexMappingIndex::suffix_key(std::string_view pattern)
+{
+  std::string literal;
+  int depth = 0;
+
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    char c = pattern[i];
+    switch (c) {
+    case '\\':
+      if (++i >= pattern.size()) {
+        return {};
+      }
+      c = pattern[i];
+      if (ispunct(static_cast<unsigned char>(c))) {
+        literal += c;
+      } else if (strchr("dDwWsSbB", c) != nullptr) {
+        literal.clear();
+      } else {
+        return {};
+      }
+      break;
+    case '[':
+      // Skip the character class, a ']' first in the class is a literal.
+      if (++i < pattern.size() && pattern[i] == '^') {
+        ++i;
+      }
+      if (i < pattern.size() && pattern[i] == ']') {
+        ++i;
+      }
+      for (; i < pattern.size() && pattern[i] != ']'; ++i) {
+        if (pattern[i] == '\\') {
+          ++i;
+        } else if (pattern[i] == '[' && i + 1 < pattern.size() && pattern[i + 1] == ':') {
+          auto end = pattern.find(":]", i + 2);
+          if (end == std::string_view::npos) {
+            return {};
+          }
+          i = end + 1;
+        }
+      }
+      if (i >= pattern.size()) {
+        return {};
+      }
+      literal.clear();
+      break;
+    case '(':
+      if (i + 1 < pattern.size() && pattern[i + 1] == '?') {
+        return {};
+      }
+      ++depth;
+      literal.clear();
+      break;
+    case ')':
+      --depth;
+      literal.clear();
+      break;
+    case '|':
+      if (depth <= 0) {
+        return {};
+      }
+      literal.clear();
+      break;
+    case '{':
+      if (auto end = pattern.find('}', i); end != std::string_view::npos) {
+        i = end;
+      }
+      literal.clear();
+      break;
+    case '$':
+      if (i + 1 == pattern.size() && depth == 0) {
+        auto dot = literal.find('.');
+        return dot == std::string::npos ? std::string{} : literal.substr(dot + 1);
+      }
+      literal.clear();
+      break;
+    case '.':
+    case '^':
+    case '*':
+    case '+':
+    case '?':
+      literal.clear();
+      break;
+    default:
+      literal += c;
+      break;
+    }
+  }
+
+  return {};
+}
@@ -0,0 +1,99 @@
+/** @file
+
+    Index of regex_map host patterns by required domain suffix.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/** Candidate filter for regex host mappings.
+
+    Nearly every regex_map rule ends its host pattern with a literal domain, e.g. "^(.*)\.example\.com$".
+    A host can only match such a rule if it ends with that literal, so the rule is filed under the part
+    of the literal after its first '.', which is then a suffix of the host following a '.'. Rules without
+    a usable literal go on a list that is always checked.
+
+    Rules are added in rank order and numbered from 0. A lookup yields, in ascending order, the numbers of
+    the rules that can possibly match the host, so only those need the regular expression run against it.
+*/
+class RegexMappingIndex
+{
+public:
+  /// Ascending iteration over the candidate rules for a host.
+  class Candidates
+  {
+  public:
+    /// @return The next candidate rule, or -1 if there are no more.
+    int next();
+
+  private:
+    friend class RegexMappingIndex;
+
+    /// Lists of rules to merge. Past this many, every rule is a candidate.
+    static constexpr int MAX_LISTS = 16;
+
+    const std::vector<int> *_lists[MAX_LISTS];
+    size_t _pos[MAX_LISTS];
+    int _n_lists = 0;
+    int _all     = -1; ///< Next rule when scanning all of them, -1 if not.
+    int _count   = 0;  ///< Number of rules when scanning all of them.
+  };
+
+  /** Add a rule.
+
+      @param pattern The host regular expression of the rule.
+      @return The number of the rule.
+  */
+  int insert(std::string_view pattern);
+
+  /** Find the rules that can match a host.
+
+      @param host Lower cased request host.
+      @param candidates [out] Iterator over the candidate rules.
+  */
+  void lookup(std::string_view host, Candidates &candidates) const;
+
+  /// @return The number of rules.
+  int
+  size() const
+  {
+    return _count;
+  }
+
+  void clear();
+
+  /** The index key for a host pattern.
+
+      @return The domain that must follow a '.' at the end of any host matching @a pattern, or an empty
+      string if no such domain can be determined.
+  */
+  static std::string suffix_key(std::string_view pattern);
+
+private:
+  std::deque<std::string> _keys; ///< Storage for the suffix keys.
+  std::unordered_map<std::string_view, std::vector<int>> _by_suffix;
+  std::vector<int> _unindexed;
+  int _count = 0;
+};
@@ -26,6 +26,7 @@
 #include "tscore/ink_config.h"
 #include "UrlMapping.h"
 #include "UrlMappingPathIndex.h"
+#include "RegexMappingIndex.h"
 #include "HttpTransact.h"
 #include "tscore/Regex.h"
 
@@ -120,6 +121,9 @@ public:
   struct MappingsStore {
     std::unique_ptr<URLTable> hash_lookup;
     RegexMappingList regex_list;
+    // The regex mappings in rank order, with an index to narrow down the ones to try for a host.
+    std::vector<RegexMapping *> regex_table;
+    RegexMappingIndex regex_index;
     bool
     empty()
     {
@@ -136,6 +140,8 @@ public:
   {
     _destroyTable(store.hash_lookup);
     _destroyList(store.regex_list);
+    store.regex_table.clear();
+    store.regex_index.clear();
   }
 
   bool InsertForwardMapping(mapping_type maptype, url_mapping *mapping, const char *src_host);
@@ -201,7 +207,7 @@ private:
                       UrlMappingContainer &mapping_container);
   url_mapping *_tableLookup(std::unique_ptr<URLTable> &h_table, URL *request_url, int request_port, char *request_host,
                             int request_host_len);
-  bool _regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
+  bool _regexMappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host,
                            int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container);
   int _expandSubstitutions(int *matches_info, const RegexMapping *reg_map, const char *matched_string, char *dest_buf,
                            int dest_buf_size);
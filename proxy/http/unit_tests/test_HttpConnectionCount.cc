@@ -0,0 +1,171 @@
+/** @file
+
+  Catch-based tests for HttpConnectionCount.cc.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "HttpConnectionCount.h"
+
+namespace
+{
+// Upstream @a i, as an address and a host name.
+struct Upstream {
+  IpEndpoint addr;
+  std::string fqdn;
+
+  explicit Upstream(int i) : fqdn("origin-" + std::to_string(i) + ".example.com")
+  {
+    ats_ip4_set(&addr, htonl(0x0a000000 + i), htons(80 + i % 2));
+  }
+};
+
+std::vector<Upstream>
+make_upstreams(int n, int base)
+{
+  std::vector<Upstream> upstreams;
+  upstreams.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    upstreams.emplace_back(base + i);
+  }
+  return upstreams;
+}
+
+// Run @a f(thread index) on @a n_threads threads and return the elapsed time.
+template <typename F>
+std::chrono::milliseconds
+run_threads(int n_threads, F const &f)
+{
+  std::vector<std::thread> threads;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back(f, t);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+}
+} // namespace
+
+TEST_CASE("OutboundConnTrack groups", "[http][OutboundConnTrack]")
+{
+  OutboundConnTrack::TxnConfig config;
+  std::vector<OutboundConnTrack::Group const *> groups;
+  auto upstreams = make_upstreams(100, 1000);
+
+  SECTION("one group per upstream")
+  {
+    config.match = OutboundConnTrack::MATCH_BOTH;
+    std::vector<OutboundConnTrack::Group *> first;
+    for (auto const &u : upstreams) {
+      first.push_back(OutboundConnTrack::obtain(config, u.fqdn, u.addr)._g);
+    }
+    for (size_t i = 0; i < upstreams.size(); ++i) {
+      REQUIRE(OutboundConnTrack::obtain(config, upstreams[i].fqdn, upstreams[i].addr)._g == first[i]);
+      REQUIRE(first[i]->_fqdn == upstreams[i].fqdn);
+    }
+    std::sort(first.begin(), first.end());
+    REQUIRE(std::unique(first.begin(), first.end()) == first.end());
+  }
+
+  SECTION("match type decides the group")
+  {
+    config.match = OutboundConnTrack::MATCH_IP;
+    auto *by_ip  = OutboundConnTrack::obtain(config, "a.example.com", upstreams[0].addr)._g;
+    REQUIRE(OutboundConnTrack::obtain(config, "b.example.com", upstreams[0].addr)._g == by_ip);
+
+    config.match  = OutboundConnTrack::MATCH_HOST;
+    auto *by_host = OutboundConnTrack::obtain(config, "a.example.com", upstreams[0].addr)._g;
+    REQUIRE(by_host != by_ip);
+    REQUIRE(OutboundConnTrack::obtain(config, "a.example.com", upstreams[1].addr)._g == by_host);
+  }
+
+  SECTION("concurrent obtain creates each group once")
+  {
+    constexpr int N_THREADS = 8;
+    config.match            = OutboundConnTrack::MATCH_PORT;
+    auto fresh              = make_upstreams(500, 5000);
+    std::vector<std::vector<OutboundConnTrack::Group *>> seen(N_THREADS);
+
+    run_threads(N_THREADS, [&](int t) {
+      for (auto const &u : fresh) {
+        seen[t].push_back(OutboundConnTrack::obtain(config, u.fqdn, u.addr)._g);
+      }
+    });
+    for (int t = 1; t < N_THREADS; ++t) {
+      REQUIRE(seen[t] == seen[0]);
+    }
+
+    OutboundConnTrack::get(groups);
+    for (auto *g : seen[0]) {
+      REQUIRE(std::count(groups.begin(), groups.end(), g) == 1);
+    }
+  }
+}
+
+// Performance test, hidden by default. Run with `test_proxy_http "[performance]"`.
+// Compares group lookup against a single mutex guarded table, as the table used to be.
+TEST_CASE("OutboundConnTrack contention", "[http][OutboundConnTrack][performance][.]")
+{
+  constexpr int N_LOOPS     = 1000000;
+  constexpr int N_UPSTREAMS = 1000;
+  OutboundConnTrack::TxnConfig config;
+  config.match   = OutboundConnTrack::MATCH_IP;
+  auto upstreams = make_upstreams(N_UPSTREAMS, 100000);
+
+  std::mutex mutex;
+  std::unordered_map<uint64_t, OutboundConnTrack::Group *> locked_table;
+  for (auto const &u : upstreams) {
+    locked_table[ats_ip_hash(&u.addr.sa)] = OutboundConnTrack::obtain(config, u.fqdn, u.addr)._g;
+  }
+
+  for (int n_threads : {1, 2, 4, 8, 16}) {
+    auto lock_free = run_threads(n_threads, [&](int t) {
+      for (int i = 0; i < N_LOOPS; ++i) {
+        auto const &u = upstreams[(i + t * 7) % N_UPSTREAMS];
+        ++OutboundConnTrack::obtain(config, u.fqdn, u.addr)._g->_count;
+      }
+    });
+    auto locked = run_threads(n_threads, [&](int t) {
+      for (int i = 0; i < N_LOOPS; ++i) {
+        auto const &u = upstreams[(i + t * 7) % N_UPSTREAMS];
+        // Hash the name like obtain does, so only the table access differs.
+        CryptoHash hash;
+        CryptoContext().hash_immediate(hash, u.fqdn.data(), u.fqdn.size());
+        std::lock_guard<std::mutex> lock(mutex);
+        ++locked_table[ats_ip_hash(&u.addr.sa)]->_count;
+      }
+    });
+    std::cout << n_threads << " threads: lock free " << (lock_free.count() ? N_LOOPS * n_threads * 1000LL / lock_free.count() : 0)
+              << " obtains/sec, mutex " << (locked.count() ? N_LOOPS * n_threads * 1000LL / locked.count() : 0) << " obtains/sec"
+              << std::endl;
+  }
+}
@@ -0,0 +1,190 @@
+/** @file
+
+  Catch-based tests for RegexMappingIndex.cc.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "catch.hpp"
+
+#include "tscore/Regex.h"
+#include "RegexMappingIndex.h"
+
+using namespace std::literals;
+
+namespace
+{
+std::vector<int>
+candidates(RegexMappingIndex const &index, std::string_view host)
+{
+  RegexMappingIndex::Candidates c;
+  std::vector<int> result;
+  index.lookup(host, c);
+  for (int n = c.next(); n >= 0; n = c.next()) {
+    result.push_back(n);
+  }
+  return result;
+}
+
+// A remap.config with @a n regex_map rules for distinct sites, plus a couple that can't be indexed.
+std::vector<std::string>
+synthetic_patterns(int n)
+{
+  std::vector<std::string> patterns;
+  patterns.emplace_back("^origin[0-9]+\\.cdn\\.net$");
+  for (int i = 0; i < n; ++i) {
+    patterns.emplace_back("^(.*)\\.site" + std::to_string(i) + "\\.example\\.com$");
+  }
+  patterns.emplace_back("^(.*)\\.fallback\\.(com|net)$");
+  return patterns;
+}
+
+} // namespace
+
+TEST_CASE("RegexMappingIndex suffix key", "[proxy][remap]")
+{
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*)\\.example\\.com$") == "example.com");
+  REQUIRE(RegexMappingIndex::suffix_key("^www[0-9]+\\.example\\.com$") == "example.com");
+  REQUIRE(RegexMappingIndex::suffix_key("^(a|b)\\.example\\.com$") == "example.com");
+  REQUIRE(RegexMappingIndex::suffix_key("^[.a-z]+foo\\.example\\.com$") == "example.com");
+  REQUIRE(RegexMappingIndex::suffix_key("^.*bar\\.example\\.com$") == "example.com");
+  REQUIRE(RegexMappingIndex::suffix_key("\\.com$") == "com");
+
+  // Nothing usable.
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*)\\.example\\.com") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^a\\.example\\.com$|^b\\.example\\.org$") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*)\\.example\\.co.$") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*)\\.example\\.com?$") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*)\\.example\\x2ecom$") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("(?i)^(.*)\\.example\\.com$") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*\\.example\\.com$)") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^localhost$") == "");
+  REQUIRE(RegexMappingIndex::suffix_key("^(.*)\\.example\\.com{2}$") == "");
+}
+
+TEST_CASE("RegexMappingIndex lookup", "[proxy][remap]")
+{
+  RegexMappingIndex index;
+
+  REQUIRE(index.insert("^(.*)\\.example\\.com$") == 0);
+  REQUIRE(index.insert("^host[0-9]+$") == 1);
+  REQUIRE(index.insert("^(.*)\\.b\\.example\\.com$") == 2);
+  REQUIRE(index.insert("^(.*)\\.example\\.org$") == 3);
+  REQUIRE(index.insert("^(.*)\\.example\\.com$") == 4);
+  REQUIRE(index.size() == 5);
+
+  REQUIRE(candidates(index, "www.example.com") == std::vector<int>{0, 1, 4});
+  REQUIRE(candidates(index, "a.b.example.com") == std::vector<int>{0, 1, 2, 4});
+  REQUIRE(candidates(index, "www.example.org") == std::vector<int>{1, 3});
+  REQUIRE(candidates(index, "example.com") == std::vector<int>{1});
+  REQUIRE(candidates(index, "host7") == std::vector<int>{1});
+
+  index.clear();
+  REQUIRE(index.size() == 0);
+  REQUIRE(candidates(index, "www.example.com").empty());
+}
+
+TEST_CASE("RegexMappingIndex agrees with regex", "[proxy][remap]")
+{
+  auto patterns = synthetic_patterns(50);
+  std::vector<Regex> regexes(patterns.size());
+  RegexMappingIndex index;
+
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    REQUIRE(regexes[i].compile(patterns[i].c_str()));
+    index.insert(patterns[i]);
+  }
+
+  for (auto host : {"www.site7.example.com"sv, "a.b.site49.example.com"sv, "origin12.cdn.net"sv, "x.fallback.net"sv,
+                    "site7.example.com"sv, "www.site50.example.com"sv, "nowhere.test"sv}) {
+    int expected = -1;
+    for (size_t i = 0; i < regexes.size() && expected < 0; ++i) {
+      if (regexes[i].exec(host)) {
+        expected = i;
+      }
+    }
+    int found = -1;
+    RegexMappingIndex::Candidates c;
+    index.lookup(host, c);
+    for (int n = c.next(); n >= 0 && found < 0; n = c.next()) {
+      if (regexes[n].exec(host)) {
+        found = n;
+      }
+    }
+    REQUIRE(found == expected);
+  }
+}
+
+// Performance test, hidden by default. Run with `test_proxy_http "[performance]"`.
+TEST_CASE("RegexMappingIndex performance", "[proxy][remap][performance][.]")
+{
+  constexpr int N_RULES = 2000;
+  constexpr int N_LOOPS = 2000;
+
+  auto patterns = synthetic_patterns(N_RULES);
+  std::vector<Regex> regexes(patterns.size());
+  RegexMappingIndex index;
+
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    regexes[i].compile(patterns[i].c_str());
+    index.insert(patterns[i]);
+  }
+
+  // A host matching one of the last rules, the worst case for a linear walk.
+  std::string host = "www.site" + std::to_string(N_RULES - 1) + ".example.com";
+  int linear       = 0;
+  int indexed      = 0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int loop = 0; loop < N_LOOPS; ++loop) {
+    for (auto &re : regexes) {
+      if (re.exec(host)) {
+        ++linear;
+        break;
+      }
+    }
+  }
+  auto delta = std::chrono::high_resolution_clock::now() - start;
+  std::cout << "Linear regex_map lookup, " << regexes.size() << " rules: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / N_LOOPS << "ns" << std::endl;
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int loop = 0; loop < N_LOOPS; ++loop) {
+    RegexMappingIndex::Candidates c;
+    index.lookup(host, c);
+    for (int n = c.next(); n >= 0; n = c.next()) {
+      if (regexes[n].exec(host)) {
+        ++indexed;
+        break;
+      }
+    }
+  }
+  delta = std::chrono::high_resolution_clock::now() - start;
+  std::cout << "Indexed regex_map lookup, " << regexes.size() << " rules: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count() / N_LOOPS << "ns" << std::endl;
+
+  REQUIRE(linear == N_LOOPS);
+  REQUIRE(indexed == N_LOOPS);
+}
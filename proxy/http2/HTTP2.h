@@ -84,6 +84,10 @@ enum {
   HTTP2_STAT_SESSION_DIE_EOS,
   HTTP2_STAT_SESSION_DIE_ERROR,
   HTTP2_STAT_SESSION_DIE_HIGH_ERROR_RATE,
+  HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT, // Current # of HTTP2 connections to servers
+  HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT,  // Current # of HTTP2 streams to servers
+  HTTP2_STAT_TOTAL_SERVER_CONNECTION_COUNT,
+  HTTP2_STAT_TOTAL_SERVER_STREAM_COUNT,
 
   HTTP2_N_STATS // Terminal counter, NOT A STAT INDEX.
 };
@@ -379,6 +383,8 @@ public:
   static uint32_t push_diary_size;
   static uint32_t zombie_timeout_in;
   static float stream_error_rate_threshold;
+  static uint32_t enabled_out;
+  static uint32_t no_activity_timeout_out;
 
   static void init();
 };
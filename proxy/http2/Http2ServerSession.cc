@@ -0,0 +1,1172 @@
+/** @file
+
+  Http2ServerSession.cc
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "Http2ServerSession.h"
+#include "HttpConfig.h"
+#include "HttpSessionManager.h"
+
+#define Http2SsnDebug(fmt, ...) Debug("http2_ss", "[%" PRId64 "] " fmt, this->con_id, ##__VA_ARGS__)
+
+#define Http2StrmDebug(fmt, ...) \
+  Debug("http2_ss", "[%" PRId64 "] [%u] " fmt, _session ? _session->con_id : -1, this->_id, ##__VA_ARGS__)
+
+ClassAllocator<Http2ServerSession> http2ServerSessionAllocator("http2ServerSessionAllocator");
+ClassAllocator<Http2ServerStream> http2ServerStreamAllocator("http2ServerStreamAllocator");
+
+namespace
+{
+// Largest header block accepted across HEADERS and CONTINUATION frames.
+constexpr size_t MAX_HEADER_BLOCK_SIZE = HTTP2_MAX_BUFFER_USAGE;
+
+// Highest stream identifier a client can open.
+constexpr Http2StreamId MAX_STREAM_ID = 0x7FFFFFFF;
+} // namespace
+
+//
+// Http2ServerSession
+//
+
+void
+Http2ServerSession::new_connection(NetVConnection *new_vc, uint32_t max_streams)
+{
+  ink_assert(new_vc != nullptr);
+  server_vc = new_vc;
+  mutex     = new_ProxyMutex();
+  SET_HANDLER(&Http2ServerSession::main_event_handler);
+
+  read_buffer  = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+  reader       = read_buffer->alloc_reader();
+  write_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+  _encoder     = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
+  _decoder     = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
+
+  _local_initial_window_size    = Http2::initial_window_size;
+  _local_max_concurrent_streams = std::max(max_streams, 1U);
+  // Let the connection carry a full window on every stream the server may have open.
+  uint64_t window = static_cast<uint64_t>(_local_initial_window_size) * _local_max_concurrent_streams;
+  _recv_window = std::min<uint64_t>(window, HTTP2_MAX_WINDOW_SIZE);
+  _recv_window = std::max<uint32_t>(_recv_window, HTTP2_INITIAL_WINDOW_SIZE);
+
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT, this_ethread());
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_TOTAL_SERVER_CONNECTION_COUNT, this_ethread());
+  Http2SsnDebug("session born, netvc %p, max streams %u", server_vc, _local_max_concurrent_streams);
+
+  // [RFC 7540] 3.5. The client connection preface is followed by a SETTINGS frame.
+  write_buffer->write(HTTP2_CONNECTION_PREFACE, HTTP2_CONNECTION_PREFACE_LEN);
+
+  const Http2SettingsParameter params[] = {
+    {HTTP2_SETTINGS_ENABLE_PUSH, 0},
+    {HTTP2_SETTINGS_INITIAL_WINDOW_SIZE, _local_initial_window_size},
+    {HTTP2_SETTINGS_HEADER_TABLE_SIZE, Http2::header_table_size},
+    {HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, Http2::max_header_list_size},
+  };
+  uint8_t payload[countof(params) * HTTP2_SETTINGS_PARAMETER_LEN];
+  for (size_t i = 0; i < countof(params); ++i) {
+    http2_write_settings(params[i], make_iovec(payload + i * HTTP2_SETTINGS_PARAMETER_LEN, HTTP2_SETTINGS_PARAMETER_LEN));
+  }
+  send_frame(HTTP2_FRAME_TYPE_SETTINGS, 0, 0, payload, sizeof(payload));
+  if (_recv_window > HTTP2_INITIAL_WINDOW_SIZE) {
+    send_window_update(0, _recv_window - HTTP2_INITIAL_WINDOW_SIZE);
+  }
+
+  // The streams keep their own timeouts, the connection only times out when idle.
+  server_vc->cancel_active_timeout();
+  update_idle_timeout();
+
+  server_vc->do_io_read(this, INT64_MAX, read_buffer);
+  write_vio = server_vc->do_io_write(this, INT64_MAX, write_buffer->alloc_reader());
+}
+
+uint32_t
+Http2ServerSession::open_streams() const
+{
+  uint32_t n = 0;
+  for (Http2ServerStream *s = _streams.head; s; s = s->link.next) {
+    if (!s->is_closed()) {
+      ++n;
+    }
+  }
+  return n;
+}
+
+bool
+Http2ServerSession::is_available() const
+{
+  return !_closed && !_draining && _next_stream_id <= MAX_STREAM_ID &&
+         open_streams() < std::min(_peer_max_concurrent_streams, _local_max_concurrent_streams);
+}
+
+Http2ServerStream *
+Http2ServerSession::create_stream()
+{
+  if (!is_available()) {
+    return nullptr;
+  }
+
+  Http2ServerStream *stream = THREAD_ALLOC_INIT(http2ServerStreamAllocator, this_ethread());
+  stream->init(this, _next_stream_id);
+  _next_stream_id += 2;
+  _streams.push(stream);
+  update_idle_timeout();
+
+  Http2SsnDebug("stream %u opened, %u open", stream->get_id(), open_streams());
+  return stream;
+}
+
+void
+Http2ServerSession::stream_closed(Http2ServerStream *stream)
+{
+  if (!stream->is_closed()) {
+    send_rst_stream(stream->get_id(), Http2ErrorCode::HTTP2_ERROR_CANCEL);
+  }
+  _streams.remove(stream);
+  Http2SsnDebug("stream %u closed, %u open", stream->get_id(), open_streams());
+  update_idle_timeout();
+  close_if_done();
+}
+
+Http2ServerStream *
+Http2ServerSession::find_stream(Http2StreamId id)
+{
+  for (Http2ServerStream *s = _streams.head; s; s = s->link.next) {
+    if (s->get_id() == id) {
+      return s;
+    }
+  }
+  return nullptr;
+}
+
+void
+Http2ServerSession::update_idle_timeout()
+{
+  if (server_vc == nullptr) {
+    return;
+  }
+  if (_streams.empty()) {
+    server_vc->set_inactivity_timeout(HRTIME_SECONDS(Http2::no_activity_timeout_out));
+  } else {
+    server_vc->cancel_inactivity_timeout();
+  }
+}
+
+void
+Http2ServerSession::drain()
+{
+  _draining = true;
+  if (pool) {
+    SCOPED_MUTEX_LOCK(lock, pool->mutex, this_ethread());
+    pool->removeHttp2Session(this);
+    pool = nullptr;
+  }
+  close_if_done();
+}
+
+void
+Http2ServerSession::close_if_done()
+{
+  if (!_closed && _streams.empty() && (_draining || pool == nullptr)) {
+    if (_recursion > 0) {
+      _close_pending = true;
+    } else {
+      destroy();
+    }
+  }
+}
+
+int
+Http2ServerSession::main_event_handler(int event, void *edata)
+{
+  Http2ErrorCode error = Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+
+  ++_recursion;
+  switch (event) {
+  case VC_EVENT_READ_READY:
+  case VC_EVENT_READ_COMPLETE:
+    error = process_frames();
+    if (error != Http2ErrorCode::HTTP2_ERROR_NO_ERROR) {
+      HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CONNECTION_ERRORS_COUNT, this_ethread());
+      send_goaway(error);
+      _close_pending = true;
+    } else if (!_close_pending) {
+      static_cast<VIO *>(edata)->reenable();
+    }
+    break;
+
+  case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE:
+    break;
+
+  case VC_EVENT_EOS:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+  case VC_EVENT_ACTIVE_TIMEOUT:
+  default:
+    Http2SsnDebug("closing on %s with %u open streams", get_vc_event_name(event), open_streams());
+    _close_pending = true;
+    break;
+  }
+  --_recursion;
+
+  if (_close_pending && _recursion == 0) {
+    destroy();
+  }
+  return 0;
+}
+
+Http2ErrorCode
+Http2ServerSession::process_frames()
+{
+  uint8_t payload[HTTP2_MAX_FRAME_SIZE];
+
+  while (!_close_pending && reader->read_avail() >= static_cast<int64_t>(HTTP2_FRAME_HEADER_LEN)) {
+    uint8_t buf[HTTP2_FRAME_HEADER_LEN];
+    Http2FrameHeader hdr;
+
+    reader->memcpy(buf, sizeof(buf));
+    http2_parse_frame_header(make_iovec(buf), hdr);
+    // The default maximum frame size is the one advertised to the server.
+    if (hdr.length > HTTP2_MAX_FRAME_SIZE) {
+      return Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+    }
+    if (reader->read_avail() < static_cast<int64_t>(HTTP2_FRAME_HEADER_LEN + hdr.length)) {
+      break;
+    }
+    reader->consume(HTTP2_FRAME_HEADER_LEN);
+    reader->read(payload, hdr.length);
+
+    if (Http2ErrorCode error = receive_frame(hdr, payload); error != Http2ErrorCode::HTTP2_ERROR_NO_ERROR) {
+      Http2SsnDebug("connection error %u on frame type %u", static_cast<unsigned>(error), hdr.type);
+      return error;
+    }
+  }
+  return Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+}
+
+Http2ErrorCode
+Http2ServerSession::receive_frame(const Http2FrameHeader &hdr, const uint8_t *payload)
+{
+  // [RFC 7540] 6.10. A header block must be continued without anything in between.
+  if (_continued_stream_id != 0 && (hdr.type != HTTP2_FRAME_TYPE_CONTINUATION || hdr.streamid != _continued_stream_id)) {
+    return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+  }
+
+  switch (hdr.type) {
+  case HTTP2_FRAME_TYPE_DATA: {
+    uint32_t pad = 0;
+    if (hdr.streamid == 0 || hdr.streamid >= _next_stream_id) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+    if (hdr.flags & HTTP2_FLAGS_DATA_PADDED) {
+      if (hdr.length == 0 || payload[0] >= hdr.length) {
+        return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+      }
+      pad = payload[0] + HTTP2_DATA_PADLEN_LEN;
+    }
+
+    // [RFC 7540] 6.9.1. A frame past the window the server was given is an error.
+    if (hdr.length > _recv_window - _recv_unacked) {
+      return Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR;
+    }
+
+    // Connection level flow control is returned as soon as the frame is read, the stream windows
+    // bound how much the server can send ahead of the state machines.
+    _recv_unacked += hdr.length;
+    if (_recv_unacked >= _recv_window / 2) {
+      send_window_update(0, _recv_unacked);
+      _recv_unacked = 0;
+    }
+
+    if (Http2ServerStream *stream = find_stream(hdr.streamid); stream) {
+      if (!stream->recv_window_allows(hdr.length)) {
+        Http2SsnDebug("stream %u sent past its window", hdr.streamid);
+        send_rst_stream(hdr.streamid, Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR);
+        stream->receive_rst_stream(Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR);
+        break;
+      }
+      if (pad > 0) {
+        send_window_update(hdr.streamid, pad);
+      }
+      stream->receive_data(payload + (pad ? HTTP2_DATA_PADLEN_LEN : 0), hdr.length - pad,
+                           hdr.flags & HTTP2_FLAGS_DATA_END_STREAM);
+    }
+    break;
+  }
+
+  case HTTP2_FRAME_TYPE_HEADERS: {
+    uint32_t offset = 0;
+    uint32_t pad    = 0;
+    if (hdr.streamid == 0) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+    if (hdr.flags & HTTP2_FLAGS_HEADERS_PADDED) {
+      if (hdr.length == 0) {
+        return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+      }
+      pad    = payload[0];
+      offset = HTTP2_HEADERS_PADLEN_LEN;
+    }
+    if (hdr.flags & HTTP2_FLAGS_HEADERS_PRIORITY) {
+      offset += HTTP2_PRIORITY_LEN;
+    }
+    if (offset + pad > hdr.length) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+
+    _header_block_len = hdr.length - offset - pad;
+    _header_block     = static_cast<uint8_t *>(ats_malloc(_header_block_len));
+    memcpy(_header_block, payload + offset, _header_block_len);
+    if (hdr.flags & HTTP2_FLAGS_HEADERS_END_HEADERS) {
+      return receive_header_block(hdr.streamid, hdr.flags & HTTP2_FLAGS_HEADERS_END_STREAM);
+    }
+    _continued_stream_id  = hdr.streamid;
+    _continued_end_stream = hdr.flags & HTTP2_FLAGS_HEADERS_END_STREAM;
+    break;
+  }
+
+  case HTTP2_FRAME_TYPE_CONTINUATION:
+    if (_continued_stream_id == 0) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+    if (_header_block_len + hdr.length > MAX_HEADER_BLOCK_SIZE) {
+      return Http2ErrorCode::HTTP2_ERROR_ENHANCE_YOUR_CALM;
+    }
+    _header_block = static_cast<uint8_t *>(ats_realloc(_header_block, _header_block_len + hdr.length));
+    memcpy(_header_block + _header_block_len, payload, hdr.length);
+    _header_block_len += hdr.length;
+    if (hdr.flags & HTTP2_FLAGS_CONTINUATION_END_HEADERS) {
+      Http2StreamId id     = _continued_stream_id;
+      _continued_stream_id = 0;
+      return receive_header_block(id, _continued_end_stream);
+    }
+    break;
+
+  case HTTP2_FRAME_TYPE_RST_STREAM: {
+    Http2RstStream rst;
+    if (hdr.length != HTTP2_RST_STREAM_LEN) {
+      return Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+    }
+    if (hdr.streamid == 0 || hdr.streamid >= _next_stream_id) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+    http2_parse_rst_stream(make_iovec(const_cast<uint8_t *>(payload), hdr.length), rst);
+    if (Http2ServerStream *stream = find_stream(hdr.streamid); stream) {
+      stream->receive_rst_stream(static_cast<Http2ErrorCode>(rst.error_code));
+    }
+    break;
+  }
+
+  case HTTP2_FRAME_TYPE_SETTINGS:
+    return receive_settings(hdr, payload);
+
+  case HTTP2_FRAME_TYPE_PUSH_PROMISE:
+    // Push was disabled in our SETTINGS.
+    return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+
+  case HTTP2_FRAME_TYPE_PING:
+    if (hdr.streamid != 0) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+    if (hdr.length != HTTP2_PING_LEN) {
+      return Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+    }
+    if (!(hdr.flags & HTTP2_FLAGS_PING_ACK)) {
+      send_frame(HTTP2_FRAME_TYPE_PING, HTTP2_FLAGS_PING_ACK, 0, payload, HTTP2_PING_LEN);
+    }
+    break;
+
+  case HTTP2_FRAME_TYPE_GOAWAY:
+    return receive_goaway(hdr, payload);
+
+  case HTTP2_FRAME_TYPE_WINDOW_UPDATE:
+    return receive_window_update(hdr, payload);
+
+  default:
+    // PRIORITY is advisory and unknown frame types are ignored.
+    break;
+  }
+
+  return Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+}
+
+Http2ErrorCode
+Http2ServerSession::receive_header_block(Http2StreamId id, bool end_stream)
+{
+  HTTPHdr hdr;
+  hdr.create(HTTP_TYPE_RESPONSE);
+
+  // The block is decoded even for a stream that is gone, to keep the decoder table in step.
+  int64_t result = hpack_decode_header_block(*_decoder, &hdr, _header_block, _header_block_len, Http2::max_header_list_size,
+                                             Http2::header_table_size);
+  ats_free(_header_block);
+  _header_block     = nullptr;
+  _header_block_len = 0;
+  if (result < 0) {
+    hdr.destroy();
+    return result == HPACK_ERROR_SIZE_EXCEEDED_ERROR ? Http2ErrorCode::HTTP2_ERROR_ENHANCE_YOUR_CALM :
+                                                       Http2ErrorCode::HTTP2_ERROR_COMPRESSION_ERROR;
+  }
+  if (id >= _next_stream_id) {
+    hdr.destroy();
+    return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+  }
+
+  if (Http2ServerStream *stream = find_stream(id); stream) {
+    stream->receive_headers(hdr, end_stream);
+  }
+  hdr.destroy();
+  return Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+}
+
+Http2ErrorCode
+Http2ServerSession::receive_settings(const Http2FrameHeader &hdr, const uint8_t *payload)
+{
+  if (hdr.streamid != 0) {
+    return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+  }
+  if (hdr.flags & HTTP2_FLAGS_SETTINGS_ACK) {
+    return hdr.length == 0 ? Http2ErrorCode::HTTP2_ERROR_NO_ERROR : Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+  }
+  if (hdr.length % HTTP2_SETTINGS_PARAMETER_LEN != 0) {
+    return Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+  }
+
+  for (uint32_t i = 0; i < hdr.length; i += HTTP2_SETTINGS_PARAMETER_LEN) {
+    Http2SettingsParameter param;
+    http2_parse_settings_parameter(make_iovec(const_cast<uint8_t *>(payload) + i, HTTP2_SETTINGS_PARAMETER_LEN), param);
+    if (!http2_settings_parameter_is_valid(param)) {
+      return param.id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE ? Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR :
+                                                              Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+
+    switch (param.id) {
+    case HTTP2_SETTINGS_HEADER_TABLE_SIZE:
+      _peer_header_table_size = param.value;
+      break;
+    case HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS:
+      _peer_max_concurrent_streams = param.value;
+      break;
+    case HTTP2_SETTINGS_INITIAL_WINDOW_SIZE: {
+      // [RFC 7540] 6.9.2. A change applies to the windows of all open streams.
+      Http2WindowSize delta     = static_cast<Http2WindowSize>(param.value) - _peer_initial_window_size;
+      _peer_initial_window_size = param.value;
+      for (Http2ServerStream *s = _streams.head; s; s = s->link.next) {
+        s->update_send_window(delta);
+      }
+      break;
+    }
+    case HTTP2_SETTINGS_MAX_FRAME_SIZE:
+      _peer_max_frame_size = param.value;
+      break;
+    default:
+      break;
+    }
+  }
+
+  send_frame(HTTP2_FRAME_TYPE_SETTINGS, HTTP2_FLAGS_SETTINGS_ACK, 0, nullptr, 0);
+  Http2SsnDebug("server settings: max streams %u, initial window %d, max frame %u", _peer_max_concurrent_streams,
+                _peer_initial_window_size, _peer_max_frame_size);
+  return Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+}
+
+Http2ErrorCode
+Http2ServerSession::receive_goaway(const Http2FrameHeader &hdr, const uint8_t *payload)
+{
+  Http2Goaway goaway;
+
+  if (hdr.streamid != 0) {
+    return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+  }
+  if (hdr.length < HTTP2_GOAWAY_LEN) {
+    return Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+  }
+  http2_parse_goaway(make_iovec(const_cast<uint8_t *>(payload), hdr.length), goaway);
+  Http2SsnDebug("received GOAWAY, last stream %u, error %u", goaway.last_streamid, static_cast<unsigned>(goaway.error_code));
+
+  // Streams after the last one were not processed, so they can be retried elsewhere.
+  for (Http2ServerStream *s = _streams.head; s; s = s->link.next) {
+    if (s->get_id() > goaway.last_streamid) {
+      s->receive_rst_stream(Http2ErrorCode::HTTP2_ERROR_REFUSED_STREAM);
+    }
+  }
+  drain();
+  return Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+}
+
+Http2ErrorCode
+Http2ServerSession::receive_window_update(const Http2FrameHeader &hdr, const uint8_t *payload)
+{
+  uint32_t size;
+
+  if (hdr.length != HTTP2_WINDOW_UPDATE_LEN) {
+    return Http2ErrorCode::HTTP2_ERROR_FRAME_SIZE_ERROR;
+  }
+  http2_parse_window_update(make_iovec(const_cast<uint8_t *>(payload), hdr.length), size);
+
+  if (hdr.streamid == 0) {
+    if (size == 0) {
+      return Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+    if (size > static_cast<uint32_t>(HTTP2_MAX_WINDOW_SIZE - _send_window)) {
+      return Http2ErrorCode::HTTP2_ERROR_FLOW_CONTROL_ERROR;
+    }
+    _send_window += size;
+    // Any stream may have been waiting on the connection window.
+    for (Http2ServerStream *s = _streams.head; s; s = s->link.next) {
+      s->update_send_window(0);
+    }
+  } else if (Http2ServerStream *stream = find_stream(hdr.streamid); stream) {
+    if (size == 0) {
+      send_rst_stream(hdr.streamid, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR);
+      stream->receive_rst_stream(Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR);
+    } else {
+      stream->update_send_window(size);
+    }
+  }
+  return Http2ErrorCode::HTTP2_ERROR_NO_ERROR;
+}
+
+void
+Http2ServerSession::send_frame(Http2FrameType type, uint8_t flags, Http2StreamId id, const uint8_t *payload, uint32_t len)
+{
+  uint8_t buf[HTTP2_FRAME_HEADER_LEN];
+
+  if (write_buffer == nullptr) {
+    return;
+  }
+  http2_write_frame_header({len, static_cast<uint8_t>(type), flags, id}, make_iovec(buf));
+  write_buffer->write(buf, sizeof(buf));
+  if (len > 0) {
+    write_buffer->write(payload, len);
+  }
+  if (write_vio) {
+    write_vio->reenable();
+  }
+}
+
+bool
+Http2ServerSession::send_headers(Http2ServerStream *stream, HTTPHdr *hdr, bool end_stream)
+{
+  uint32_t buf_len = hdr->length_get() * 2; // Make it double just in case
+  uint8_t *buf     = static_cast<uint8_t *>(ats_malloc(buf_len));
+  uint32_t len     = 0;
+
+  if (http2_encode_header_blocks(hdr, buf, buf_len, &len, *_encoder, _peer_header_table_size) !=
+      Http2ErrorCode::HTTP2_ERROR_NO_ERROR) {
+    ats_free(buf);
+    return false;
+  }
+
+  // [RFC 7540] 6.2. A block larger than a frame continues in CONTINUATION frames.
+  uint32_t sent = std::min(len, _peer_max_frame_size);
+  uint8_t flags = (end_stream ? HTTP2_FLAGS_HEADERS_END_STREAM : 0) | (sent == len ? HTTP2_FLAGS_HEADERS_END_HEADERS : 0);
+  send_frame(HTTP2_FRAME_TYPE_HEADERS, flags, stream->get_id(), buf, sent);
+  while (sent < len) {
+    uint32_t n = std::min(len - sent, _peer_max_frame_size);
+    send_frame(HTTP2_FRAME_TYPE_CONTINUATION, sent + n == len ? HTTP2_FLAGS_CONTINUATION_END_HEADERS : 0, stream->get_id(),
+               buf + sent, n);
+    sent += n;
+  }
+  ats_free(buf);
+  return true;
+}
+
+int64_t
+Http2ServerSession::send_data(Http2ServerStream *stream, IOBufferReader *data, int64_t len, bool end_stream)
+{
+  int64_t sent = 0;
+
+  if (len == 0) {
+    if (end_stream) {
+      send_frame(HTTP2_FRAME_TYPE_DATA, HTTP2_FLAGS_DATA_END_STREAM, stream->get_id(), nullptr, 0);
+    }
+    return 0;
+  }
+
+  while (sent < len && _send_window > 0) {
+    uint32_t n = std::min<int64_t>({len - sent, _send_window, _peer_max_frame_size});
+    bool last  = end_stream && sent + n == len;
+    uint8_t buf[HTTP2_FRAME_HEADER_LEN];
+
+    http2_write_frame_header({n, HTTP2_FRAME_TYPE_DATA, static_cast<uint8_t>(last ? HTTP2_FLAGS_DATA_END_STREAM : 0),
+                              stream->get_id()},
+                             make_iovec(buf));
+    write_buffer->write(buf, sizeof(buf));
+    write_buffer->write(data, n);
+    data->consume(n);
+    _send_window -= n;
+    sent += n;
+  }
+  if (sent > 0 && write_vio) {
+    write_vio->reenable();
+  }
+  return sent;
+}
+
+void
+Http2ServerSession::send_window_update(Http2StreamId id, uint32_t size)
+{
+  uint8_t payload[HTTP2_WINDOW_UPDATE_LEN];
+  http2_write_window_update(size, make_iovec(payload));
+  send_frame(HTTP2_FRAME_TYPE_WINDOW_UPDATE, 0, id, payload, sizeof(payload));
+}
+
+void
+Http2ServerSession::send_rst_stream(Http2StreamId id, Http2ErrorCode code)
+{
+  uint8_t payload[HTTP2_RST_STREAM_LEN];
+  http2_write_rst_stream(static_cast<uint32_t>(code), make_iovec(payload));
+  send_frame(HTTP2_FRAME_TYPE_RST_STREAM, 0, id, payload, sizeof(payload));
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_STREAM_ERRORS_COUNT, this_ethread());
+}
+
+void
+Http2ServerSession::send_goaway(Http2ErrorCode code)
+{
+  Http2Goaway goaway;
+  uint8_t payload[HTTP2_GOAWAY_LEN];
+
+  // The server cannot open streams, so there is no last stream to report.
+  goaway.last_streamid = 0;
+  goaway.error_code    = code;
+  http2_write_goaway(goaway, make_iovec(payload));
+  send_frame(HTTP2_FRAME_TYPE_GOAWAY, 0, 0, payload, sizeof(payload));
+}
+
+void
+Http2ServerSession::destroy()
+{
+  if (_closed) {
+    return;
+  }
+  _closed = true;
+  Http2SsnDebug("session closed, %u streams left", open_streams());
+
+  if (pool) {
+    SCOPED_MUTEX_LOCK(lock, pool->mutex, this_ethread());
+    pool->removeHttp2Session(this);
+    pool = nullptr;
+  }
+
+  while (Http2ServerStream *stream = _streams.pop()) {
+    stream->session_closed();
+  }
+
+  HTTP2_DECREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_SESSION_COUNT, this_ethread());
+  HTTP_SUM_GLOBAL_DYN_STAT(http_current_server_connections_stat, -1);
+  if (to_parent_proxy) {
+    HTTP_DECREMENT_DYN_STAT(http_current_parent_proxy_connections_stat);
+  }
+  if (conn_track_group) {
+    if (conn_track_group->_count >= 0) {
+      (conn_track_group->_count)--;
+    } else {
+      Error("[http2_ss] [%" PRId64 "] number of connections should be greater than or equal to zero: %u", con_id,
+            conn_track_group->_count.load());
+    }
+    conn_track_group = nullptr;
+  }
+
+  if (server_vc) {
+    server_vc->do_io_close();
+    server_vc = nullptr;
+  }
+  write_vio = nullptr;
+  free_MIOBuffer(read_buffer);
+  free_MIOBuffer(write_buffer);
+  read_buffer  = nullptr;
+  write_buffer = nullptr;
+  delete _encoder;
+  delete _decoder;
+  _encoder = nullptr;
+  _decoder = nullptr;
+  ats_free(_header_block);
+  _header_block = nullptr;
+
+  mutex.clear();
+  THREAD_FREE(this, http2ServerSessionAllocator, this_ethread());
+}
+
+//
+// Http2ServerStream
+//
+
+void
+Http2ServerStream::init(Http2ServerSession *session, Http2StreamId id)
+{
+  _session = session;
+  _id      = id;
+  mutex    = session->mutex;
+  SET_HANDLER(&Http2ServerStream::main_event_handler);
+
+  _send_window     = session->peer_initial_window_size();
+  _response_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_8K);
+  _response_reader = _response_buffer->alloc_reader();
+  _request_header.create(HTTP_TYPE_REQUEST);
+  http_parser_init(&_parser);
+
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT, this_ethread());
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_TOTAL_SERVER_STREAM_COUNT, this_ethread());
+}
+
+VIO *
+Http2ServerStream::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+
+  if (buf) {
+    _read_vio.buffer.writer_for(buf);
+  } else {
+    _read_vio.buffer.clear();
+  }
+  _read_vio.mutex     = c ? c->mutex : mutex;
+  _read_vio.cont      = c;
+  _read_vio.nbytes    = nbytes;
+  _read_vio.ndone     = 0;
+  _read_vio.vc_server = this;
+  _read_vio.op        = VIO::READ;
+
+  if (nbytes > 0) {
+    deliver_response();
+  }
+  return &_read_vio;
+}
+
+VIO *
+Http2ServerStream::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *abuffer, bool /* owner ATS_UNUSED */)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+
+  if (abuffer) {
+    _write_vio.buffer.reader_for(abuffer);
+  } else {
+    _write_vio.buffer.clear();
+  }
+  _write_vio.mutex     = c ? c->mutex : mutex;
+  _write_vio.cont      = c;
+  _write_vio.nbytes    = nbytes;
+  _write_vio.ndone     = 0;
+  _write_vio.vc_server = this;
+  _write_vio.op        = VIO::WRITE;
+
+  if (nbytes > 0) {
+    send_request();
+  }
+  return &_write_vio;
+}
+
+void
+Http2ServerStream::reenable(VIO *vio)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+
+  if (vio == &_write_vio) {
+    send_request();
+  } else if (vio == &_read_vio) {
+    deliver_response();
+  }
+}
+
+void
+Http2ServerStream::do_io_shutdown(ShutdownHowTo_t howto)
+{
+  // Half closes have no use on a stream, the state machine closes it when it is done.
+  Http2StrmDebug("ignoring shutdown %d", howto);
+}
+
+void
+Http2ServerStream::do_io_close(int /* lerrno ATS_UNUSED */)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+  Http2StrmDebug("stream closed by the state machine");
+
+  clear_timers();
+  if (_read_event) {
+    _read_event->cancel();
+    _read_event = nullptr;
+  }
+  if (_write_event) {
+    _write_event->cancel();
+    _write_event = nullptr;
+  }
+  _read_vio.buffer.clear();
+  _read_vio.mutex.clear();
+  _read_vio.cont = nullptr;
+  _write_vio.buffer.clear();
+  _write_vio.mutex.clear();
+  _write_vio.cont = nullptr;
+
+  if (_session) {
+    _session->stream_closed(this);
+    _session = nullptr;
+  }
+
+  _request_header.destroy();
+  http_parser_clear(&_parser);
+  free_MIOBuffer(_response_buffer);
+  _response_buffer = nullptr;
+  _response_reader = nullptr;
+  HTTP2_DECREMENT_THREAD_DYN_STAT(HTTP2_STAT_CURRENT_SERVER_STREAM_COUNT, this_ethread());
+
+  mutex.clear();
+  THREAD_FREE(this, http2ServerStreamAllocator, this_ethread());
+}
+
+void
+Http2ServerStream::send_request()
+{
+  IOBufferReader *reader = _write_vio.get_reader();
+  int64_t before         = _write_vio.ndone;
+
+  if (_session == nullptr || _reset || _request_done || reader == nullptr || _write_vio.ntodo() <= 0) {
+    return;
+  }
+
+  if (!_headers_sent) {
+    int bytes_used = 0;
+    ParseResult result = _request_header.parse_req(&_parser, reader, &bytes_used, false);
+
+    _write_vio.ndone += bytes_used;
+    if (result == PARSE_RESULT_ERROR || _request_header.presence(MIME_PRESENCE_TRANSFER_ENCODING)) {
+      Http2StrmDebug("request header can not be sent on HTTP/2");
+      fail(VC_EVENT_ERROR);
+      return;
+    }
+    if (result == PARSE_RESULT_DONE) {
+      HTTPHdr h2_hdr;
+
+      // The state machine sends the request in origin form unless it goes to a parent, and HTTP/2 is
+      // only negotiated under TLS.
+      if (int len = 0; _request_header.url_get()->scheme_get(&len) == nullptr || len == 0) {
+        _request_header.url_get()->scheme_set(URL_SCHEME_HTTPS, URL_LEN_HTTPS);
+      }
+      _request_body_left = std::max<int64_t>(_request_header.get_content_length(), 0);
+
+      http2_generate_h2_header_from_1_1(&_request_header, &h2_hdr);
+      bool sent = _session->send_headers(this, &h2_hdr, _request_body_left == 0);
+      h2_hdr.destroy();
+      if (!sent) {
+        fail(VC_EVENT_ERROR);
+        return;
+      }
+      _headers_sent = true;
+      _request_done = _request_body_left == 0;
+      Http2StrmDebug("sent request header, %" PRId64 " body bytes to follow", _request_body_left);
+    }
+  }
+
+  if (_headers_sent && _request_body_left > 0) {
+    int64_t len = std::min({reader->read_avail(), _write_vio.ntodo(), _request_body_left, static_cast<int64_t>(_send_window)});
+    if (len > 0) {
+      int64_t sent = _session->send_data(this, reader, len, len == _request_body_left);
+      _send_window -= sent;
+      _request_body_left -= sent;
+      _write_vio.ndone += sent;
+      _request_done = _request_body_left == 0;
+    }
+  }
+
+  if (_write_vio.ndone != before) {
+    if (_inactive_timeout > 0) {
+      _inactive_timeout_at = Thread::get_hrtime() + _inactive_timeout;
+    }
+    signal(_write_vio.ntodo() == 0 ? VC_EVENT_WRITE_COMPLETE : VC_EVENT_WRITE_READY, &_write_vio);
+  }
+}
+
+void
+Http2ServerStream::receive_headers(HTTPHdr &hdr, bool end_stream)
+{
+  if (_reset) {
+    return;
+  }
+
+  if (_final_response) {
+    // Trailers have no place in the HTTP/1.1 form of the response.
+    if (end_stream) {
+      _response_done = true;
+      deliver_response();
+    }
+    return;
+  }
+
+  if (http2_convert_header_from_2_to_1_1(&hdr) != PARSE_RESULT_DONE) {
+    Http2StrmDebug("malformed response header");
+    _session->send_rst_stream(_id, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR);
+    fail(VC_EVENT_ERROR);
+    return;
+  }
+
+  HTTPStatus status  = hdr.status_get();
+  const char *reason = http_hdr_reason_lookup(status);
+  hdr.version_set(HTTPVersion(1, 1));
+  hdr.reason_set(reason, strlen(reason));
+  _final_response = status >= HTTP_STATUS_OK;
+  // A response that ends with its header has no body. Say so, rather than leave the state machine to
+  // read until the stream closes.
+  if (_final_response && end_stream && !hdr.presence(MIME_PRESENCE_CONTENT_LENGTH) && status != HTTP_STATUS_NO_CONTENT &&
+      status != HTTP_STATUS_NOT_MODIFIED) {
+    hdr.value_set_int64(MIME_FIELD_CONTENT_LENGTH, MIME_LEN_CONTENT_LENGTH, 0);
+  }
+
+  // Print the header into the response buffer, as Http2Stream does for requests.
+  int bufindex;
+  int dumpoffset = 0;
+  int done, tmp;
+  IOBufferBlock *block;
+  do {
+    bufindex = 0;
+    tmp      = dumpoffset;
+    block    = _response_buffer->get_current_block();
+    if (!block) {
+      _response_buffer->add_block();
+      block = _response_buffer->get_current_block();
+    }
+    done = hdr.print(block->end(), block->write_avail(), &bufindex, &tmp);
+    dumpoffset += bufindex;
+    _response_buffer->fill(bufindex);
+    if (!done) {
+      _response_buffer->add_block();
+    }
+  } while (!done);
+
+  Http2StrmDebug("received response header, status %d", status);
+  if (end_stream) {
+    _response_done = true;
+  }
+  deliver_response();
+}
+
+void
+Http2ServerStream::receive_data(const uint8_t *data, uint32_t len, bool end_stream)
+{
+  if (_reset) {
+    return;
+  }
+  if (!_final_response) {
+    _session->send_rst_stream(_id, Http2ErrorCode::HTTP2_ERROR_PROTOCOL_ERROR);
+    fail(VC_EVENT_ERROR);
+    return;
+  }
+
+  _recv_unacked += len;
+  _response_buffer->write(data, len);
+  if (end_stream) {
+    _response_done = true;
+  }
+  deliver_response();
+}
+
+bool
+Http2ServerStream::recv_window_allows(uint32_t len) const
+{
+  // Padding is returned as soon as it is received, so only the payload not yet returned uses the window.
+  uint32_t window = _session ? _session->local_initial_window_size() : 0;
+  return !_reset && _recv_unacked <= window && len <= window - _recv_unacked;
+}
+
+void
+Http2ServerStream::deliver_response()
+{
+  MIOBuffer *writer = _read_vio.get_writer();
+  int64_t moved     = 0;
+
+  if (_read_vio.op != VIO::READ || _read_vio.cont == nullptr || writer == nullptr || _response_reader == nullptr) {
+    return;
+  }
+
+  moved = std::min(_response_reader->read_avail(), _read_vio.ntodo());
+  if (moved > 0) {
+    writer->write(_response_reader, moved);
+    _response_reader->consume(moved);
+    _read_vio.ndone += moved;
+    if (_inactive_timeout > 0) {
+      _inactive_timeout_at = Thread::get_hrtime() + _inactive_timeout;
+    }
+  }
+
+  // Return stream window for what the state machine has taken, once it is worth a frame.
+  if (_session && !_reset && !_response_done) {
+    int64_t pending = _response_reader->read_avail();
+    uint32_t taken  = _recv_unacked > pending ? _recv_unacked - pending : 0;
+    if (taken > 0 && taken >= _session->local_initial_window_size() / 2) {
+      _session->send_window_update(_id, taken);
+      _recv_unacked -= taken;
+    }
+  }
+
+  if (_read_vio.ntodo() == 0) {
+    if (moved > 0) {
+      signal(VC_EVENT_READ_COMPLETE, &_read_vio);
+    }
+  } else if (_response_done && _response_reader->read_avail() == 0) {
+    signal(VC_EVENT_EOS, &_read_vio);
+  } else if (moved > 0) {
+    signal(VC_EVENT_READ_READY, &_read_vio);
+  }
+}
+
+void
+Http2ServerStream::receive_rst_stream(Http2ErrorCode code)
+{
+  Http2StrmDebug("reset, error %u", static_cast<unsigned>(code));
+  if (_response_done) {
+    // [RFC 7540] 8.1. The server can stop the request body once it has sent the whole response.
+    _request_done = true;
+    return;
+  }
+  fail(VC_EVENT_ERROR);
+}
+
+void
+Http2ServerStream::update_send_window(Http2WindowSize delta)
+{
+  _send_window += delta;
+  if (delta >= 0) {
+    send_request();
+  }
+}
+
+void
+Http2ServerStream::session_closed()
+{
+  _session = nullptr;
+  if (!_response_done) {
+    fail(VC_EVENT_ERROR);
+  }
+}
+
+void
+Http2ServerStream::fail(int event)
+{
+  _reset = true;
+  if (_read_vio.cont && _read_vio.ntodo() > 0) {
+    signal(event, &_read_vio);
+  } else if (_write_vio.cont && _write_vio.ntodo() > 0) {
+    signal(event, &_write_vio);
+  }
+}
+
+void
+Http2ServerStream::signal(int event, VIO *vio)
+{
+  Event *&e = vio == &_read_vio ? _read_event : _write_event;
+
+  // Replace a pending event only if it is a different one.
+  if (e != nullptr && e->callback_event != event) {
+    e->cancel();
+    e = nullptr;
+  }
+  if (e == nullptr) {
+    e = this_ethread()->schedule_imm(this, event, vio);
+  }
+}
+
+int
+Http2ServerStream::main_event_handler(int event, void *edata)
+{
+  Event *e = static_cast<Event *>(edata);
+  VIO *vio = static_cast<VIO *>(e->cookie);
+
+  if (e == _read_event) {
+    _read_event = nullptr;
+  } else if (e == _write_event) {
+    _write_event = nullptr;
+  } else if (e == _active_event) {
+    _active_event = nullptr;
+    event         = VC_EVENT_ACTIVE_TIMEOUT;
+  } else if (e == _inactive_event) {
+    if (_inactive_timeout_at == 0 || Thread::get_hrtime() < _inactive_timeout_at) {
+      return 0;
+    }
+    clear_timers();
+    event = VC_EVENT_INACTIVITY_TIMEOUT;
+  }
+
+  if (event == VC_EVENT_ACTIVE_TIMEOUT || event == VC_EVENT_INACTIVITY_TIMEOUT) {
+    vio = _read_vio.cont && _read_vio.ntodo() > 0 ? &_read_vio : &_write_vio;
+  }
+  if (vio == nullptr || vio->cont == nullptr || vio->mutex == nullptr) {
+    return 0;
+  }
+
+  // The handler may close the stream, so nothing here can be touched after it. On a lock miss
+  // retry through the stream so the event is still cancelled if the stream is closed first.
+  MUTEX_TRY_LOCK(lock, vio->mutex, this_ethread());
+  if (lock.is_locked()) {
+    vio->cont->handleEvent(event, vio);
+  } else {
+    signal(event, vio);
+  }
+  return 0;
+}
+
+void
+Http2ServerStream::set_active_timeout(ink_hrtime timeout_in)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+
+  _active_timeout = timeout_in;
+  if (_active_event) {
+    _active_event->cancel();
+    _active_event = nullptr;
+  }
+  if (_active_timeout > 0) {
+    _active_event = this_ethread()->schedule_in(this, _active_timeout);
+  }
+}
+
+void
+Http2ServerStream::set_inactivity_timeout(ink_hrtime timeout_in)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+
+  _inactive_timeout = timeout_in;
+  if (_inactive_timeout > 0) {
+    _inactive_timeout_at = Thread::get_hrtime() + _inactive_timeout;
+    if (!_inactive_event) {
+      _inactive_event = this_ethread()->schedule_every(this, HRTIME_SECONDS(1));
+    }
+  } else {
+    _inactive_timeout_at = 0;
+    if (_inactive_event) {
+      _inactive_event->cancel();
+      _inactive_event = nullptr;
+    }
+  }
+}
+
+void
+Http2ServerStream::clear_timers()
+{
+  _inactive_timeout_at = 0;
+  if (_inactive_event) {
+    _inactive_event->cancel();
+    _inactive_event = nullptr;
+  }
+  if (_active_event) {
+    _active_event->cancel();
+    _active_event = nullptr;
+  }
+}
@@ -0,0 +1,371 @@
+/** @file
+
+  Http2ServerSession.h
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "P_Net.h"
+#include "HTTP2.h"
+#include "HPACK.h"
+#include "HTTP.h"
+#include "HttpConnectionCount.h"
+#include "tscore/CryptoHash.h"
+#include "tscore/List.h"
+
+class Http2ServerSession;
+class ServerSessionPool;
+
+/// Protocols offered by ALPN on an outbound connection that may use HTTP/2, in wire format.
+constexpr std::string_view HTTP2_OUTBOUND_ALPN_PROTOCOLS{"\x02h2\x08http/1.1", 12};
+
+/** A single exchange on an outbound HTTP/2 connection.
+
+    The state machine drives this just as it does a connection to an HTTP/1.1 server. It writes the
+    request in HTTP/1.1 form and reads the response back in HTTP/1.1 form. The request header is sent
+    as a HEADERS frame and the body as DATA frames. The response HEADERS are printed as an HTTP/1.1
+    header ahead of the DATA payloads, and the end of the response stream is reported as the end of
+    the read.
+
+    Requests with a chunked body are not sent on HTTP/2, so the end of the request is known from its
+    Content-Length.
+*/
+class Http2ServerStream : public VConnection
+{
+  using self_type  = Http2ServerStream;
+  using super_type = VConnection;
+
+public:
+  Http2ServerStream() : super_type(nullptr) {}
+  Http2ServerStream(self_type const &) = delete;
+  self_type &operator=(self_type const &) = delete;
+
+  void init(Http2ServerSession *session, Http2StreamId id);
+
+  VIO *do_io_read(Continuation *c, int64_t nbytes = INT64_MAX, MIOBuffer *buf = nullptr) override;
+  VIO *do_io_write(Continuation *c = nullptr, int64_t nbytes = INT64_MAX, IOBufferReader *buf = nullptr,
+                   bool owner = false) override;
+  void do_io_close(int lerrno = -1) override;
+  void do_io_shutdown(ShutdownHowTo_t howto) override;
+  void reenable(VIO *vio) override;
+
+  void set_active_timeout(ink_hrtime timeout_in);
+  void set_inactivity_timeout(ink_hrtime timeout_in);
+
+  Http2StreamId
+  get_id() const
+  {
+    return _id;
+  }
+
+  /// Has the stream finished in both directions, or been reset?
+  bool
+  is_closed() const
+  {
+    return _reset || (_request_done && _response_done);
+  }
+
+  /// @name Called by the session with its mutex held.
+  //@{
+  void receive_headers(HTTPHdr &hdr, bool end_stream);
+  void receive_data(const uint8_t *data, uint32_t len, bool end_stream);
+  /// Does a DATA frame of @a len bytes fit in the receive window of the stream?
+  bool recv_window_allows(uint32_t len) const;
+  void receive_rst_stream(Http2ErrorCode code);
+  /// The send window changed by @a delta, from a WINDOW_UPDATE or a new initial window size.
+  void update_send_window(Http2WindowSize delta);
+  /// The connection is gone.
+  void session_closed();
+  //@}
+
+  LINK(Http2ServerStream, link);
+
+private:
+  int main_event_handler(int event, void *edata);
+  /// Send as much of the request as the write VIO and the flow control windows allow.
+  void send_request();
+  /// Move as much of the response as the read VIO allows to its buffer.
+  void deliver_response();
+  /// Stop sending and receiving, and tell the state machine.
+  void fail(int event);
+  void signal(int event, VIO *vio);
+  void clear_timers();
+
+  Http2ServerSession *_session = nullptr;
+  Http2StreamId _id            = 0;
+
+  VIO _read_vio;
+  VIO _write_vio;
+  Event *_read_event     = nullptr;
+  Event *_write_event    = nullptr;
+  Event *_active_event   = nullptr;
+  Event *_inactive_event = nullptr;
+
+  ink_hrtime _active_timeout      = 0;
+  ink_hrtime _inactive_timeout    = 0;
+  ink_hrtime _inactive_timeout_at = 0;
+
+  HTTPParser _parser;
+  HTTPHdr _request_header;
+  int64_t _request_body_left = 0;
+  bool _headers_sent         = false;
+  bool _request_done         = false; ///< END_STREAM sent.
+
+  /// Response bytes, in HTTP/1.1 form, not yet moved to the read VIO.
+  MIOBuffer *_response_buffer     = nullptr;
+  IOBufferReader *_response_reader = nullptr;
+  bool _final_response             = false; ///< A non-informational response header was received.
+  bool _response_done              = false; ///< END_STREAM received.
+  bool _reset                      = false;
+
+  Http2WindowSize _send_window = 0;
+  uint32_t _recv_unacked       = 0; ///< DATA payload received and not yet returned by WINDOW_UPDATE.
+};
+
+/** An outbound HTTP/2 connection, carrying concurrent streams for many transactions.
+
+    A session is created from a connection to a server on which "h2" was negotiated by ALPN. It is
+    kept in the per thread server session pool, keyed like the HTTP/1.1 sessions there, for as long
+    as it can take new streams. Because its streams deliver events directly to their state machines,
+    a session is only used by state machines on its own thread.
+
+    Framing, settings validation and HPACK are shared with the inbound side through HTTP2.h. The
+    stream and connection state is not: Http2ConnectionState and Http2Stream are built around the
+    client roles (stream ids, push, the priority tree, a ProxyTransaction per stream), while here
+    the streams are opened by this side and read by an HttpSM as a server VConnection.
+*/
+class Http2ServerSession : public Continuation
+{
+  using self_type  = Http2ServerSession;
+  using super_type = Continuation;
+
+public:
+  Http2ServerSession() : super_type(nullptr) {}
+  Http2ServerSession(self_type const &) = delete;
+  self_type &operator=(self_type const &) = delete;
+
+  /** Take over @a new_vc, on which "h2" has been negotiated, and send the connection preface.
+
+      At most @a max_streams streams are opened on the connection at once, fewer if the server asks.
+  */
+  void new_connection(NetVConnection *new_vc, uint32_t max_streams);
+
+  /// Can another stream be opened on this connection?
+  bool is_available() const;
+
+  /** Open a stream on this connection.
+      @return The stream, or @c nullptr if no more streams can be opened.
+  */
+  Http2ServerStream *create_stream();
+
+  NetVConnection *
+  get_netvc() const
+  {
+    return server_vc;
+  }
+
+  IpEndpoint const &
+  get_server_ip() const
+  {
+    ink_release_assert(server_vc != nullptr);
+    return server_vc->get_remote_endpoint();
+  }
+
+  /// @name Called by streams with the session mutex held.
+  //@{
+  /// @return @c false if the header could not be encoded.
+  bool send_headers(Http2ServerStream *stream, HTTPHdr *hdr, bool end_stream);
+  /** Send up to @a len bytes from @a reader as DATA frames, limited by the connection send window.
+      @return The number of bytes sent.
+  */
+  int64_t send_data(Http2ServerStream *stream, IOBufferReader *reader, int64_t len, bool end_stream);
+  void send_window_update(Http2StreamId id, uint32_t size);
+  void send_rst_stream(Http2StreamId id, Http2ErrorCode code);
+  /// The state machine is done with @a stream.
+  void stream_closed(Http2ServerStream *stream);
+
+  Http2WindowSize
+  peer_initial_window_size() const
+  {
+    return _peer_initial_window_size;
+  }
+
+  uint32_t
+  local_initial_window_size() const
+  {
+    return _local_initial_window_size;
+  }
+  //@}
+
+  CryptoHash hostname_hash;
+  int64_t con_id = 0;
+
+  // Carried over from the HTTP/1.1 session the connection was opened for.
+  bool to_parent_proxy                       = false;
+  OutboundConnTrack::Group *conn_track_group = nullptr;
+
+  /// The pool the session is in, @c nullptr if it is not shared.
+  ServerSessionPool *pool = nullptr;
+
+  /// Hash map descriptor class for IP map.
+  struct IPLinkage {
+    self_type *_next = nullptr;
+    self_type *_prev = nullptr;
+
+    static self_type *&next_ptr(self_type *);
+    static self_type *&prev_ptr(self_type *);
+    static uint32_t hash_of(sockaddr const *key);
+    static sockaddr const *key_of(self_type const *ssn);
+    static bool equal(sockaddr const *lhs, sockaddr const *rhs);
+  } _ip_link;
+
+  /// Hash map descriptor class for FQDN map.
+  struct FQDNLinkage {
+    self_type *_next = nullptr;
+    self_type *_prev = nullptr;
+
+    static self_type *&next_ptr(self_type *);
+    static self_type *&prev_ptr(self_type *);
+    static uint64_t hash_of(CryptoHash const &key);
+    static CryptoHash const &key_of(self_type *ssn);
+    static bool equal(CryptoHash const &lhs, CryptoHash const &rhs);
+  } _fqdn_link;
+
+private:
+  int main_event_handler(int event, void *edata);
+  /// Handle the complete frames in the read buffer. @return An error to close the connection with.
+  Http2ErrorCode process_frames();
+  Http2ErrorCode receive_frame(const Http2FrameHeader &hdr, const uint8_t *payload);
+  Http2ErrorCode receive_header_block(Http2StreamId id, bool end_stream);
+  Http2ErrorCode receive_settings(const Http2FrameHeader &hdr, const uint8_t *payload);
+  Http2ErrorCode receive_goaway(const Http2FrameHeader &hdr, const uint8_t *payload);
+  Http2ErrorCode receive_window_update(const Http2FrameHeader &hdr, const uint8_t *payload);
+  void send_frame(Http2FrameType type, uint8_t flags, Http2StreamId id, const uint8_t *payload, uint32_t len);
+  void send_goaway(Http2ErrorCode code);
+  Http2ServerStream *find_stream(Http2StreamId id);
+  /// The number of streams that have not finished in both directions.
+  uint32_t open_streams() const;
+  /// Stop taking new streams, and close the connection once the open ones are done.
+  void drain();
+  /// Close the connection if it is draining and has no streams, or is idle and not shared.
+  void close_if_done();
+  void update_idle_timeout();
+  void destroy();
+
+  NetVConnection *server_vc = nullptr;
+  MIOBuffer *read_buffer    = nullptr;
+  IOBufferReader *reader    = nullptr;
+  MIOBuffer *write_buffer   = nullptr;
+  VIO *write_vio            = nullptr;
+
+  HpackHandle *_encoder = nullptr;
+  HpackHandle *_decoder = nullptr;
+
+  DLL<Http2ServerStream> _streams;
+  Http2StreamId _next_stream_id = 1;
+  bool _draining                = false;
+  bool _closed                  = false;
+  int _recursion                = 0; ///< Depth of calls to the event handler.
+  bool _close_pending           = false;
+
+  // The header block of a HEADERS frame being continued.
+  uint8_t *_header_block             = nullptr;
+  uint32_t _header_block_len         = 0;
+  Http2StreamId _continued_stream_id = 0;
+  bool _continued_end_stream         = false;
+
+  Http2WindowSize _send_window              = HTTP2_INITIAL_WINDOW_SIZE;
+  uint32_t _recv_window                     = HTTP2_INITIAL_WINDOW_SIZE;
+  uint32_t _recv_unacked                    = 0;
+  Http2WindowSize _peer_initial_window_size = HTTP2_INITIAL_WINDOW_SIZE;
+  uint32_t _peer_max_frame_size             = HTTP2_MAX_FRAME_SIZE;
+  uint32_t _peer_max_concurrent_streams     = HTTP2_MAX_CONCURRENT_STREAMS;
+  uint32_t _peer_header_table_size          = HTTP2_HEADER_TABLE_SIZE;
+  uint32_t _local_initial_window_size       = HTTP2_INITIAL_WINDOW_SIZE;
+  uint32_t _local_max_concurrent_streams    = 1;
+};
+
+extern ClassAllocator<Http2ServerSession> http2ServerSessionAllocator;
+extern ClassAllocator<Http2ServerStream> http2ServerStreamAllocator;
+
+// --- Implementation ---
+
+inline Http2ServerSession *&
+Http2ServerSession::IPLinkage::next_ptr(self_type *ssn)
+{
+  return ssn->_ip_link._next;
+}
+
+inline Http2ServerSession *&
+Http2ServerSession::IPLinkage::prev_ptr(self_type *ssn)
+{
+  return ssn->_ip_link._prev;
+}
+
+inline uint32_t
+Http2ServerSession::IPLinkage::hash_of(sockaddr const *key)
+{
+  return ats_ip_hash(key);
+}
+
+inline sockaddr const *
+Http2ServerSession::IPLinkage::key_of(self_type const *ssn)
+{
+  return &ssn->get_server_ip().sa;
+}
+
+inline bool
+Http2ServerSession::IPLinkage::equal(sockaddr const *lhs, sockaddr const *rhs)
+{
+  return ats_ip_addr_port_eq(lhs, rhs);
+}
+
+inline Http2ServerSession *&
+Http2ServerSession::FQDNLinkage::next_ptr(self_type *ssn)
+{
+  return ssn->_fqdn_link._next;
+}
+
+inline Http2ServerSession *&
+Http2ServerSession::FQDNLinkage::prev_ptr(self_type *ssn)
+{
+  return ssn->_fqdn_link._prev;
+}
+
+inline uint64_t
+Http2ServerSession::FQDNLinkage::hash_of(CryptoHash const &key)
+{
+  return key.fold();
+}
+
+inline CryptoHash const &
+Http2ServerSession::FQDNLinkage::key_of(self_type *ssn)
+{
+  return ssn->hostname_hash;
+}
+
+inline bool
+Http2ServerSession::FQDNLinkage::equal(CryptoHash const &lhs, CryptoHash const &rhs)
+{
+  return lhs == rhs;
+}
@@ -156,7 +156,7 @@ public:
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t url_hash; // CryptoContext::HashType of the cache keys, 0 (unspecified) for stripes that predate this
   uint16_t freelist[1];
 };
 
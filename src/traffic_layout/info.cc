@@ -98,6 +98,7 @@ produce_features(bool json)
   print_feature("TS_HAS_SO_PEERCRED", TS_HAS_SO_PEERCRED, json);
   print_feature("TS_USE_REMOTE_UNWINDING", TS_USE_REMOTE_UNWINDING, json);
   print_feature("TS_USE_TLS_OCSP", TS_USE_TLS_OCSP, json);
+  print_feature("TS_USE_TLS_ASYNC", TS_USE_TLS_ASYNC, json);
   print_feature("SIZEOF_VOIDP", SIZEOF_VOIDP, json);
   print_feature("TS_IP_TRANSPARENT", TS_IP_TRANSPARENT, json);
   print_feature("TS_HAS_128BIT_CAS", TS_HAS_128BIT_CAS, json);
@@ -4060,7 +4060,7 @@ TSCacheKeyDigestSet(TSCacheKey key, const char *input, int length)
     return TS_ERROR;
   }
 
-  CryptoContext().hash_immediate(ci->cache_key, input, length);
+  URLHashContext().hash_immediate(ci->cache_key, input, length);
   return TS_SUCCESS;
 }
 
@@ -8350,6 +8350,15 @@ _conf_to_memberp(TSOverridableConfigKey conf, OverridableHttpConfigParams *overr
     ret  = &overridableHttpConfig->outbound_conntrack.match;
     conv = &OutboundConnTrack::MATCH_CONV;
     break;
+  case TS_CONFIG_HTTP_ALLOW_EARLY_DATA:
+    ret = _memberp_to_generic(&overridableHttpConfig->allow_early_data, conv);
+    break;
+  case TS_CONFIG_HTTP_PER_SERVER_CONNECTION_PREWARM:
+    ret = _memberp_to_generic(&overridableHttpConfig->server_prewarm_min, conv);
+    break;
+  case TS_CONFIG_HTTP2_MAX_CONCURRENT_STREAMS_OUT:
+    ret = _memberp_to_generic(&overridableHttpConfig->http2_max_concurrent_streams_out, conv);
+    break;
   // This helps avoiding compiler warnings, yet detect unhandled enum members.
   case TS_CONFIG_NULL:
   case TS_CONFIG_LAST_ENTRY:
@@ -8717,7 +8726,10 @@ static const std::unordered_map<std::string_view, std::tuple<const TSOverridable
    {"proxy.config.ssl.client.cert.filename", {TS_CONFIG_SSL_CLIENT_CERT_FILENAME, TS_RECORDDATATYPE_STRING}},
    {"proxy.config.ssl.client.cert.path", {TS_CONFIG_SSL_CERT_FILEPATH, TS_RECORDDATATYPE_STRING}},
    {"proxy.config.ssl.client.private_key.filename", {TS_CONFIG_SSL_CLIENT_PRIVATE_KEY_FILENAME, TS_RECORDDATATYPE_STRING}},
-   {"proxy.config.ssl.client.CA.cert.filename", {TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME, TS_RECORDDATATYPE_STRING}}});
+   {"proxy.config.ssl.client.CA.cert.filename", {TS_CONFIG_SSL_CLIENT_CA_CERT_FILENAME, TS_RECORDDATATYPE_STRING}},
+   {"proxy.config.http.allow_early_data", {TS_CONFIG_HTTP_ALLOW_EARLY_DATA, TS_RECORDDATATYPE_INT}},
+   {"proxy.config.http.per_server.connection.prewarm", {TS_CONFIG_HTTP_PER_SERVER_CONNECTION_PREWARM, TS_RECORDDATATYPE_INT}},
+   {"proxy.config.http2.max_concurrent_streams_out", {TS_CONFIG_HTTP2_MAX_CONCURRENT_STREAMS_OUT, TS_RECORDDATATYPE_INT}}});
 
 TSReturnCode
 TSHttpTxnConfigFind(const char *name, int length, TSOverridableConfigKey *conf, TSRecordDataType *type)
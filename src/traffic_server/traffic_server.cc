@@ -96,6 +96,7 @@ extern "C" int plock(int);
 #include "HTTP2.h"
 #include "tscore/ink_config.h"
 #include "P_SSLSNI.h"
+#include "SSLSessionCache.h"
 
 #include "tscore/ink_cap.h"
 
@@ -234,6 +235,8 @@ struct AutoStopCont : public Continuation {
       hook = hook->next();
     }
 
+    SSLSessionCacheFinalSync();
+
     pmgmt->stop();
     shutdown_event_system = true;
     delete this;
@@ -701,6 +704,9 @@ CB_After_Cache_Init()
 
   start = ink_atomic_swap(&delay_listen_for_cache_p, -1);
 
+  // Use the URL hash the cache stripes were created with.
+  URLHashContext::Setting = cacheProcessor.url_hash_type;
+
 #if TS_ENABLE_FIPS == 0
   // Check for cache BC after the cache is initialized and before listen, if possible.
   if (cacheProcessor.min_stripe_version._major < CACHE_DB_MAJOR_VERSION) {
@@ -1978,6 +1984,9 @@ main(int /* argc ATS_UNUSED */, const char **argv)
     eventProcessor.thread_group[ET_TASK]._afterStartCallback = task_threads_started_callback;
     tasksProcessor.start(num_task_threads, stacksize);
 
+    // Reload the TLS session cache saved by the previous run, now that there are task threads to do it.
+    SSLSessionCacheStartSync();
+
     if (netProcessor.socks_conf_stuff->accept_enabled) {
       start_SocksProxy(netProcessor.socks_conf_stuff->accept_port);
     }
@@ -2040,6 +2049,8 @@ static void *
 mgmt_restart_shutdown_callback(void *, char *, int /* data_len ATS_UNUSED */)
 {
   sync_cache_dir_on_shutdown();
+  // The manager exits right after this, before AutoStopCont would save the sessions.
+  SSLSessionCacheFinalSync();
   return nullptr;
 }
 
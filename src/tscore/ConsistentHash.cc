@@ -20,6 +20,7 @@
  */
 
 #include "tscore/ConsistentHash.h"
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <sstream>
@@ -33,7 +34,7 @@ operator<<(std::ostream &os, ATSConsistentHashNode &thing)
   return os << thing.name;
 }
 
-ATSConsistentHash::ATSConsistentHash(int r, ATSHash64 *h) : replicas(r), hash(h) {}
+ATSConsistentHash::ATSConsistentHash(int r, ATSHash64 *h, ATSConsistentHashRing rg) : replicas(r), hash(h), ring(rg) {}
 
 void
 ATSConsistentHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *h)
@@ -43,6 +44,7 @@ ATSConsistentHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *
   ATSHash64 *thash;
   std::ostringstream string_stream;
   std::string std_string;
+  std::vector<Point> points;
 
   if (h) {
     thash = h;
@@ -60,9 +62,77 @@ ATSConsistentHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *
     thash->update(numstr, strlen(numstr));
     thash->update(std_string.c_str(), strlen(std_string.c_str()));
     thash->final();
-    NodeMap.insert(std::pair<uint64_t, ATSConsistentHashNode *>(thash->get(), node));
+    if (ring == ATSConsistentHashRing::SORTED_ARRAY) {
+      points.emplace_back(thash->get(), node);
+    } else {
+      NodeMap.insert(std::pair<uint64_t, ATSConsistentHashNode *>(thash->get(), node));
+    }
     thash->clear();
   }
+
+  if (!points.empty()) {
+    // Merge the node's points into the ring in one pass. Both the sort and the merge are stable, so where
+    // hashes collide the point that was there first is kept, just as std::map::insert keeps it.
+    auto by_hash = [](const Point &a, const Point &b) -> bool { return a.first < b.first; };
+    size_t before = NodeArray.size();
+
+    std::stable_sort(points.begin(), points.end(), by_hash);
+    NodeArray.insert(NodeArray.end(), points.begin(), points.end());
+    std::inplace_merge(NodeArray.begin(), NodeArray.begin() + before, NodeArray.end(), by_hash);
+    NodeArray.erase(std::unique(NodeArray.begin(), NodeArray.end(),
+                                [](const Point &a, const Point &b) -> bool { return a.first == b.first; }),
+                    NodeArray.end());
+  }
+}
+
+bool
+ATSConsistentHash::at_end(const ATSConsistentHashIter &iter) const
+{
+  if (ring == ATSConsistentHashRing::SORTED_ARRAY) {
+    return iter.idx >= NodeArray.size();
+  }
+  return iter.node == NodeMap.end();
+}
+
+void
+ATSConsistentHash::seek(ATSConsistentHashIter &iter, uint64_t hashval)
+{
+  if (ring == ATSConsistentHashRing::SORTED_ARRAY) {
+    iter.idx = std::lower_bound(NodeArray.begin(), NodeArray.end(), hashval,
+                                [](const Point &point, uint64_t value) -> bool { return point.first < value; }) -
+               NodeArray.begin();
+  } else {
+    iter.node = NodeMap.lower_bound(hashval);
+  }
+}
+
+void
+ATSConsistentHash::rewind(ATSConsistentHashIter &iter)
+{
+  if (ring == ATSConsistentHashRing::SORTED_ARRAY) {
+    iter.idx = 0;
+  } else {
+    iter.node = NodeMap.begin();
+  }
+}
+
+void
+ATSConsistentHash::next(ATSConsistentHashIter &iter)
+{
+  if (ring == ATSConsistentHashRing::SORTED_ARRAY) {
+    iter.idx++;
+  } else {
+    iter.node++;
+  }
+}
+
+ATSConsistentHashNode *
+ATSConsistentHash::node(const ATSConsistentHashIter &iter) const
+{
+  if (ring == ATSConsistentHashRing::SORTED_ARRAY) {
+    return NodeArray[iter.idx].second;
+  }
+  return iter.node->second;
 }
 
 ATSConsistentHashNode *
@@ -99,26 +169,26 @@ ATSConsistentHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, AT
     url_hash = thash->get();
     thash->clear();
 
-    *iter = NodeMap.lower_bound(url_hash);
+    seek(*iter, url_hash);
 
-    if (*iter == NodeMap.end()) {
+    if (at_end(*iter)) {
       *wptr = true;
-      *iter = NodeMap.begin();
+      rewind(*iter);
     }
   } else {
-    (*iter)++;
+    next(*iter);
   }
 
-  if (!(*wptr) && *iter == NodeMap.end()) {
+  if (!(*wptr) && at_end(*iter)) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    rewind(*iter);
   }
 
-  if (*wptr && *iter == NodeMap.end()) {
+  if (*wptr && at_end(*iter)) {
     return nullptr;
   }
 
-  return (*iter)->second;
+  return node(*iter);
 }
 
 ATSConsistentHashNode *
@@ -155,26 +225,26 @@ ATSConsistentHash::lookup_available(const char *url, ATSConsistentHashIter *i, b
     url_hash = thash->get();
     thash->clear();
 
-    *iter = NodeMap.lower_bound(url_hash);
+    seek(*iter, url_hash);
   }
 
-  if (*iter == NodeMap.end()) {
+  if (at_end(*iter)) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    rewind(*iter);
   }
 
-  while (!(*iter)->second->available) {
-    (*iter)++;
+  while (!node(*iter)->available) {
+    next(*iter);
 
-    if (!(*wptr) && *iter == NodeMap.end()) {
+    if (!(*wptr) && at_end(*iter)) {
       *wptr = true;
-      *iter = NodeMap.begin();
-    } else if (*wptr && *iter == NodeMap.end()) {
+      rewind(*iter);
+    } else if (*wptr && at_end(*iter)) {
       return nullptr;
     }
   }
 
-  return (*iter)->second;
+  return node(*iter);
 }
 
 ATSConsistentHashNode *
@@ -195,14 +265,14 @@ ATSConsistentHash::lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i,
     iter = &NodeMapIterUp;
   }
 
-  *iter = NodeMap.lower_bound(hashval);
+  seek(*iter, hashval);
 
-  if (*iter == NodeMap.end()) {
+  if (at_end(*iter)) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    rewind(*iter);
   }
 
-  return (*iter)->second;
+  return node(*iter);
 }
 
 ATSConsistentHash::~ATSConsistentHash()
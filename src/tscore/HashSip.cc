@@ -9,6 +9,7 @@ https://github.com/floodyberry/siphash
  */
 
 #include "tscore/HashSip.h"
+#include <algorithm>
 #include <cstring>
 
 using namespace std;
@@ -139,3 +140,85 @@ ATSHash64Sip24::clear()
   total_len        = 0;
   block_buffer_len = 0;
 }
+
+SipHashContext::SipHashContext()
+{
+  // Zero key, with the 128 bit output variant tweak.
+  v0 = 0x736f6d6570736575ull;
+  v1 = 0x646f72616e646f6dull ^ 0xee;
+  v2 = 0x6c7967656e657261ull;
+  v3 = 0x7465646279746573ull;
+}
+
+bool
+SipHashContext::update(void const *data, int length)
+{
+  const unsigned char *m = static_cast<const unsigned char *>(data);
+  size_t len             = length;
+  uint64_t mi;
+
+  total_len += len;
+
+  if (block_buffer_len > 0) {
+    size_t fill = std::min(len, static_cast<size_t>(SIP_BLOCK_SIZE - block_buffer_len));
+    memcpy(block_buffer + block_buffer_len, m, fill);
+    block_buffer_len += fill;
+    m += fill;
+    len -= fill;
+    if (block_buffer_len < SIP_BLOCK_SIZE) {
+      return true;
+    }
+    memcpy(&mi, block_buffer, sizeof(mi));
+    v3 ^= mi;
+    SIPCOMPRESS(v0, v1, v2, v3);
+    SIPCOMPRESS(v0, v1, v2, v3);
+    v0 ^= mi;
+    block_buffer_len = 0;
+  }
+
+  for (; len >= SIP_BLOCK_SIZE; m += SIP_BLOCK_SIZE, len -= SIP_BLOCK_SIZE) {
+    memcpy(&mi, m, sizeof(mi));
+    v3 ^= mi;
+    SIPCOMPRESS(v0, v1, v2, v3);
+    SIPCOMPRESS(v0, v1, v2, v3);
+    v0 ^= mi;
+  }
+
+  memcpy(block_buffer, m, len);
+  block_buffer_len = len;
+  return true;
+}
+
+bool
+SipHashContext::finalize(CryptoHash &hash)
+{
+  uint64_t last7 = (uint64_t)(total_len & 0xff) << 56;
+  uint64_t h[2];
+
+  for (int i = block_buffer_len - 1; i >= 0; i--) {
+    last7 |= (uint64_t)block_buffer[i] << (i * 8);
+  }
+
+  v3 ^= last7;
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  v0 ^= last7;
+
+  v2 ^= 0xee;
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  h[0] = v0 ^ v1 ^ v2 ^ v3;
+
+  v1 ^= 0xdd;
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  h[1] = v0 ^ v1 ^ v2 ^ v3;
+
+  hash = CRYPTO_HASH_ZERO;
+  memcpy(hash.u8, h, sizeof(h));
+  return true;
+}
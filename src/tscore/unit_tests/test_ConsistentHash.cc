@@ -0,0 +1,157 @@
+/** @file
+
+    Unit tests for ATSConsistentHash.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "tscore/ConsistentHash.h"
+#include "tscore/HashSip.h"
+
+namespace
+{
+struct Ring {
+  std::vector<std::string> names;
+  std::vector<ATSConsistentHashNode> nodes;
+  ATSHash64Sip24 hash;
+  ATSConsistentHash chash;
+
+  Ring(int n_nodes, ATSConsistentHashRing ring) : names(n_nodes), nodes(n_nodes), chash(1024, nullptr, ring)
+  {
+    for (int i = 0; i < n_nodes; ++i) {
+      names[i]           = "parent-" + std::to_string(i) + ".example.com";
+      nodes[i].name      = const_cast<char *>(names[i].c_str());
+      nodes[i].available = true;
+      // Vary the weights so nodes get different numbers of points.
+      chash.insert(&nodes[i], 1.0 + (i % 3) * 0.5, &hash);
+    }
+  }
+
+  int
+  index(ATSConsistentHashNode *node) const
+  {
+    return node ? node - nodes.data() : -1;
+  }
+};
+
+uint64_t
+key_hash(uint64_t i)
+{
+  ATSHash64Sip24 h;
+  h.update(&i, sizeof(i));
+  h.final();
+  return h.get();
+}
+} // namespace
+
+TEST_CASE("ATSConsistentHash rings agree", "[libts][ConsistentHash]")
+{
+  Ring map(50, ATSConsistentHashRing::MAP);
+  Ring array(50, ATSConsistentHashRing::SORTED_ARRAY);
+
+  SECTION("lookup by hash value")
+  {
+    for (uint64_t i = 0; i < 10000; ++i) {
+      uint64_t hv = key_hash(i);
+      REQUIRE(map.index(map.chash.lookup_by_hashval(hv)) == array.index(array.chash.lookup_by_hashval(hv)));
+    }
+    REQUIRE(map.index(map.chash.lookup_by_hashval(0)) == array.index(array.chash.lookup_by_hashval(0)));
+    REQUIRE(map.index(map.chash.lookup_by_hashval(UINT64_MAX)) == array.index(array.chash.lookup_by_hashval(UINT64_MAX)));
+  }
+
+  SECTION("walk the ring, wrapping around")
+  {
+    ATSConsistentHashIter map_iter, array_iter;
+    bool map_wrap = false, array_wrap = false;
+    uint64_t hv = key_hash(42);
+
+    REQUIRE(map.index(map.chash.lookup_by_hashval(hv, &map_iter, &map_wrap)) ==
+            array.index(array.chash.lookup_by_hashval(hv, &array_iter, &array_wrap)));
+    // The ring has fewer than 1024 * 2 points per node, so this goes all the way round it and stops.
+    for (int i = 0; i < 1024 * 2 * 50 + 1; ++i) {
+      ATSConsistentHashNode *m = map.chash.lookup(nullptr, &map_iter, &map_wrap, &map.hash);
+      ATSConsistentHashNode *a = array.chash.lookup(nullptr, &array_iter, &array_wrap, &array.hash);
+      REQUIRE(map.index(m) == array.index(a));
+      REQUIRE(map_wrap == array_wrap);
+      if (m == nullptr) {
+        break;
+      }
+    }
+    REQUIRE(map_wrap);
+  }
+
+  SECTION("skip unavailable nodes")
+  {
+    for (size_t i = 0; i < map.nodes.size(); i += 2) {
+      map.nodes[i].available   = false;
+      array.nodes[i].available = false;
+    }
+    for (int i = 0; i < 1000; ++i) {
+      std::string url          = "/some/path/" + std::to_string(i);
+      ATSConsistentHashNode *m = map.chash.lookup_available(url.c_str(), nullptr, nullptr, &map.hash);
+      ATSConsistentHashNode *a = array.chash.lookup_available(url.c_str(), nullptr, nullptr, &array.hash);
+      REQUIRE(a != nullptr);
+      REQUIRE(a->available);
+      REQUIRE(map.index(m) == array.index(a));
+    }
+
+    for (auto &node : array.nodes) {
+      node.available = false;
+    }
+    REQUIRE(array.chash.lookup_available("/any", nullptr, nullptr, &array.hash) == nullptr);
+  }
+}
+
+// Performance test, hidden by default. Run with `test_tscore "[performance]"`.
+TEST_CASE("ATSConsistentHash performance", "[libts][ConsistentHash][performance][.]")
+{
+  constexpr int N_PARENTS = 200;
+  constexpr int N_LOOPS   = 2000000;
+  std::pair<const char *, ATSConsistentHashRing> rings[] = {{"map", ATSConsistentHashRing::MAP},
+                                                            {"array", ATSConsistentHashRing::SORTED_ARRAY}};
+  std::vector<uint64_t> keys(4096);
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = key_hash(i);
+  }
+
+  for (auto const &[name, type] : rings) {
+    auto start = std::chrono::high_resolution_clock::now();
+    Ring ring(N_PARENTS, type);
+    auto delta = std::chrono::high_resolution_clock::now() - start;
+    std::cout << name << ": built " << N_PARENTS << " parents in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(delta).count() << "ms" << std::endl;
+
+    int64_t sum = 0;
+    start       = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_LOOPS; ++i) {
+      sum += ring.index(ring.chash.lookup_by_hashval(keys[i % keys.size()] + i));
+    }
+    delta   = std::chrono::high_resolution_clock::now() - start;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(delta).count();
+    std::cout << name << ": " << (ms ? N_LOOPS * 1000LL / ms : 0) << " lookups/sec (" << sum << ")" << std::endl;
+  }
+}
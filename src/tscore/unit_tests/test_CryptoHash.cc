@@ -0,0 +1,100 @@
+/** @file
+
+    Unit tests for CryptoHash and the hash contexts.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "catch.hpp"
+
+#include "tscore/CryptoHash.h"
+#include "tscore/HashSip.h"
+
+using namespace std::literals;
+
+#if TS_ENABLE_FIPS == 0
+namespace
+{
+std::string
+to_hex(CryptoHash const &hash)
+{
+  char buff[CRYPTO_HEX_SIZE];
+  return hash.toHexStr(buff);
+}
+} // namespace
+
+TEST_CASE("SipHashContext", "[libts][CryptoHash]")
+{
+  CryptoHash hash;
+
+  // SipHash-2-4 128 bit output with a zero key.
+  SipHashContext().hash_immediate(hash, "abc", 3);
+  REQUIRE(to_hex(hash) == "6C95DEC302962FA8CA5E69C1D5D15478");
+
+  SipHashContext().hash_immediate(hash, "", 0);
+  CryptoHash empty{hash};
+  REQUIRE(empty != CRYPTO_HASH_ZERO);
+
+  // Incremental updates across block boundaries give the same result as a single update.
+  std::string_view url{"http://www.example.com:80/some/path/to/an/object.html?with=a&query=string"};
+  CryptoHash whole, pieces;
+  SipHashContext().hash_immediate(whole, url.data(), url.size());
+  for (size_t step : {1, 3, 7, 8, 9, 17}) {
+    SipHashContext ctx;
+    for (size_t i = 0; i < url.size(); i += step) {
+      auto piece = url.substr(i, step);
+      ctx.update(piece.data(), piece.size());
+    }
+    ctx.finalize(pieces);
+    REQUIRE(whole == pieces);
+  }
+
+  CryptoContext(CryptoContext::SIPHASH).hash_immediate(pieces, url.data(), url.size());
+  REQUIRE(whole == pieces);
+  CryptoContext(CryptoContext::MD5).hash_immediate(pieces, url.data(), url.size());
+  REQUIRE(whole != pieces);
+}
+
+// Performance test, hidden by default. Run with `test_tscore "[performance]"`.
+TEST_CASE("CryptoContext performance", "[libts][CryptoHash][performance][.]")
+{
+  constexpr int N_LOOPS = 1000000;
+  std::string_view url{"http://www.example.com:80/some/path/to/an/object.html?with=a&query=string"};
+  std::pair<const char *, CryptoContext::HashType> types[] = {
+    {"MD5", CryptoContext::MD5}, {"MMH", CryptoContext::MMH}, {"SipHash", CryptoContext::SIPHASH}};
+
+  for (auto const &[name, type] : types) {
+    CryptoHash hash;
+    uint64_t sum = 0;
+    auto start   = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_LOOPS; ++i) {
+      CryptoContext(type).hash_immediate(hash, url.data(), url.size());
+      sum += hash.fold();
+    }
+    auto delta = std::chrono::high_resolution_clock::now() - start;
+    auto ms    = std::chrono::duration_cast<std::chrono::milliseconds>(delta).count();
+    std::cout << name << ": " << (ms ? N_LOOPS * 1000LL / ms : 0) << " keys/sec (" << sum << ")" << std::endl;
+  }
+}
+#endif
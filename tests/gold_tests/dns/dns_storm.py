@@ -0,0 +1,71 @@
+'''
+Send many concurrent requests through the proxy, each needing a DNS lookup, and report the rate.
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import argparse
+import socket
+import sys
+import threading
+import time
+
+
+def fetch(proxy_port, host, origin_port, results, index):
+    request = 'GET http://{0}:{1}/storm HTTP/1.1\r\nHost: {0}:{1}\r\nConnection: close\r\n\r\n'.format(host, origin_port)
+    try:
+        with socket.create_connection(('127.0.0.1', proxy_port), timeout=30) as s:
+            s.sendall(request.encode())
+            response = b''
+            while True:
+                data = s.recv(4096)
+                if not data:
+                    break
+                response += data
+        results[index] = response.startswith(b'HTTP/1.1 200')
+    except OSError:
+        results[index] = False
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('proxy_port', type=int, help='Port of the proxy.')
+    parser.add_argument('origin_port', type=int, help='Port of the origin, every host name resolves to it.')
+    parser.add_argument('--hosts', type=int, default=500, help='Number of distinct host names to look up.')
+    parser.add_argument('--repeat', type=int, default=2,
+                        help='Requests per host name, sent together so their lookups can be coalesced.')
+    args = parser.parse_args()
+
+    hosts = ['host-{0}.storm.test'.format(i) for i in range(args.hosts)]
+    results = [False] * (args.hosts * args.repeat)
+    threads = [threading.Thread(target=fetch, args=(args.proxy_port, hosts[i % args.hosts], args.origin_port, results, i))
+               for i in range(len(results))]
+
+    start = time.time()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.time() - start
+
+    failed = results.count(False)
+    print('{0} lookups in {1:.2f} seconds, {2:.0f} queries/sec, {3} failed'.format(
+        args.hosts, elapsed, args.hosts / elapsed if elapsed else 0, failed))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
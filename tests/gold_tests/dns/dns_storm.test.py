@@ -0,0 +1,53 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import os
+
+Test.Summary = 'Test a burst of concurrent DNS lookups, sent and read in batches'
+
+ts = Test.MakeATSProcess("ts")
+server = Test.MakeOriginServer("server")
+# Every name resolves to the origin.
+dns = Test.MakeDNServer("dns", ip='127.0.0.1', default=['127.0.0.1'])
+
+request_header = {"headers": "GET /storm HTTP/1.1\r\nHost: *\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionfile.log", request_header, response_header)
+
+ts.Disk.records_config.update({
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'dns',
+    'proxy.config.dns.nameservers': '127.0.0.1:{0}'.format(dns.Variables.Port),
+    'proxy.config.dns.resolv_conf': 'NULL',
+    'proxy.config.url_remap.remap_required': 0,
+})
+
+Test.Setup.Copy(os.path.join(Test.TestDirectory, 'dns_storm.py'))
+
+tr = Test.AddTestRun("Concurrent lookups of distinct names")
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(dns)
+tr.Processes.Default.StartBefore(ts, ready=When.PortOpen(ts.Variables.port))
+tr.Processes.Default.Command = 'python3 dns_storm.py {0} {1}'.format(ts.Variables.port, server.Variables.Port)
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("queries/sec, 0 failed", "All requests should succeed")
+tr.StillRunningAfter = ts
+
+# Queries should have gone out in batches.
+ts.Disk.traffic_out.Content = Testers.ContainsExpression("send ([2-9]|[1-9][0-9]+) queries to fd",
+                                                         "Queries should be sent more than one at a time")
@@ -0,0 +1,124 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = 'Test that HostDB records in use are looked up again before they time out'
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl needs to be installed on system for this test to work"),
+)
+
+ts = Test.MakeATSProcess("ts")
+server = Test.MakeOriginServer("server")
+# Every name resolves to the origin.
+dns = Test.MakeDNServer("dns", ip='127.0.0.1', default=['127.0.0.1'])
+# The name server is stopped by the test to make a prefetch fail.
+dns.ReturnCode = Any(None, 0, -15)
+
+request_header = {"headers": "GET /prefetch HTTP/1.1\r\nHost: *\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n",
+                   "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionfile.log", request_header, response_header)
+
+ts.Disk.records_config.update({
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'hostdb',
+    'proxy.config.dns.nameservers': '127.0.0.1:{0}'.format(dns.Variables.Port),
+    'proxy.config.dns.resolv_conf': 'NULL',
+    'proxy.config.dns.lookup_timeout': 2,
+    'proxy.config.dns.retries': 0,
+    'proxy.config.url_remap.remap_required': 0,
+    # Every record lives 40 seconds, and is due for a prefetch after 20 seconds and 3 hits.
+    'proxy.config.hostdb.ttl_mode': 1,
+    'proxy.config.hostdb.timeout': 40,
+    'proxy.config.hostdb.prefetch.min_hits': 3,
+    'proxy.config.hostdb.prefetch.ttl_pct': 50,
+    'proxy.config.hostdb.prefetch.max_per_second': 1,
+})
+
+
+def request(name):
+    return 'curl -s -o /dev/null -w "%{{http_code}}\\n" --proxy 127.0.0.1:{0} http://{1}:{2}/prefetch'.format(
+        ts.Variables.port, name, server.Variables.Port)
+
+
+def check_stats(tr, prefetches, rate_limited):
+    tr.Processes.Default.Command = 'traffic_ctl metric match hostdb.prefetch'
+    tr.Processes.Default.Env = ts.Env
+    tr.Processes.Default.ReturnCode = 0
+    tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+        "proxy.process.hostdb.prefetches {0}".format(prefetches), "{0} prefetches should have been made".format(prefetches))
+    tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+        "proxy.process.hostdb.prefetch_rate_limited {0}".format(rate_limited),
+        "{0} prefetches should have been rate limited".format(rate_limited))
+    tr.StillRunningAfter = ts
+
+
+# One lookup of cold.test, and a miss and 3 hits for each of the others.
+warm = [request('cold.test')]
+for name in ['hot.test', 'rate1.test', 'rate2.test', 'fail.test']:
+    warm += [request(name)] * 4
+
+tr = Test.AddTestRun("Use the records early in their TTL")
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(dns)
+tr.Processes.Default.StartBefore(ts, ready=When.PortOpen(ts.Variables.port))
+tr.Processes.Default.Command = ' && '.join(warm) + ' && sleep 2'
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("000|[3-5][0-9][0-9]", "Every request should succeed")
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("No record is prefetched before ttl_pct of its TTL")
+check_stats(tr, 0, 0)
+
+tr = Test.AddTestRun("Past ttl_pct only the record with enough hits is prefetched")
+tr.Processes.Default.Command = 'sleep 18 && {0} && {1} && sleep 2'.format(request('cold.test'), request('hot.test'))
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("000|[3-5][0-9][0-9]", "Every request should succeed")
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Check the prefetch")
+check_stats(tr, 1, 0)
+
+# Only one prefetch is allowed each second. The record that is rate limited starts counting hits
+# again, so the next lookup of it does not try again.
+tr = Test.AddTestRun("Prefetches beyond the rate limit are put off")
+tr.Processes.Default.Command = '{0} && {1} && sleep 1.5 && {1} && sleep 2'.format(request('rate1.test'), request('rate2.test'))
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("000|[3-5][0-9][0-9]", "Every request should succeed")
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Check the rate limit")
+check_stats(tr, 2, 1)
+
+# With the name server gone the prefetch fails, and the old record is used until it times out.
+tr = Test.AddTestRun("A failed prefetch keeps the old record")
+tr.Processes.Default.Command = 'pkill -f "microdns 127.0.0.1 {0} " ; {1} && sleep 4 && {1} && sleep 2'.format(
+    dns.Variables.Port, request('fail.test'))
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("000|[3-5][0-9][0-9]", "Every request should succeed")
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Check the failed prefetch")
+check_stats(tr, 3, 1)
+
+ts.Disk.traffic_out.Content = Testers.ContainsExpression("prefetching hot.test", "hot.test should be prefetched")
+ts.Disk.traffic_out.Content += Testers.ExcludesExpression("prefetching cold.test", "cold.test has too few hits")
+ts.Disk.traffic_out.Content += Testers.ContainsExpression("prefetching rate1.test", "rate1.test should be prefetched")
+ts.Disk.traffic_out.Content += Testers.ExcludesExpression("prefetching rate2.test", "rate2.test should be rate limited")
+ts.Disk.traffic_out.Content += Testers.ContainsExpression("prefetch failed for fail.test, keeping the old record",
+                                                          "The failed prefetch should keep the old record")
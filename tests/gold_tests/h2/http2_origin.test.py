@@ -0,0 +1,104 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import os
+
+Test.Summary = '''
+Test HTTP/2 to origin servers, the fallback to HTTP/1.1 and reuse of HTTP/2 connections
+'''
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl need to be installed on system for this test to work"),
+    Condition.HasProgram("nghttpd", "nghttpd need to be installed on system for this test to work"),
+)
+
+# An origin that only speaks HTTP/2, and one that offers no ALPN at all.
+h2_port = 4460
+htdocs = os.path.join(Test.RunDirectory, 'htdocs')
+h2origin = Test.Processes.Process("h2origin",
+                                  "mkdir -p {0} && echo hello > {0}/hello.txt && nghttpd -d {0} {1} {2} {3}".format(
+                                      htdocs, h2_port, os.path.join(Test.TestDirectory, 'ssl', 'server.key'),
+                                      os.path.join(Test.TestDirectory, 'ssl', 'server.pem')))
+
+server = Test.MakeOriginServer("server", ssl=True)
+request_header = {"headers": "GET /hello.txt HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 6\r\n\r\n",
+                   "timestamp": "1469733493.993", "body": "hello\n"}
+server.addResponse("sessionlog.json", request_header, response_header)
+
+ts = Test.MakeATSProcess("ts")
+ts.Disk.remap_config.AddLines([
+    'map /h2/ https://127.0.0.1:{0}/'.format(h2_port),
+    'map /h1/ https://127.0.0.1:{0}/'.format(server.Variables.SSL_Port),
+    'map /limit/ https://localhost:{0}/ @plugin=conf_remap.so @pparam=proxy.config.http2.max_concurrent_streams_out=7'.format(
+        h2_port),
+])
+ts.Disk.records_config.update({
+    'proxy.config.http2.enabled_out': 1,
+    'proxy.config.http.cache.http': 0,
+    'proxy.config.ssl.client.verify.server': 0,
+    'proxy.config.exec_thread.autoconfig': 0,
+    'proxy.config.exec_thread.limit': 1,
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'http2_ss|http_ss',
+})
+
+curl = 'curl -s -o /dev/null -w "%{{http_code}}\\n" http://127.0.0.1:{0}'.format(ts.Variables.port)
+
+# One thread serves every transaction, so all three requests share the connection the first one opens.
+tr = Test.AddTestRun("Requests over HTTP/2 to the origin")
+tr.Processes.Default.Command = '{0}/h2/hello.txt && {0}/h2/hello.txt && {0}/h2/hello.txt'.format(curl)
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.StartBefore(h2origin, ready=When.PortOpen(h2_port))
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(Test.Processes.ts)
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("200\n200\n200", "The origin answers every request")
+tr.StillRunningAfter = h2origin
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Fall back to HTTP/1.1 when the origin does not select h2")
+tr.Processes.Default.Command = '{0}/h1/hello.txt'.format(curl)
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("200", "The origin answers over HTTP/1.1")
+tr.StillRunningAfter = h2origin
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("A remap rule sets the stream limit of the connections it opens")
+tr.Processes.Default.Command = '{0}/limit/hello.txt && sleep 2'.format(curl)
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("200", "The origin answers the request")
+tr.StillRunningAfter = h2origin
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+# Two connections, one per origin host name, carried the four HTTP/2 requests.
+tr = Test.AddTestRun("Check the HTTP/2 server stats")
+tr.Processes.Default.Command = 'traffic_ctl metric match http2.total_server'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("total_server_connections 2", "Connections are reused")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression("total_server_streams 4",
+                                                                  "Only the HTTP/2 requests open streams")
+tr.StillRunningAfter = ts
+
+ts.Disk.traffic_out.Content = Testers.ContainsExpression("session born, netvc .*, max streams 100",
+                                                         "The default stream limit applies")
+ts.Disk.traffic_out.Content += Testers.ContainsExpression("session born, netvc .*, max streams 7",
+                                                          "The remap rule overrides the stream limit")
@@ -0,0 +1,91 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = 'Test that an origin with an unreachable IPv6 address is reached over IPv4 without waiting out the connect timeout'
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl needs to be installed on system for this test to work"),
+)
+
+ts = Test.MakeATSProcess("ts")
+server = Test.MakeOriginServer("server")
+dns = Test.MakeDNServer("dns", ip='127.0.0.1')
+# 100::1 is in the discard only prefix (RFC 6666), nothing answers there.
+# Nothing listens on ::1, so the connect there is refused, but only after it was started.
+dns.addRecords(records={"origin.test": ["100::1", "127.0.0.1"], "refused.test": ["::1", "127.0.0.1"]})
+
+request_header = {"headers": "GET /race HTTP/1.1\r\nHost: origin.test\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n",
+                   "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionfile.log", request_header, response_header)
+request_header = {"headers": "GET /refused HTTP/1.1\r\nHost: refused.test\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionfile.log", request_header, response_header)
+
+ts.Disk.remap_config.AddLines([
+    'map http://refused.test/ http://refused.test:{0}/'.format(server.Variables.Port),
+    'map / http://origin.test:{0}/'.format(server.Variables.Port),
+])
+ts.Disk.records_config.update({
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'http_happy_eyeballs',
+    'proxy.config.dns.nameservers': '127.0.0.1:{0}'.format(dns.Variables.Port),
+    'proxy.config.dns.resolv_conf': 'NULL',
+    # Resolve IPv6 first, so the first attempt goes to the unreachable address.
+    'proxy.config.hostdb.ip_resolve': 'ipv6;ipv4',
+    'proxy.config.http.happy_eyeballs.enabled': 1,
+    'proxy.config.http.happy_eyeballs.attempt_delay': 100,
+    # Without the race the request would wait this long, far longer than curl does.
+    'proxy.config.http.connect_attempts_timeout': 30,
+    'proxy.config.http.connect_attempts_max_retries': 0,
+})
+
+tr = Test.AddTestRun("Request to an origin with an unreachable IPv6 address")
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(dns)
+tr.Processes.Default.StartBefore(ts, ready=When.PortOpen(ts.Variables.port))
+# Give the stats time to be published for the next run.
+tr.Processes.Default.Command = 'curl -s -o /dev/null -w "%{{http_code}}\\n" --max-time 5 http://127.0.0.1:{0}/race && sleep 2'.format(
+    ts.Variables.port)
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "200", "The request should succeed well within the connect timeout")
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Request to an origin whose IPv6 address refuses the connection")
+tr.Processes.Default.Command = ('curl -s -o /dev/null -w "%{{http_code}}\\n" --max-time 5 -H "Host: refused.test" '
+                                'http://127.0.0.1:{0}/refused && sleep 2').format(ts.Variables.port)
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "200", "The refused connection should not be handed to the transaction")
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Check the race stats")
+tr.Processes.Default.Command = 'traffic_ctl metric match happy_eyeballs'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "proxy.process.http.happy_eyeballs.races 2", "Two races should have been run")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.http.happy_eyeballs.ipv4_wins 2", "IPv4 should have won both")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.http.happy_eyeballs.ipv6_wins 0", "IPv6 should not have won")
+tr.StillRunningAfter = ts
+
+ts.Disk.traffic_out.Content = Testers.ContainsExpression("won after [2-9] attempts", "The second attempt should have won")
+ts.Disk.traffic_out.Content += Testers.ContainsExpression(r"for refused\.test to \[::1\]:[0-9]+ failed: -[0-9]+",
+                                                          "The refused IPv6 attempt should fail")
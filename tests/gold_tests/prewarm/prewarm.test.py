@@ -0,0 +1,89 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = 'Test that idle connections are kept open to an origin and used by later transactions'
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl needs to be installed on system for this test to work"),
+)
+
+ts = Test.MakeATSProcess("ts")
+server = Test.MakeOriginServer("server")
+
+# The origin closes every connection after its response, so a transaction that finds a pooled
+# connection can only have found a pre-warmed one.
+request_header = {"headers": "GET /warm HTTP/1.1\r\nHost: origin.test\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n",
+                   "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionfile.log", request_header, response_header)
+
+ts.Disk.remap_config.AddLine(
+    'map / http://127.0.0.1:{0}/'.format(server.Variables.Port)
+)
+ts.Disk.records_config.update({
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'http_prewarm',
+    'proxy.config.http.per_server.connection.prewarm': 2,
+    # Pre-warmed connections are opened on any thread, let every thread use them.
+    'proxy.config.http.server_session_sharing.pool': 'global',
+    'proxy.config.http.server_session_sharing.match': 'ip',
+})
+
+request_command = 'curl -s -o /dev/null -w "%{{http_code}}\\n" -H "Host: origin.test" http://127.0.0.1:{0}/warm && sleep 3'.format(
+    ts.Variables.port)
+
+tr = Test.AddTestRun("First request makes the origin a pre-warm destination")
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(ts, ready=When.PortOpen(ts.Variables.port))
+# Give the manager time to open the connections and the stats time to be published.
+tr.Processes.Default.Command = request_command
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("200", "The request should succeed")
+tr.StillRunningAfter = ts
+tr.StillRunningAfter = server
+
+tr = Test.AddTestRun("Check the connections were opened")
+tr.Processes.Default.Command = 'traffic_ctl metric match prewarm'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "proxy.process.http.prewarm.connections_opened 2", "Two idle connections should have been opened")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.http.prewarm.hits 0", "No transaction should have used one yet")
+tr.StillRunningAfter = ts
+tr.StillRunningAfter = server
+
+tr = Test.AddTestRun("Second request uses a pre-warmed connection")
+tr.Processes.Default.Command = request_command
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("200", "The request should succeed")
+tr.StillRunningAfter = ts
+tr.StillRunningAfter = server
+
+tr = Test.AddTestRun("Check the hit and the replacement connection")
+tr.Processes.Default.Command = 'traffic_ctl metric match prewarm'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "proxy.process.http.prewarm.hits 1", "The second request should have used a pre-warmed connection")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.http.prewarm.connections_opened 3", "The used connection should have been replaced")
+tr.StillRunningAfter = ts
+
+ts.Disk.traffic_out.Content = Testers.ContainsExpression("added destination 127.0.0.1, 2 idle connections",
+                                                         "The origin should become a destination")
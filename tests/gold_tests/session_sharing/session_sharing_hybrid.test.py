@@ -0,0 +1,67 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = 'Test that the hybrid session pool moves an idle origin session to the thread that needs it'
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl needs to be installed on system for this test to work"),
+)
+
+ts = Test.MakeATSProcess("ts")
+server = Test.MakeOriginServer("server")
+
+# The origin keeps its connections open, so each request after the first can reuse one.
+request_header = {"headers": "GET /hybrid HTTP/1.1\r\nHost: origin.test\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionfile.log", request_header, response_header)
+
+ts.Disk.remap_config.AddLine(
+    'map / http://127.0.0.1:{0}/'.format(server.Variables.Port)
+)
+ts.Disk.records_config.update({
+    'proxy.config.diags.debug.enabled': 1,
+    'proxy.config.diags.debug.tags': 'http_ss',
+    'proxy.config.http.server_session_sharing.pool': 'hybrid',
+    'proxy.config.http.server_session_sharing.match': 'ip',
+    # Client connections are handed to the net threads in turn, so consecutive requests run on
+    # different threads and find the idle session in the pool of the other one.
+    'proxy.config.exec_thread.autoconfig': 0,
+    'proxy.config.exec_thread.limit': 2,
+    'proxy.config.accept_threads': 1,
+})
+
+tr = Test.AddTestRun("Requests on alternating threads")
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(ts, ready=When.PortOpen(ts.Variables.port))
+request = 'curl -s -o /dev/null -w "%{{http_code}}\\n" -H "Host: origin.test" http://127.0.0.1:{0}/hybrid'.format(ts.Variables.port)
+tr.Processes.Default.Command = ' && '.join([request] * 4) + ' && sleep 2'
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("000|[3-5][0-9][0-9]", "Every request should succeed")
+tr.StillRunningAfter = ts
+tr.StillRunningAfter = server
+
+tr = Test.AddTestRun("Check the session migrations")
+tr.Processes.Default.Command = 'traffic_ctl metric get proxy.process.http.server_session_migrations'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "proxy.process.http.server_session_migrations [1-9]", "An idle session should have moved to another thread")
+tr.StillRunningAfter = ts
+
+ts.Disk.traffic_out.Content = Testers.ContainsExpression("taken from the pool of thread",
+                                                         "A session should have been taken from a sibling pool")
@@ -0,0 +1,76 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = '''
+Test TLS handshakes with the private key operations offloaded to crypto threads
+'''
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl need to be installed on system for this test to work"),
+    Condition.HasATSFeature('TS_USE_TLS_ASYNC'),
+)
+
+ts = Test.MakeATSProcess("ts", select_ports=False)
+server = Test.MakeOriginServer("server")
+
+request_header = {"headers": "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionlog.json", request_header, response_header)
+
+ts.addSSLfile("ssl/server.pem")
+ts.addSSLfile("ssl/server.key")
+
+ts.Variables.ssl_port = 4449
+ts.Disk.remap_config.AddLine(
+    'map / http://127.0.0.1:{0}'.format(server.Variables.Port)
+)
+ts.Disk.ssl_multicert_config.AddLine(
+    'dest_ip=* ssl_cert_name=server.pem ssl_key_name=server.key'
+)
+ts.Disk.records_config.update({
+    'proxy.config.ssl.server.cert.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.ssl.server.private_key.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.http.server_ports': '{0}:ssl'.format(ts.Variables.ssl_port),
+    'proxy.config.exec_thread.autoconfig.scale': 1.0,
+    'proxy.config.ssl.async.crypto.threads': 2,
+})
+
+# Each curl makes a full handshake, and each full handshake signs with the server key.
+tr = Test.AddTestRun("Handshakes complete with the key operations offloaded")
+tr.Processes.Default.Command = ' && '.join(
+    ['curl -s -k -o /dev/null -w "%{{http_code}}\\n" https://127.0.0.1:{0}/'.format(ts.Variables.ssl_port)] * 3) + ' && sleep 2'
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(Test.Processes.ts, ready=When.PortOpen(ts.Variables.ssl_port))
+tr.Processes.Default.Streams.stdout = Testers.ExcludesExpression("000|[3-5][0-9][0-9]", "Every request should succeed")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Check the offload stats")
+tr.Processes.Default.Command = ('traffic_ctl metric get proxy.process.ssl.async_crypto_offloaded '
+                                'proxy.process.ssl.total_success_handshake_count_in')
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "proxy.process.ssl.total_success_handshake_count_in 3", "Every handshake should succeed")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.ssl.async_crypto_offloaded ([3-9]|[1-9][0-9]+)", "Every handshake should offload its signature")
+tr.StillRunningAfter = ts
+
+ts.Disk.diags_log.Content = Testers.ContainsExpression("offloading TLS private key operations to 2 crypto threads",
+                                                       "The crypto threads should be started")
@@ -0,0 +1,91 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = '''
+Test that only the request sent as TLS early data is treated as early data
+'''
+
+Test.SkipUnless(
+    Condition.HasProgram("openssl", "Openssl need to be installed on system for this test to work"),
+    Condition.HasOpenSSLVersion("1.1.1")
+)
+
+ts = Test.MakeATSProcess("ts", select_ports=False)
+server = Test.MakeOriginServer("server")
+
+request_header = {"headers": "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionlog.json", request_header, response_header)
+request_header = {"headers": "GET /second HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n",
+                   "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionlog.json", request_header, response_header)
+
+ts.Variables.ssl_port = 4447
+ts.addSSLfile("ssl/server.pem")
+ts.addSSLfile("ssl/server.key")
+ts.Disk.remap_config.AddLine(
+    'map / http://127.0.0.1:{0}'.format(server.Variables.Port)
+)
+ts.Disk.ssl_multicert_config.AddLine(
+    'dest_ip=* ssl_cert_name=server.pem ssl_key_name=server.key'
+)
+# Early data is accepted but only for HEAD, so a GET that arrives as early data gets a 425.
+ts.Disk.records_config.update({
+    'proxy.config.ssl.server.cert.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.ssl.server.private_key.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.http.server_ports': '{0}:ssl'.format(ts.Variables.ssl_port),
+    'proxy.config.ssl.client.verify.server': 0,
+    'proxy.config.exec_thread.autoconfig.scale': 1.0,
+    'proxy.config.ssl.server.session_ticket.enable': 1,
+    'proxy.config.ssl.server.max_early_data': 16384,
+    'proxy.config.http.early_data_methods': 'HEAD',
+})
+
+tr = Test.AddTestRun("Create session")
+tr.Command = 'echo -e "GET / HTTP/1.0\r\n" | openssl s_client -tls1_3 -connect 127.0.0.1:{0} -sess_out session.out'.format(
+    ts.Variables.ssl_port)
+tr.ReturnCode = 0
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(Test.Processes.ts, ready=When.PortOpen(ts.Variables.ssl_port))
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("New, TLSv1.3", "A new session is established")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+# Resume with a request as early data, then send a second request on the same connection once the
+# handshake is done. Only the first one may be rejected as early data.
+tr = Test.AddTestRun("Early data then a second request")
+tr.Command = ("printf 'GET /early HTTP/1.1\\r\\nHost: www.example.com\\r\\n\\r\\n' > early.txt && "
+              "(sleep 1; printf 'GET /second HTTP/1.1\\r\\nHost: www.example.com\\r\\n\\r\\n'; sleep 1) | "
+              "openssl s_client -tls1_3 -connect 127.0.0.1:{0} -sess_in session.out -early_data early.txt -ign_eof").format(
+    ts.Variables.ssl_port)
+tr.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("Early data was accepted", "The server accepts the early data")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression("HTTP/1.1 425 Too Early",
+                                                                  "The early request is asked to retry")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression("HTTP/1.1 200 OK",
+                                                                  "The request after the handshake is not early data")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Only one request was rejected")
+tr.Processes.Default.Command = 'traffic_ctl metric get proxy.process.http.early_data_rejected'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("early_data_rejected 1", "Exactly one request was early data")
+tr.StillRunningAfter = ts
@@ -0,0 +1,99 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+Test.Summary = '''
+Test that certificates loaded on demand are built on first use and released least recently used first
+'''
+
+Test.SkipUnless(
+    Condition.HasProgram("curl", "Curl need to be installed on system for this test to work")
+)
+
+ts = Test.MakeATSProcess("ts", select_ports=False)
+server = Test.MakeOriginServer("server")
+
+request_header = {"headers": "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionlog.json", request_header, response_header)
+
+ts.addSSLfile("ssl/signed-foo.pem")
+ts.addSSLfile("ssl/signed-foo.key")
+ts.addSSLfile("ssl/signed-bar.pem")
+ts.addSSLfile("ssl/signed-bar.key")
+ts.addSSLfile("ssl/server.pem")
+ts.addSSLfile("ssl/server.key")
+
+ts.Variables.ssl_port = 4448
+ts.Disk.remap_config.AddLine(
+    'map / http://127.0.0.1:{0}'.format(server.Variables.Port)
+)
+# The foo.com and bar.com lines are only selected by name, so they are loaded on demand. The default is always built.
+ts.Disk.ssl_multicert_config.AddLines([
+    'ssl_cert_name=signed-foo.pem ssl_key_name=signed-foo.key',
+    'ssl_cert_name=signed-bar.pem ssl_key_name=signed-bar.key',
+    'dest_ip=* ssl_cert_name=server.pem ssl_key_name=server.key',
+])
+ts.Disk.records_config.update({
+    'proxy.config.ssl.server.cert.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.ssl.server.private_key.path': '{0}'.format(ts.Variables.SSLDir),
+    'proxy.config.http.server_ports': '{0}:ssl'.format(ts.Variables.ssl_port),
+    'proxy.config.exec_thread.autoconfig.scale': 1.0,
+    'proxy.config.ssl.server.multicert.lazy_load': 1,
+    # Only one context built on demand is kept, building another releases it.
+    'proxy.config.ssl.server.multicert.lazy_load.max_contexts': 1,
+})
+
+
+def request(name):
+    return "curl -v -k --resolve '{0}:{1}:127.0.0.1' https://{0}:{1}/".format(name, ts.Variables.ssl_port)
+
+
+tr = Test.AddTestRun("foo.com is built on first use")
+tr.Processes.Default.Command = request('foo.com')
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(Test.Processes.ts, ready=When.PortOpen(ts.Variables.ssl_port))
+tr.Processes.Default.Streams.All = Testers.ContainsExpression("CN=foo.com", "The foo.com certificate is served")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("bar.com is built and foo.com released")
+tr.Processes.Default.Command = request('bar.com')
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.All = Testers.ContainsExpression("CN=bar.com", "The bar.com certificate is served")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("foo.com is built again and bar.com released")
+tr.Processes.Default.Command = request('foo.com') + ' && sleep 2'
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.All = Testers.ContainsExpression("CN=foo.com", "The foo.com certificate is served")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+tr = Test.AddTestRun("Check the lazy context stats")
+tr.Processes.Default.Command = 'traffic_ctl metric match lazy_context'
+tr.Processes.Default.Env = ts.Env
+tr.Processes.Default.ReturnCode = 0
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression(
+    "proxy.process.ssl.lazy_context_build 3", "Every request after an eviction builds its context")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.ssl.lazy_context_eviction 2", "Each build past the first releases the other context")
+tr.Processes.Default.Streams.stdout += Testers.ContainsExpression(
+    "proxy.process.ssl.lazy_context_build_failure 0", "Every context is built")
+tr.StillRunningAfter = ts
@@ -0,0 +1,83 @@
+'''
+'''
+#  Licensed to the Apache Software Foundation (ASF) under one
+#  or more contributor license agreements.  See the NOTICE file
+#  distributed with this work for additional information
+#  regarding copyright ownership.  The ASF licenses this file
+#  to you under the Apache License, Version 2.0 (the
+#  "License"); you may not use this file except in compliance
+#  with the License.  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+import os
+Test.Summary = '''
+Test that the SSL session cache is saved to disk and loaded by the next traffic_server
+'''
+
+Test.SkipUnless(
+    Condition.HasProgram("openssl", "Openssl need to be installed on system for this test to work")
+)
+
+# ts writes its session cache, ts2 stands in for ts after a restart and reads it.
+ts = Test.MakeATSProcess("ts", select_ports=False)
+ts2 = Test.MakeATSProcess("ts2", select_ports=False)
+server = Test.MakeOriginServer("server")
+
+request_header = {"headers": "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+response_header = {"headers": "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n", "timestamp": "1469733493.993", "body": ""}
+server.addResponse("sessionlog.json", request_header, response_header)
+
+session_cache_file = os.path.join(Test.RunDirectory, 'ssl_session_cache.db')
+
+ts.Variables.ssl_port = 4445
+ts2.Variables.ssl_port = 4446
+
+for proc, sync_frequency in ((ts, 1), (ts2, 3600)):
+    proc.addSSLfile("ssl/server.pem")
+    proc.addSSLfile("ssl/server.key")
+    proc.Disk.remap_config.AddLine(
+        'map / http://127.0.0.1:{0}'.format(server.Variables.Port)
+    )
+    proc.Disk.ssl_multicert_config.AddLine(
+        'dest_ip=* ssl_cert_name=server.pem ssl_key_name=server.key'
+    )
+    proc.Disk.records_config.update({
+        'proxy.config.ssl.server.cert.path': '{0}'.format(proc.Variables.SSLDir),
+        'proxy.config.ssl.server.private_key.path': '{0}'.format(proc.Variables.SSLDir),
+        'proxy.config.http.server_ports': '{0}:ssl'.format(proc.Variables.ssl_port),
+        'proxy.config.ssl.client.verify.server': 0,
+        'proxy.config.exec_thread.autoconfig.scale': 1.0,
+        'proxy.config.ssl.server.session_ticket.enable': 0,
+        'proxy.config.ssl.session_cache': 2,
+        'proxy.config.ssl.session_cache.sync_frequency': sync_frequency,
+        'proxy.config.ssl.session_cache.sync_filename': session_cache_file,
+    })
+
+# Establish a session with ts, then give it time to save its cache.
+tr = Test.AddTestRun("Create session")
+tr.Command = 'echo -e "GET / HTTP/1.0\r\n" | openssl s_client -tls1_2 -no_ticket -connect 127.0.0.1:{0} -sess_out session.out && sleep 3'.format(
+    ts.Variables.ssl_port)
+tr.ReturnCode = 0
+tr.Processes.Default.StartBefore(server)
+tr.Processes.Default.StartBefore(Test.Processes.ts, ready=When.PortOpen(ts.Variables.ssl_port))
+tr.Processes.Default.Streams.stdout = Testers.ContainsExpression("New, TLSv1.2", "A new session is established")
+tr.StillRunningAfter = server
+tr.StillRunningAfter = ts
+
+# Resume it with ts2, which has only the saved cache to go on. The cache is loaded in the background.
+tr2 = Test.AddTestRun("Resume session")
+tr2.Command = 'sleep 1 && echo -e "GET / HTTP/1.0\r\n" | openssl s_client -tls1_2 -no_ticket -connect 127.0.0.1:{0} -sess_in session.out'.format(
+    ts2.Variables.ssl_port)
+tr2.ReturnCode = 0
+tr2.Processes.Default.StartBefore(Test.Processes.ts2, ready=When.PortOpen(ts2.Variables.ssl_port))
+tr2.Processes.Default.Streams.stdout = Testers.ContainsExpression("Reused, TLSv1.2", "The session is resumed from the saved cache")
+tr2.StillRunningAfter = server
+
+ts2.Disk.diags_log.Content += Testers.ContainsExpression("loaded [1-9][0-9]* SSL sessions", "The session cache is loaded")